@@ -0,0 +1,166 @@
+#include "booking.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+#define ROW_MAX 128
+
+static const char boardHeader[] =
+    "\nAvailable Buses:\n"
+    "-------------------------------------------------\n";
+
+struct BoardCache {
+    char currency[8];
+    char (*rows)[ROW_MAX];      // pre-formatted line per bus
+    int* rowLength;
+    int* rowOffset;             // where each line starts in text
+    int rowCount;               // buses rendered so far
+    int rowCapacity;
+    int* dirtyList;             // buses whose seat count changed since the last render
+    unsigned char* dirtyFlag;
+    int dirtyCount;
+    int relayout;               // line lengths changed or buses were added
+    char* text;                 // header + all lines, ready for one write()
+    int textLength;
+    int textCapacity;
+};
+
+void freeBoardCache(struct BoardCache* board) {
+    if (!board) return;
+    free(board->rows);
+    free(board->rowLength);
+    free(board->rowOffset);
+    free(board->dirtyList);
+    free(board->dirtyFlag);
+    free(board->text);
+    free(board);
+}
+
+static int reserveRows(struct BoardCache* board, int count) {
+    if (count <= board->rowCapacity) return 1;
+    int capacity = board->rowCapacity ? board->rowCapacity : 16;
+    while (capacity < count) capacity *= 2;
+
+    char (*rows)[ROW_MAX] = (char (*)[ROW_MAX])realloc(board->rows, sizeof(*rows) * capacity);
+    if (rows) board->rows = rows;
+    int* rowLength = (int*)realloc(board->rowLength, sizeof(int) * capacity);
+    if (rowLength) board->rowLength = rowLength;
+    int* rowOffset = (int*)realloc(board->rowOffset, sizeof(int) * capacity);
+    if (rowOffset) board->rowOffset = rowOffset;
+    int* dirtyList = (int*)realloc(board->dirtyList, sizeof(int) * capacity);
+    if (dirtyList) board->dirtyList = dirtyList;
+    unsigned char* dirtyFlag = (unsigned char*)realloc(board->dirtyFlag, capacity);
+    if (dirtyFlag) board->dirtyFlag = dirtyFlag;
+    if (!rows || !rowLength || !rowOffset || !dirtyList || !dirtyFlag) return 0;
+
+    memset(board->dirtyFlag + board->rowCapacity, 0, capacity - board->rowCapacity);
+    board->rowCapacity = capacity;
+    return 1;
+}
+
+static int renderRow(const struct BoardCache* board, const Bus* bus, char* out) {
+    int n = snprintf(out, ROW_MAX, "Route: %d\tDeparture: %s\tSeats: %d\tFare: %s%.2f\n",
+                     bus->routeNumber, bus->departureTime, bus->availableSeats, board->currency, bus->fare);
+    return n < ROW_MAX ? n : ROW_MAX - 1;
+}
+
+int enableBoardCache(BookingSystem* system, const char* currency) {
+    if (system->board) return 1;
+    struct BoardCache* board = (struct BoardCache*)calloc(1, sizeof(struct BoardCache));
+    if (!board) return 0;
+    snprintf(board->currency, sizeof(board->currency), "%s", currency);
+    board->relayout = 1;
+    system->board = board;
+    return 1;
+}
+
+void markBusDirty(BookingSystem* system, const Bus* bus) {
+    struct BoardCache* board = system->board;
+    if (!board || bus < system->buses || bus >= system->buses + system->busCount) return;
+
+    int i = (int)(bus - system->buses);
+    if (i >= board->rowCount) {
+        board->relayout = 1;    // new bus, picked up by the next full render
+        return;
+    }
+    if (!board->dirtyFlag[i]) {
+        board->dirtyFlag[i] = 1;
+        board->dirtyList[board->dirtyCount++] = i;
+    }
+}
+
+static int renderAll(BookingSystem* system) {
+    struct BoardCache* board = system->board;
+    if (!reserveRows(board, system->busCount)) return 0;
+    for (int i = board->rowCount; i < system->busCount; i++)
+        board->rowLength[i] = renderRow(board, &system->buses[i], board->rows[i]);
+    board->rowCount = system->busCount;
+
+    int length = (int)sizeof(boardHeader) - 1;
+    for (int i = 0; i < board->rowCount; i++) length += board->rowLength[i];
+    if (length > board->textCapacity) {
+        char* text = (char*)realloc(board->text, length);
+        if (!text) return 0;
+        board->text = text;
+        board->textCapacity = length;
+    }
+
+    memcpy(board->text, boardHeader, sizeof(boardHeader) - 1);
+    int offset = (int)sizeof(boardHeader) - 1;
+    for (int i = 0; i < board->rowCount; i++) {
+        board->rowOffset[i] = offset;
+        memcpy(board->text + offset, board->rows[i], board->rowLength[i]);
+        offset += board->rowLength[i];
+    }
+    board->textLength = offset;
+    board->relayout = 0;
+    return 1;
+}
+
+const char* renderAvailableBuses(BookingSystem* system, int* length) {
+    struct BoardCache* board = system->board;
+    if (!board) return NULL;
+
+    // Re-format only the lines whose seat count changed. A line that keeps
+    // its length is patched in place; otherwise the text is re-assembled.
+    for (int d = 0; d < board->dirtyCount; d++) {
+        int i = board->dirtyList[d];
+        board->dirtyFlag[i] = 0;
+        int n = renderRow(board, &system->buses[i], board->rows[i]);
+        if (n != board->rowLength[i]) {
+            board->relayout = 1;
+        } else if (!board->relayout) {
+            memcpy(board->text + board->rowOffset[i], board->rows[i], n);
+        }
+        board->rowLength[i] = n;
+    }
+    board->dirtyCount = 0;
+
+    if (board->relayout && !renderAll(system)) return NULL;
+    *length = board->textLength;
+    return board->text;
+}
+
+int writeAvailableBuses(BookingSystem* system, int fd) {
+    int length;
+    const char* text = renderAvailableBuses(system, &length);
+    if (!text) return 0;
+    fflush(stdout);     // keep ordering with any buffered printf output
+    // write() may stop short on a pipe or terminal; keep going until it's all out
+    while (length > 0) {
+        int n = (int)write(fd, text, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        text += n;
+        length -= n;
+    }
+    return 1;
+}
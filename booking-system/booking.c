@@ -0,0 +1,216 @@
+#include "booking.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUSES 16
+#define INITIAL_TICKETS 64
+
+void freeBoardCache(struct BoardCache* board);  // board.c
+
+// Route index helpers: power-of-two table, linear probing, kept at most half full
+static unsigned hashRoute(int route) {
+    return (unsigned)route * 2654435761u;
+}
+
+static int rebuildRouteIndex(BookingSystem* system, int slots) {
+    int* index = (int*)malloc(sizeof(int) * slots);
+    if (!index) return 0;
+    for (int i = 0; i < slots; i++) index[i] = -1;
+
+    int mask = slots - 1;
+    for (int b = 0; b < system->busCount; b++) {
+        unsigned h = hashRoute(system->buses[b].routeNumber) & mask;
+        while (index[h] != -1) h = (h + 1) & mask;
+        index[h] = b;
+    }
+    free(system->routeIndex);
+    system->routeIndex = index;
+    system->routeIndexMask = mask;
+    return 1;
+}
+
+int initBookingSystem(BookingSystem* system) {
+    memset(system, 0, sizeof(*system));
+    system->nextBookingID = 1000;
+    system->buses = (Bus*)malloc(sizeof(Bus) * INITIAL_BUSES);
+    system->tickets = (Ticket*)malloc(sizeof(Ticket) * INITIAL_TICKETS);
+    if (!system->buses || !system->tickets || !rebuildRouteIndex(system, INITIAL_BUSES * 2)) {
+        freeBookingSystem(system);
+        return 0;
+    }
+    system->busCapacity = INITIAL_BUSES;
+    system->ticketCapacity = INITIAL_TICKETS;
+    return 1;
+}
+
+void freeBookingSystem(BookingSystem* system) {
+    free(system->buses);
+    free(system->tickets);
+    free(system->routeIndex);
+    freeBoardCache(system->board);
+    memset(system, 0, sizeof(*system));
+}
+
+void initBus(Bus* bus, int route, const char* time, int seats, double price) {
+    bus->routeNumber = route;
+    snprintf(bus->departureTime, sizeof(bus->departureTime), "%s", time);
+    bus->totalSeats = seats;
+    bus->availableSeats = seats;
+    bus->fare = price;
+}
+
+Bus* addBus(BookingSystem* system, int route, const char* time, int seats, double price) {
+    if (findBus(system, route)) return NULL;
+
+    if (system->busCount == system->busCapacity) {
+        int capacity = system->busCapacity * 2;
+        Bus* buses = (Bus*)realloc(system->buses, sizeof(Bus) * capacity);
+        if (!buses) return NULL;
+        system->buses = buses;
+        system->busCapacity = capacity;
+    }
+    if ((system->busCount + 1) * 2 > system->routeIndexMask + 1 &&
+        !rebuildRouteIndex(system, (system->routeIndexMask + 1) * 2)) {
+        return NULL;
+    }
+
+    Bus* bus = &system->buses[system->busCount];
+    initBus(bus, route, time, seats, price);
+
+    unsigned h = hashRoute(route) & system->routeIndexMask;
+    while (system->routeIndex[h] != -1) h = (h + 1) & system->routeIndexMask;
+    system->routeIndex[h] = system->busCount++;
+    markBusDirty(system, bus);
+    return bus;
+}
+
+Bus* findBus(BookingSystem* system, int routeNumber) {
+    unsigned h = hashRoute(routeNumber) & system->routeIndexMask;
+    for (int slot; (slot = system->routeIndex[h]) != -1; h = (h + 1) & system->routeIndexMask) {
+        if (system->buses[slot].routeNumber == routeNumber) return &system->buses[slot];
+    }
+    return NULL;
+}
+
+void initializeSampleBuses(BookingSystem* system) {
+    addBus(system, 101, "08:00 AM", 50, 5.50);
+    addBus(system, 102, "09:30 AM", 40, 6.25);
+    addBus(system, 103, "11:15 AM", 35, 7.00);
+}
+
+int bookSeats(Bus* bus, int numSeats) {
+    if (bus->availableSeats >= numSeats) {
+        bus->availableSeats -= numSeats;
+        return 1;
+    }
+    return 0;
+}
+
+void cancelSeats(Bus* bus, int numSeats) {
+    bus->availableSeats = (bus->availableSeats + numSeats > bus->totalSeats)
+        ? bus->totalSeats : bus->availableSeats + numSeats;
+}
+
+void initTicket(Ticket* ticket, const char* name, int route, int seats, const char* id, double fare) {
+    snprintf(ticket->passengerName, sizeof(ticket->passengerName), "%s", name);
+    ticket->routeNumber = route;
+    ticket->numSeats = seats;
+    snprintf(ticket->bookingID, sizeof(ticket->bookingID), "%s", id);
+    ticket->totalFare = fare * seats;
+}
+
+void generateBookingID(BookingSystem* system, char* id) {
+    snprintf(id, MAX_ID_LENGTH, "BID%d", system->nextBookingID++);
+}
+
+Ticket* issueTicket(BookingSystem* system, Bus* bus, const char* name, int numSeats) {
+    // IDs must keep increasing for findTicket's binary search
+    if (system->nextBookingID == INT_MAX) return NULL;
+    if (system->ticketCount == system->ticketCapacity) {
+        int capacity = system->ticketCapacity * 2;
+        Ticket* tickets = (Ticket*)realloc(system->tickets, sizeof(Ticket) * capacity);
+        if (!tickets) return NULL;
+        system->tickets = tickets;
+        system->ticketCapacity = capacity;
+    }
+    if (!bookSeats(bus, numSeats)) return NULL;
+    markBusDirty(system, bus);
+
+    char bookingID[MAX_ID_LENGTH];
+    generateBookingID(system, bookingID);
+    Ticket* ticket = &system->tickets[system->ticketCount++];
+    initTicket(ticket, name, bus->routeNumber, numSeats, bookingID, bus->fare);
+    return ticket;
+}
+
+// Booking IDs are "BID<n>" with n strictly increasing, and tickets are only
+// ever appended or removed in place, so the array stays sorted by n.
+static long bookingNumber(const char* bookingID) {
+    if (strncmp(bookingID, "BID", 3) != 0) return -1;
+    char* end;
+    long n = strtol(bookingID + 3, &end, 10);
+    return (end == bookingID + 3 || *end) ? -1 : n;
+}
+
+Ticket* findTicket(BookingSystem* system, const char* bookingID) {
+    long wanted = bookingNumber(bookingID);
+    if (wanted < 0) return NULL;
+
+    int lo = 0, hi = system->ticketCount - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        long n = bookingNumber(system->tickets[mid].bookingID);
+        if (n == wanted) return &system->tickets[mid];
+        if (n < wanted) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+int cancelBooking(BookingSystem* system, const char* bookingID) {
+    Ticket* ticket = findTicket(system, bookingID);
+    if (!ticket) return 0;
+    Bus* bus = findBus(system, ticket->routeNumber);
+    if (!bus) return 0;
+
+    cancelSeats(bus, ticket->numSeats);
+    markBusDirty(system, bus);
+    removeTicket(system, ticket);
+    return 1;
+}
+
+void removeTicket(BookingSystem* system, Ticket* ticket) {
+    // Shift remaining tickets
+    int i = (int)(ticket - system->tickets);
+    memmove(ticket, ticket + 1, sizeof(Ticket) * (system->ticketCount - i - 1));
+    system->ticketCount--;
+}
+
+void displayTicket(const Ticket* ticket, const char* currency) {
+    printf("\n--- Ticket Details ---\n");
+    printf("Booking ID: %s\n", ticket->bookingID);
+    printf("Passenger: %s\n", ticket->passengerName);
+    printf("Route: %d\n", ticket->routeNumber);
+    printf("Seats: %d\n", ticket->numSeats);
+    printf("Total Fare: %s%.2f\n", currency, ticket->totalFare);
+}
+
+void displayBuses(const Bus* buses, int count, const char* currency) {
+    printf("\nAvailable Buses:\n");
+    printf("-------------------------------------------------\n");
+    for (int i = 0; i < count; i++) {
+        printf("Route: %d\tDeparture: %s\tSeats: %d\tFare: %s%.2f\n",
+               buses[i].routeNumber,
+               buses[i].departureTime,
+               buses[i].availableSeats,
+               currency,
+               buses[i].fare);
+    }
+}
+
+void displayAvailableBuses(const BookingSystem* system, const char* currency) {
+    displayBuses(system->buses, system->busCount, currency);
+}
@@ -0,0 +1,89 @@
+#ifndef BOOKING_H
+#define BOOKING_H
+
+// Shared booking core (libbooking). Plain C ABI so both the .c and .cpp
+// front-ends link against the same object code.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_NAME_LENGTH 50
+#define MAX_ID_LENGTH 16        // "BID" + any non-negative int + NUL
+#define MAX_TIME_LENGTH 10
+
+typedef struct {
+    int routeNumber;
+    char departureTime[MAX_TIME_LENGTH];
+    int totalSeats;
+    int availableSeats;
+    double fare;
+} Bus;
+
+typedef struct {
+    char passengerName[MAX_NAME_LENGTH];
+    int routeNumber;
+    int numSeats;
+    char bookingID[MAX_ID_LENGTH];
+    double totalFare;
+} Ticket;
+
+struct BoardCache;
+
+typedef struct {
+    Bus* buses;
+    int busCount;
+    int busCapacity;
+    Ticket* tickets;            // kept in booking-ID order (IDs are issued sequentially)
+    int ticketCount;
+    int ticketCapacity;
+    int nextBookingID;
+    int* routeIndex;            // open-addressing route -> bus slot, -1 = empty
+    int routeIndexMask;
+    struct BoardCache* board;   // optional pre-rendered availability listing
+} BookingSystem;
+
+// Lifetime. initBookingSystem() returns 0 if memory could not be allocated.
+int initBookingSystem(BookingSystem* system);
+void freeBookingSystem(BookingSystem* system);
+
+// Fleet. addBus() returns NULL for a duplicate route or on allocation failure.
+void initBus(Bus* bus, int route, const char* time, int seats, double price);
+Bus* addBus(BookingSystem* system, int route, const char* time, int seats, double price);
+Bus* findBus(BookingSystem* system, int routeNumber);
+void initializeSampleBuses(BookingSystem* system);
+
+// Seats
+int bookSeats(Bus* bus, int numSeats);
+void cancelSeats(Bus* bus, int numSeats);
+
+// Tickets. issueTicket() books the seats and records the ticket; it returns
+// NULL if the bus is short of seats. cancelBooking() returns 1 on success.
+void initTicket(Ticket* ticket, const char* name, int route, int seats, const char* id, double fare);
+void generateBookingID(BookingSystem* system, char* id);
+Ticket* issueTicket(BookingSystem* system, Bus* bus, const char* name, int numSeats);
+Ticket* findTicket(BookingSystem* system, const char* bookingID);
+int cancelBooking(BookingSystem* system, const char* bookingID);
+void removeTicket(BookingSystem* system, Ticket* ticket);
+
+// Output. currency is printed in front of every fare, e.g. "$" or "Ksh".
+void displayTicket(const Ticket* ticket, const char* currency);
+void displayBuses(const Bus* buses, int count, const char* currency);
+void displayAvailableBuses(const BookingSystem* system, const char* currency);
+
+// Departure board. Once enabled, every bus keeps a pre-formatted line; seat
+// changes made through issueTicket()/cancelBooking() (or reported with
+// markBusDirty()) re-render only that line, and writeAvailableBuses() emits
+// the whole listing with a single write(). Returns 0 on allocation failure.
+// writeAvailableBuses() returns 1 once every byte is written, 0 if the board
+// could not be rendered (nothing was written) and -1 if the write failed.
+int enableBoardCache(BookingSystem* system, const char* currency);
+void markBusDirty(BookingSystem* system, const Bus* bus);
+const char* renderAvailableBuses(BookingSystem* system, int* length);
+int writeAvailableBuses(BookingSystem* system, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOKING_H
@@ -0,0 +1,42 @@
+#ifndef BOOKING_HPP
+#define BOOKING_HPP
+
+// Optional header-only C++ wrapper over the libbooking C API.
+
+#include "booking.h"
+
+#include <new>
+
+namespace booking {
+
+class System {
+private:
+    BookingSystem sys;
+
+public:
+    System() {
+        if (!initBookingSystem(&sys)) throw std::bad_alloc();
+    }
+    ~System() { freeBookingSystem(&sys); }
+
+    System(const System&) = delete;
+    System& operator=(const System&) = delete;
+
+    Bus* addBus(int route, const char* time, int seats, double fare) { return ::addBus(&sys, route, time, seats, fare); }
+    Bus* findBus(int route) { return ::findBus(&sys, route); }
+    void loadSampleBuses() { initializeSampleBuses(&sys); }
+
+    Ticket* book(Bus* bus, const char* name, int seats) { return issueTicket(&sys, bus, name, seats); }
+    Ticket* findTicket(const char* bookingID) { return ::findTicket(&sys, bookingID); }
+    bool cancel(const char* bookingID) { return cancelBooking(&sys, bookingID) != 0; }
+
+    void showBuses(const char* currency) const { displayAvailableBuses(&sys, currency); }
+
+    int busCount() const { return sys.busCount; }
+    int ticketCount() const { return sys.ticketCount; }
+    BookingSystem* raw() { return &sys; }
+};
+
+} // namespace booking
+
+#endif // BOOKING_HPP
@@ -0,0 +1,78 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "booking.h"
+
+// Micro-benchmark for the shared booking core. Usage: booking_bench [routes] [lookups]
+
+static double secondsSince(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char** argv) {
+    int routes = argc > 1 ? atoi(argv[1]) : 5000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000L;
+
+    BookingSystem system;
+    if (!initBookingSystem(&system)) return 1;
+
+    clock_t start = clock();
+    for (int i = 0; i < routes; i++) addBus(&system, 100 + i * 7, "08:00 AM", 50, 5.50);
+    printf("addBus:        %d routes in %.3f ms\n", routes, secondsSince(start) * 1e3);
+
+    long found = 0;
+    start = clock();
+    for (long i = 0; i < lookups; i++) {
+        if (findBus(&system, 100 + (int)(i % routes) * 7)) found++;
+    }
+    double t = secondsSince(start);
+    printf("findBus:       %ld lookups, %.1f ns/lookup (%ld hits)\n", lookups, t * 1e9 / lookups, found);
+
+    int bookings = routes * 10;
+    start = clock();
+    for (int i = 0; i < bookings; i++) issueTicket(&system, &system.buses[i % routes], "Passenger", 1);
+    printf("issueTicket:   %d tickets in %.3f ms\n", bookings, secondsSince(start) * 1e3);
+
+    char id[16];
+    int cancelled = 0;
+    start = clock();
+    for (int i = 0; i < bookings; i += 10) {
+        snprintf(id, sizeof(id), "BID%d", 1000 + i);
+        cancelled += cancelBooking(&system, id);
+    }
+    printf("cancelBooking: %d cancellations in %.3f ms\n", cancelled, secondsSince(start) * 1e3);
+
+    // Departure board: printf listing vs the render cache, one seat change per refresh
+    int refreshes = 200;
+    int devnull = open("/dev/null", O_WRONLY);
+    int savedStdout = dup(1);
+    fflush(stdout);
+    dup2(devnull, 1);
+    start = clock();
+    for (int i = 0; i < refreshes; i++) {
+        bookSeats(&system.buses[i % routes], 1);
+        displayAvailableBuses(&system, "$");
+    }
+    fflush(stdout);
+    double printfTime = secondsSince(start);
+    dup2(savedStdout, 1);
+
+    enableBoardCache(&system, "$");
+    writeAvailableBuses(&system, devnull);
+    start = clock();
+    for (int i = 0; i < refreshes; i++) {
+        issueTicket(&system, &system.buses[i % routes], "Passenger", 1);
+        writeAvailableBuses(&system, devnull);
+    }
+    double cachedTime = secondsSince(start);
+    printf("board refresh: %d routes, printf %.1f us, cached %.1f us (%.0fx)\n", routes,
+           printfTime * 1e6 / refreshes, cachedTime * 1e6 / refreshes, printfTime / cachedTime);
+    close(devnull);
+    close(savedStdout);
+
+    freeBookingSystem(&system);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <spawn.h>
+#include <sys/wait.h>
+#define FLEET_BENCH_SPAWN 1
+#endif
+
+#include "kiosk_fleet.hpp"
+
+// Compares the compile-time fleet against the dynamic BookingSystem fleet:
+// startup cost and route lookup cost. Startup is the kiosk's own fleet set up
+// the way main.cpp does in each build, up to the first lookup. It is timed in
+// process and, where processes can be spawned, end to end: the bench re-runs
+// itself as a child that sets up one configuration, looks up one route and
+// exits. Usage: fleet_bench [lookups]
+
+namespace {
+
+constexpr std::size_t kRoutes = 256;
+constexpr int kStartups = 10000;
+constexpr int kProcesses = 200;
+
+constexpr std::array<booking::RouteSpec, kRoutes> makeFleet() {
+    std::array<booking::RouteSpec, kRoutes> fleet{};
+    for (std::size_t i = 0; i < kRoutes; i++)
+        fleet[i] = {static_cast<int>(100 + i * 7), "08:00 AM", 50, 5.50};
+    return fleet;
+}
+
+constexpr auto benchFleet = makeFleet();
+constinit booking::StaticFleet<benchFleet> staticFleet;
+constinit booking::StaticFleet<booking::kioskFleet> kioskStatic;
+
+double nsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// main.cpp's loadFleet() without BOOKING_STATIC_FLEET, then a first lookup
+Bus* dynamicKioskStartup(BookingSystem* system) {
+    initBookingSystem(system);
+    enableBoardCache(system, "Ksh");
+    for (const auto& r : booking::kioskFleet) addBus(system, r.route, r.departureTime, r.seats, r.fare);
+    return findBus(system, booking::kioskFleet[0].route);
+}
+
+// Child mode: one configuration, one lookup, exit
+int firstLookup(const char* mode) {
+    if (strcmp(mode, "static") == 0) return kioskStatic.find(booking::kioskFleet[0].route) ? 0 : 1;
+    BookingSystem system;
+    return dynamicKioskStartup(&system) ? 0 : 1;
+}
+
+#ifdef FLEET_BENCH_SPAWN
+// Mean microseconds from spawning `self --first-lookup mode` to its exit, or
+// a negative number if a run failed
+double processStartup(const char* self, const char* mode) {
+    char* args[] = {const_cast<char*>(self), const_cast<char*>("--first-lookup"), const_cast<char*>(mode), nullptr};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kProcesses; i++) {
+        pid_t pid;
+        int status;
+        if (posix_spawn(&pid, self, nullptr, nullptr, args, nullptr) != 0) return -1;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+    }
+    return nsSince(start) / kProcesses / 1000;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 2 && strcmp(argv[1], "--first-lookup") == 0) return firstLookup(argv[2]);
+    long lookups = argc > 1 ? atol(argv[1]) : 50000000L;
+
+    // Kiosk fleet, in process: setup plus the first lookup
+    long hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kStartups; i++) {
+        BookingSystem system;
+        if (dynamicKioskStartup(&system)) hits++;
+        freeBookingSystem(&system);
+    }
+    printf("startup, dynamic:  %.0f ns to first lookup (%zu kiosk routes)\n", nsSince(start) / kStartups,
+           booking::kioskFleet.size());
+    start = std::chrono::steady_clock::now();
+    if (kioskStatic.find(booking::kioskFleet[0].route)) hits++;
+    printf("startup, static:   %.0f ns to first lookup (constant-initialised, %zu bytes of .data)\n",
+           nsSince(start), sizeof(kioskStatic));
+
+#ifdef FLEET_BENCH_SPAWN
+    double dynamicUs = processStartup(argv[0], "dynamic");
+    double staticUs = processStartup(argv[0], "static");
+    if (dynamicUs < 0 || staticUs < 0) {
+        printf("process startup:   could not run %s\n", argv[0]);
+        return 1;
+    }
+    printf("process, dynamic:  %.1f us from spawn to exit after the first lookup\n", dynamicUs);
+    printf("process, static:   %.1f us from spawn to exit after the first lookup\n", staticUs);
+#endif
+
+    // A larger fleet, to show how setup and lookup scale
+    start = std::chrono::steady_clock::now();
+    BookingSystem system;
+    initBookingSystem(&system);
+    for (const auto& r : benchFleet) addBus(&system, r.route, r.departureTime, r.seats, r.fare);
+    printf("setup, dynamic:    %.0f ns (%zu routes)\n", nsSince(start), kRoutes);
+
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < lookups; i++)
+        if (findBus(&system, benchFleet[i % kRoutes].route)) hits++;
+    printf("lookup, dynamic:   %.2f ns\n", nsSince(start) / lookups);
+
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < lookups; i++)
+        if (staticFleet.find(benchFleet[i % kRoutes].route)) hits++;
+    printf("lookup, static:    %.2f ns\n", nsSince(start) / lookups);
+
+    freeBookingSystem(&system);
+    return hits == 2 * lookups + kStartups + 1 ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#ifndef KIOSK_FLEET_HPP
+#define KIOSK_FLEET_HPP
+
+// Route table compiled into the kiosk build (BOOKING_STATIC_FLEET=ON).
+// Edit this list and rebuild to change the fleet.
+
+#include "static_fleet.hpp"
+
+namespace booking {
+
+inline constexpr std::array<RouteSpec, 3> kioskFleet{{
+    {101, "08:00 AM", 50, 500},
+    {102, "09:30 AM", 40, 600},
+    {103, "11:15 AM", 35, 700},
+}};
+
+} // namespace booking
+
+#endif // KIOSK_FLEET_HPP
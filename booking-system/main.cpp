@@ -2,107 +2,41 @@
 #include <string.h>
 #include <stdlib.h>
 
-#define MAX_BUSES 10
-#define MAX_TICKETS 100
-#define MAX_NAME_LENGTH 50
-#define MAX_ID_LENGTH 10
-
-typedef struct {
-    int routeNumber;
-    char departureTime[10];
-    int totalSeats;
-    int availableSeats;
-    double fare;
-} Bus;
-
-typedef struct {
-    char passengerName[MAX_NAME_LENGTH];
-    int routeNumber;
-    int numSeats;
-    char bookingID[MAX_ID_LENGTH];
-    double totalFare;
-} Ticket;
-
-typedef struct {
-    Bus buses[MAX_BUSES];
-    Ticket tickets[MAX_TICKETS];
-    int busCount;
-    int ticketCount;
-    int nextBookingID;
-} BookingSystem;
-
-void initBus(Bus* bus, int route, const char* time, int seats, double price) {
-    bus->routeNumber = route;
-    strcpy(bus->departureTime, time);
-    bus->totalSeats = seats;
-    bus->availableSeats = seats;
-    bus->fare = price;
+#include "booking.h"
+
+#ifdef BOOKING_STATIC_FLEET
+#include "kiosk_fleet.hpp"
+
+// Fleet is baked into the binary; BookingSystem only holds tickets
+constinit static booking::StaticFleet<booking::kioskFleet> fleet;
+
+static Bus* lookupRoute(BookingSystem*, int route) { return fleet.find(route); }
+static void showBuses(BookingSystem*) { displayBuses(fleet.data(), fleet.count(), "Ksh"); }
+static int cancelById(BookingSystem* system, const char* bid) {
+    Ticket* ticket = findTicket(system, bid);
+    Bus* bus = ticket ? fleet.find(ticket->routeNumber) : NULL;
+    if (!bus) return 0;
+    cancelSeats(bus, ticket->numSeats);
+    removeTicket(system, ticket);
+    return 1;
 }
-
-int bookSeats(Bus* bus, int numSeats) {
-    if (bus->availableSeats >= numSeats) {
-        bus->availableSeats -= numSeats;
-        return 1;
-    }
-    return 0;
-}
-
-void cancelSeats(Bus* bus, int numSeats) {
-    bus->availableSeats = (bus->availableSeats + numSeats > bus->totalSeats)
-        ? bus->totalSeats : bus->availableSeats + numSeats;
-}
-
-void initTicket(Ticket* ticket, const char* name, int route, int seats, const char* id, double fare) {
-    strcpy(ticket->passengerName, name);
-    ticket->routeNumber = route;
-    ticket->numSeats = seats;
-    strcpy(ticket->bookingID, id);
-    ticket->totalFare = fare * seats;
-}
-
-void displayTicket(const Ticket* ticket) {
-    printf("\n--- Ticket Details ---\n");
-    printf("Booking ID: %s\n", ticket->bookingID);
-    printf("Passenger: %s\n", ticket->passengerName);
-    printf("Route: %d\n", ticket->routeNumber);
-    printf("Seats: %d\n", ticket->numSeats);
-    printf("Total Fare: Ksh%.2f\n", ticket->totalFare);
-}
-
-void initializeSampleBuses(BookingSystem* system) {
-    system->busCount = 3;
-    system->ticketCount = 0;
-    system->nextBookingID = 1000;
-
-    initBus(&system->buses[0], 101, "08:00 AM", 50, 500);
-    initBus(&system->buses[1], 102, "09:30 AM", 40, 600);
-    initBus(&system->buses[2], 103, "11:15 AM", 35, 700);
+static void loadFleet(BookingSystem*) {}
+#else
+static Bus* lookupRoute(BookingSystem* system, int route) { return findBus(system, route); }
+static void showBuses(BookingSystem* system) {
+    // Only fall back to printf when nothing was written, or the board would appear twice
+    int written = writeAvailableBuses(system, 1);
+    if (written == 0) displayAvailableBuses(system, "Ksh");
+    if (written < 0) printf("Could not write the bus list!\n");
 }
-
-void displayAvailableBuses(const BookingSystem* system) {
-    printf("\nAvailable Buses:\n");
-    printf("-------------------------------------------------\n");
-    for (int i = 0; i < system->busCount; i++) {
-        printf("Route: %d\tDeparture: %s\tSeats: %d\tFare: Ksh%.2f\n",
-               system->buses[i].routeNumber,
-               system->buses[i].departureTime,
-               system->buses[i].availableSeats,
-               system->buses[i].fare);
-    }
-}
-
-Bus* findBus(BookingSystem* system, int routeNumber) {
-    for (int i = 0; i < system->busCount; i++) {
-        if (system->buses[i].routeNumber == routeNumber) {
-            return &system->buses[i];
-        }
-    }
-    return NULL;
-}
-
-void generateBookingID(BookingSystem* system, char* id) {
-    sprintf(id, "BID%d", system->nextBookingID++);
+static int cancelById(BookingSystem* system, const char* bid) { return cancelBooking(system, bid); }
+static void loadFleet(BookingSystem* system) {
+    enableBoardCache(system, "Ksh");
+    addBus(system, 101, "08:00 AM", 50, 500);
+    addBus(system, 102, "09:30 AM", 40, 600);
+    addBus(system, 103, "11:15 AM", 35, 700);
 }
+#endif
 
 void bookTicket(BookingSystem* system) {
     char name[MAX_NAME_LENGTH];
@@ -116,7 +50,7 @@ void bookTicket(BookingSystem* system) {
     printf("Enter route number: ");
     scanf("%d", &route);
 
-    Bus* selectedBus = findBus(system, route);
+    Bus* selectedBus = lookupRoute(system, route);
     if (!selectedBus) {
         printf("Invalid route number!\n");
         return;
@@ -130,13 +64,10 @@ void bookTicket(BookingSystem* system) {
         return;
     }
 
-    if (bookSeats(selectedBus, seats)) {
-        char bookingID[MAX_ID_LENGTH];
-        generateBookingID(system, bookingID);
-        initTicket(&system->tickets[system->ticketCount], name, route, seats, bookingID, selectedBus->fare);
+    Ticket* ticket = issueTicket(system, selectedBus, name, seats);
+    if (ticket) {
         printf("Booking successful!\n");
-        displayTicket(&system->tickets[system->ticketCount]);
-        system->ticketCount++;
+        displayTicket(ticket, "Ksh");
     } else {
         printf("Failed to book. Not enough seats available!\n");
     }
@@ -145,29 +76,22 @@ void bookTicket(BookingSystem* system) {
 void cancelTicket(BookingSystem* system) {
     char bid[MAX_ID_LENGTH];
     printf("Enter booking ID to cancel: ");
-    scanf("%s", bid);
-
-    for (int i = 0; i < system->ticketCount; i++) {
-        if (strcmp(system->tickets[i].bookingID, bid) == 0) {
-            Bus* bus = findBus(system, system->tickets[i].routeNumber);
-            if (bus) {
-                cancelSeats(bus, system->tickets[i].numSeats);
-                // Shift remaining tickets
-                for (int j = i; j < system->ticketCount - 1; j++) {
-                    system->tickets[j] = system->tickets[j + 1];
-                }
-                system->ticketCount--;
-                printf("Cancellation successful!\n");
-                return;
-            }
-        }
+    scanf("%15s", bid);
+
+    if (cancelById(system, bid)) {
+        printf("Cancellation successful!\n");
+    } else {
+        printf("Invalid booking ID!\n");
     }
-    printf("Invalid booking ID!\n");
 }
 
 int main() {
     BookingSystem system;
-    initializeSampleBuses(&system);
+    if (!initBookingSystem(&system)) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+    loadFleet(&system);
 
     int choice;
     do {
@@ -181,7 +105,7 @@ int main() {
 
         switch (choice) {
             case 1:
-                displayAvailableBuses(&system);
+                showBuses(&system);
                 break;
             case 2:
                 bookTicket(&system);
@@ -197,5 +121,6 @@ int main() {
         }
     } while (choice != 4);
 
+    freeBookingSystem(&system);
     return 0;
 }
@@ -0,0 +1,148 @@
+#ifndef STATIC_FLEET_HPP
+#define STATIC_FLEET_HPP
+
+// Compile-time fleet for kiosks with a fixed route table. The fleet is a
+// constexpr array of RouteSpec; StaticFleet turns it into constant-initialised
+// Bus storage and a perfect-hash route lookup, so there is no runtime setup.
+
+#include "booking.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace booking {
+
+struct RouteSpec {
+    int route;
+    const char* departureTime;
+    int seats;
+    double fare;
+};
+
+// Hash-and-displace perfect hash: one multiply per lookup. The high bits of
+// the product pick a bucket; the bucket's displacement is XORed into the
+// middle bits to pick a slot that no other route uses. If some multiplier
+// cannot separate two routes, construction moves on to the next one.
+template <std::size_t N>
+struct RouteHash {
+    static constexpr std::size_t size = N < 2 ? 2 : std::bit_ceil(N);
+    static constexpr int bits = std::countr_zero(size);
+    static constexpr std::uint32_t mask = size - 1;
+
+    std::uint64_t multiplier = 0;
+    std::array<std::uint32_t, size> displacement{};
+    std::array<int, size> slotIndex{};
+    bool ok = false;
+
+    constexpr explicit RouteHash(const std::array<RouteSpec, N>& fleet) {
+        for (std::size_t i = 0; i < N; i++)
+            for (std::size_t j = i + 1; j < N; j++)
+                if (fleet[i].route == fleet[j].route) return;
+
+        for (std::uint64_t attempt = 0; attempt < 64 && !ok; attempt++) {
+            multiplier = 0x9E3779B97F4A7C15ull + attempt * 0x2545F4914F6CDD1Dull * 2;
+            ok = build(fleet);
+        }
+    }
+
+    constexpr int find(int route) const {
+        std::uint64_t h = product(route);
+        return slotIndex[(static_cast<std::uint32_t>(h >> 24) ^ displacement[h >> (64 - bits)]) & mask];
+    }
+
+private:
+    constexpr std::uint64_t product(int route) const {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(route)) * multiplier;
+    }
+
+    constexpr bool build(const std::array<RouteSpec, N>& fleet) {
+        displacement = {};
+        for (auto& s : slotIndex) s = -1;
+
+        // Largest buckets are placed first, while the table is emptiest
+        std::array<std::size_t, size> bucketSize{};
+        for (const auto& r : fleet) bucketSize[product(r.route) >> (64 - bits)]++;
+        std::array<bool, size> taken{};
+        for (std::size_t want = N; want > 0; want--) {
+            for (std::size_t b = 0; b < size; b++) {
+                if (bucketSize[b] != want) continue;
+                std::array<std::uint32_t, N> keys{};
+                std::array<int, N> members{};
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < N; i++) {
+                    std::uint64_t h = product(fleet[i].route);
+                    if ((h >> (64 - bits)) != b) continue;
+                    keys[count] = static_cast<std::uint32_t>(h >> 24);
+                    members[count++] = static_cast<int>(i);
+                }
+                if (!place(keys, members, count, taken, b)) return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool place(const std::array<std::uint32_t, N>& keys, const std::array<int, N>& members,
+                         std::size_t count, std::array<bool, size>& taken, std::size_t bucket) {
+        for (std::uint32_t d = 0; d < size; d++) {
+            bool fits = true;
+            for (std::size_t k = 0; k < count && fits; k++) {
+                std::uint32_t slot = (keys[k] ^ d) & mask;
+                if (taken[slot]) fits = false;
+                for (std::size_t m = 0; m < k && fits; m++)
+                    if (((keys[m] ^ d) & mask) == slot) fits = false;
+            }
+            if (!fits) continue;
+            for (std::size_t k = 0; k < count; k++) {
+                taken[(keys[k] ^ d) & mask] = true;
+                slotIndex[(keys[k] ^ d) & mask] = members[k];
+            }
+            displacement[bucket] = d;
+            return true;
+        }
+        return false;
+    }
+};
+
+constexpr Bus makeBus(const RouteSpec& spec) {
+    Bus bus{};
+    bus.routeNumber = spec.route;
+    for (int i = 0; i < MAX_TIME_LENGTH - 1 && spec.departureTime[i]; i++) bus.departureTime[i] = spec.departureTime[i];
+    bus.totalSeats = spec.seats;
+    bus.availableSeats = spec.seats;
+    bus.fare = spec.fare;
+    return bus;
+}
+
+// Fleet must be a namespace-scope constexpr std::array<RouteSpec, N>.
+// Declare instances constinit so the Bus table is emitted as initialised data.
+template <const auto& Fleet>
+class StaticFleet {
+public:
+    static constexpr std::size_t capacity = Fleet.size();
+
+private:
+    static constexpr RouteHash<capacity> hash{Fleet};
+    static_assert(hash.ok, "fleet routes must be unique and perfectly hashable");
+
+    std::array<Bus, capacity> buses;
+
+public:
+    constexpr StaticFleet() : buses{} {
+        for (std::size_t i = 0; i < capacity; i++) buses[i] = makeBus(Fleet[i]);
+    }
+
+    Bus* find(int route) {
+        int i = hash.find(route);
+        return (i >= 0 && buses[i].routeNumber == route) ? &buses[i] : nullptr;
+    }
+
+    Bus* data() { return buses.data(); }
+    const Bus* data() const { return buses.data(); }
+    int count() const { return static_cast<int>(capacity); }
+};
+
+} // namespace booking
+
+#endif // STATIC_FLEET_HPP
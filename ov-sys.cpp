@@ -3,12 +3,23 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 #include <ctime>
 #include <chrono>
 #include <thread>
 #include <stdexcept>
 #include <algorithm>
-#include <openssl/aes.h> // Requires OpenSSL library for encryption
+#include <functional>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <openssl/evp.h> // Requires OpenSSL library for encryption
+#include <openssl/rand.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -17,28 +28,163 @@ string generateVerificationToken() {
     return "TOKEN" + to_string(rand() % 10000);
 }
 
-// Encryption Service using AES (simplified with OpenSSL)
+// Encryption Service: AES-128-CBC with PKCS#7 padding and a fresh random IV
+// per vote, stored as hex(IV || ciphertext). A candidate ID (at most 11
+// characters) always pads to one block, and CBC of one block is just
+// AES(IV ^ block), so every record goes through one ECB context whose key
+// schedule is expanded once, and a batch is a single EVP call that AES-NI
+// can pipeline.
 class EncryptionService {
 private:
-    unsigned char key[AES_BLOCK_SIZE] = "ThisIsASecretKey"; // 16 bytes
-    unsigned char iv[AES_BLOCK_SIZE] = "ThisIsAnIV123456";  // 16 bytes
+    static const int BLOCK = 16;
+    static const int RECORD_HEX = 4 * BLOCK;
+    static const int IV_POOL = 256;     // IVs per RAND_bytes call
+    EVP_CIPHER_CTX* encCtx;
+    EVP_CIPHER_CTX* decCtx;
+    unsigned char ivPool[IV_POOL * BLOCK];
+    int ivsLeft = 0;
+
+    static EVP_CIPHER_CTX* newContext(bool encrypting) {
+        static const unsigned char key[BLOCK] = { 'T','h','i','s','I','s','A','S','e','c','r','e','t','K','e','y' };
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        if (!ctx || !EVP_CipherInit_ex(ctx, EVP_aes_128_ecb(), nullptr, key, nullptr, encrypting ? 1 : 0)) {
+            EVP_CIPHER_CTX_free(ctx);
+            throw runtime_error("Could not initialise AES");
+        }
+        EVP_CIPHER_CTX_set_padding(ctx, 0);
+        return ctx;
+    }
+
+    // RAND_bytes costs about the same for 16 bytes as for 4 KB, so IVs are
+    // drawn from a pool; large batches take theirs directly
+    void randomIvs(unsigned char* out, size_t count) {
+        if (count >= IV_POOL) {
+            if (RAND_bytes(out, (int)(count * BLOCK)) != 1) throw runtime_error("No randomness for IV");
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (ivsLeft == 0) {
+                if (RAND_bytes(ivPool, sizeof(ivPool)) != 1) throw runtime_error("No randomness for IV");
+                ivsLeft = IV_POOL;
+            }
+            unsigned char* iv = ivPool + --ivsLeft * BLOCK;
+            memcpy(out + i * BLOCK, iv, BLOCK);
+            memset(iv, 0, BLOCK);
+        }
+    }
+
+    // PKCS#7-padded decimal text of value, XORed with iv
+    static void chainBlock(int value, const unsigned char* iv, unsigned char* block) {
+        char text[BLOCK];
+        int length = (int)(to_chars(text, text + BLOCK, value).ptr - text);
+        for (int i = 0; i < BLOCK; i++)
+            block[i] = (unsigned char)(i < length ? text[i] : BLOCK - length) ^ iv[i];
+    }
+
+    // Undoes the IV, checks the padding and parses the candidate ID
+    static int unchainBlock(unsigned char* block, const unsigned char* iv) {
+        for (int i = 0; i < BLOCK; i++) block[i] ^= iv[i];
+        int pad = block[BLOCK - 1];
+        if (pad < 1 || pad >= BLOCK) throw runtime_error("Corrupt encrypted vote");
+        for (int i = BLOCK - pad; i < BLOCK; i++)
+            if (block[i] != pad) throw runtime_error("Corrupt encrypted vote");
+        int value = 0;
+        const char* text = (const char*)block;
+        from_chars_result parsed = from_chars(text, text + BLOCK - pad, value);
+        if (parsed.ec != errc() || parsed.ptr != text + BLOCK - pad) throw runtime_error("Corrupt encrypted vote");
+        return value;
+    }
+
+    static void toHex(const unsigned char* iv, const unsigned char* block, string& hex) {
+        static const char digits[] = "0123456789abcdef";
+        hex.resize(RECORD_HEX);
+        for (int i = 0; i < 2 * BLOCK; i++) {
+            unsigned char byte = i < BLOCK ? iv[i] : block[i - BLOCK];
+            hex[2 * i] = digits[byte >> 4];
+            hex[2 * i + 1] = digits[byte & 15];
+        }
+    }
+
+    // Splits one stored record into its IV and ciphertext block. Digits are
+    // looked up in a table: random hex defeats a digit-or-letter branch.
+    static void fromHex(const string& encrypted, unsigned char* iv, unsigned char* block) {
+        static const struct HexTable {
+            unsigned char value[256];
+            HexTable() {
+                memset(value, 16, sizeof(value));
+                for (int i = 0; i < 10; i++) value['0' + i] = (unsigned char)i;
+                for (int i = 0; i < 6; i++) value['a' + i] = (unsigned char)(10 + i);
+            }
+        } hex;
+        if (encrypted.size() != RECORD_HEX) throw runtime_error("Corrupt encrypted vote");
+        unsigned char bytes[2 * BLOCK], bad = 0;
+        for (int i = 0; i < 2 * BLOCK; i++) {
+            unsigned char high = hex.value[(unsigned char)encrypted[2 * i]];
+            unsigned char low = hex.value[(unsigned char)encrypted[2 * i + 1]];
+            bad |= high | low;
+            bytes[i] = (unsigned char)(high << 4 | (low & 15));
+        }
+        if (bad & 16) throw runtime_error("Corrupt encrypted vote");
+        memcpy(iv, bytes, BLOCK);
+        memcpy(block, bytes + BLOCK, BLOCK);
+    }
+
+    void cipherBlocks(EVP_CIPHER_CTX* ctx, unsigned char* blocks, size_t count) {
+        int written = 0;
+        if (!EVP_CipherUpdate(ctx, blocks, &written, blocks, (int)(count * BLOCK)) || written != (int)(count * BLOCK))
+            throw runtime_error("AES failed");
+    }
 
 public:
+    EncryptionService() : encCtx(newContext(true)), decCtx(newContext(false)) {}
+
+    ~EncryptionService() {
+        EVP_CIPHER_CTX_free(encCtx);
+        EVP_CIPHER_CTX_free(decCtx);
+        OPENSSL_cleanse(ivPool, sizeof(ivPool));
+    }
+
+    EncryptionService(const EncryptionService&) = delete;
+    EncryptionService& operator=(const EncryptionService&) = delete;
+
     string encrypt(int value) {
-        AES_KEY enc_key;
-        AES_set_encrypt_key(key, 128, &enc_key);
-        string input = to_string(value);
-        unsigned char out[AES_BLOCK_SIZE];
-        AES_encrypt((unsigned char*)input.c_str(), out, &enc_key);
-        return string((char*)out, AES_BLOCK_SIZE);
+        unsigned char iv[BLOCK], block[BLOCK];
+        randomIvs(iv, 1);
+        chainBlock(value, iv, block);
+        cipherBlocks(encCtx, block, 1);
+        string hex;
+        toHex(iv, block, hex);
+        return hex;
     }
 
     int decrypt(const string& encrypted) {
-        AES_KEY dec_key;
-        AES_set_decrypt_key(key, 128, &dec_key);
-        unsigned char out[AES_BLOCK_SIZE];
-        AES_decrypt((unsigned char*)encrypted.c_str(), out, &dec_key);
-        return stoi(string((char*)out));
+        unsigned char iv[BLOCK], block[BLOCK];
+        fromHex(encrypted, iv, block);
+        cipherBlocks(decCtx, block, 1);
+        return unchainBlock(block, iv);
+    }
+
+    vector<string> encryptBatch(const vector<int>& values) {
+        size_t n = values.size();
+        if (n == 0) return {};
+        vector<unsigned char> ivs(n * BLOCK), blocks(n * BLOCK);
+        randomIvs(ivs.data(), n);
+        for (size_t i = 0; i < n; i++) chainBlock(values[i], &ivs[i * BLOCK], &blocks[i * BLOCK]);
+        cipherBlocks(encCtx, blocks.data(), n);
+        vector<string> encrypted(n);
+        for (size_t i = 0; i < n; i++) toHex(&ivs[i * BLOCK], &blocks[i * BLOCK], encrypted[i]);
+        return encrypted;
+    }
+
+    vector<int> decryptBatch(const vector<string>& encrypted) {
+        size_t n = encrypted.size();
+        if (n == 0) return {};
+        vector<unsigned char> ivs(n * BLOCK), blocks(n * BLOCK);
+        for (size_t i = 0; i < n; i++) fromHex(encrypted[i], &ivs[i * BLOCK], &blocks[i * BLOCK]);
+        cipherBlocks(decCtx, blocks.data(), n);
+        vector<int> values(n);
+        for (size_t i = 0; i < n; i++) values[i] = unchainBlock(&blocks[i * BLOCK], &ivs[i * BLOCK]);
+        return values;
     }
 };
 
@@ -55,6 +201,98 @@ public:
         : username(u), password(p), fullName(f), isEmailVerified(v), isAdmin(a) {}
 };
 
+// A user's position in the UserRegistry. Users are never removed, so a
+// handle stays valid for the life of the registry.
+struct UserHandle {
+    uint32_t index = UINT32_MAX;
+    bool valid() const { return index != UINT32_MAX; }
+};
+
+// Users in fixed-size segments that never move once allocated, so handles
+// and User pointers survive any amount of growth, plus an open-addressing
+// index on username (linear probing, at most half full) for O(1) lookup.
+class UserRegistry {
+private:
+    static const size_t SEGMENT_USERS = 4096;
+    // index + 1 of the user, 0 for an empty slot; hash saves comparing
+    // usernames on most probes and rehashing them on growth
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;
+    };
+    vector<unique_ptr<User[], void (*)(User*)>> segments;
+    size_t count = 0;
+    vector<Slot> slots;
+
+    static uint32_t hashOf(const string& username) {
+        size_t h = std::hash<string>()(username);
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
+    static User* allocateSegment() {
+        return static_cast<User*>(::operator new(SEGMENT_USERS * sizeof(User)));
+    }
+
+    static void releaseSegment(User* segment) {
+        ::operator delete(segment);
+    }
+
+    void insertSlot(Slot slot) {
+        size_t mask = slots.size() - 1;
+        size_t i = slot.hash & mask;
+        while (slots[i].index) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+
+    void growIndex() {
+        vector<Slot> old(slots.empty() ? 16 : 2 * slots.size(), Slot{0, 0});
+        old.swap(slots);
+        for (const Slot& slot : old)
+            if (slot.index) insertSlot(slot);
+    }
+
+public:
+    UserRegistry() = default;
+
+    ~UserRegistry() {
+        for (size_t i = 0; i < count; i++) at(UserHandle{(uint32_t)i}).~User();
+    }
+
+    UserRegistry(const UserRegistry&) = delete;
+    UserRegistry& operator=(const UserRegistry&) = delete;
+
+    size_t size() const { return count; }
+
+    User& at(UserHandle handle) { return segments[handle.index / SEGMENT_USERS][handle.index % SEGMENT_USERS]; }
+    const User& at(UserHandle handle) const { return segments[handle.index / SEGMENT_USERS][handle.index % SEGMENT_USERS]; }
+
+    // nullptr for an invalid handle
+    User* get(UserHandle handle) { return handle.valid() && handle.index < count ? &at(handle) : nullptr; }
+
+    UserHandle find(const string& username) const {
+        if (slots.empty()) return UserHandle();
+        uint32_t hash = hashOf(username);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; slots[i].index; i = (i + 1) & mask) {
+            UserHandle handle{slots[i].index - 1};
+            if (slots[i].hash == hash && at(handle).username == username) return handle;
+        }
+        return UserHandle();
+    }
+
+    // An invalid handle if the username is taken
+    UserHandle add(User user) {
+        if (find(user.username).valid() || count >= UINT32_MAX - 1) return UserHandle();
+        if (2 * (count + 1) > slots.size()) growIndex();
+        if (count == segments.size() * SEGMENT_USERS) segments.emplace_back(allocateSegment(), releaseSegment);
+        UserHandle handle{(uint32_t)count};
+        new (&segments[count / SEGMENT_USERS][count % SEGMENT_USERS]) User(move(user));
+        count++;
+        insertSlot(Slot{hashOf(at(handle).username), handle.index + 1});
+        return handle;
+    }
+};
+
 // Candidate class
 class Candidate {
 public:
@@ -87,13 +325,131 @@ public:
     AuditLog(string u, string a, string d) : userId(u), action(a), details(d), timestamp(time(nullptr)) {}
 };
 
+// Append-only audit.txt, one "user action timestamp details" line per
+// event. Each event is formatted into a reused buffer and appended with a
+// single write(); fdatasync runs once per AUDIT_SYNC_EVENTS events or
+// AUDIT_SYNC_INTERVAL, whichever comes first, and on close. Reads stream
+// the file instead of keeping every AuditLog in memory.
+class AuditSink {
+private:
+    static const int AUDIT_SYNC_EVENTS = 64;
+    static constexpr chrono::seconds AUDIT_SYNC_INTERVAL = chrono::seconds(1);
+    static const size_t READ_CHUNK = 16 * 1024;
+    string path;
+    int fd;
+    string buffer;
+    int unsynced = 0;
+    chrono::steady_clock::time_point lastSync = chrono::steady_clock::now();
+
+    void sync() {
+        if (unsynced == 0) return;
+        fdatasync(fd);
+        unsynced = 0;
+        lastSync = chrono::steady_clock::now();
+    }
+
+    // Splits a line at its first three spaces; details keep theirs
+    static bool parseLine(const string& line, AuditLog& log) {
+        size_t user = line.find(' ');
+        size_t action = user == string::npos ? user : line.find(' ', user + 1);
+        size_t stamp = action == string::npos ? action : line.find(' ', action + 1);
+        if (stamp == string::npos) return false;
+        log.userId.assign(line, 0, user);
+        log.action.assign(line, user + 1, action - user - 1);
+        log.timestamp = (time_t)strtoll(line.c_str() + action + 1, nullptr, 10);
+        log.details.assign(line, stamp + 1, string::npos);
+        return true;
+    }
+
+public:
+    explicit AuditSink(const string& file) : path(file) {
+        fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) throw runtime_error("Cannot open " + path);
+    }
+
+    ~AuditSink() {
+        sync();
+        close(fd);
+    }
+
+    AuditSink(const AuditSink&) = delete;
+    AuditSink& operator=(const AuditSink&) = delete;
+
+    void append(const AuditLog& log) {
+        buffer.clear();
+        buffer += log.userId;
+        buffer += ' ';
+        buffer += log.action;
+        buffer += ' ';
+        buffer += to_string(log.timestamp);
+        buffer += ' ';
+        buffer += log.details;
+        buffer += '\n';
+        for (size_t done = 0; done < buffer.size();) {
+            ssize_t n = write(fd, buffer.data() + done, buffer.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw runtime_error("Cannot write " + path);
+            done += (size_t)n;
+        }
+        if (++unsynced >= AUDIT_SYNC_EVENTS || chrono::steady_clock::now() - lastSync >= AUDIT_SYNC_INTERVAL) sync();
+    }
+
+    // Calls visit for every event, oldest first, one line in memory at a time
+    void forEach(const function<void(const AuditLog&)>& visit) const {
+        ifstream file(path);
+        string line;
+        AuditLog log("", "", "");
+        while (getline(file, line))
+            if (parseLine(line, log)) visit(log);
+    }
+
+    // The last count events, oldest first, reading the file backwards in
+    // chunks until enough lines have been seen
+    vector<AuditLog> recent(size_t count) const {
+        vector<AuditLog> logs;
+        int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0 || count == 0) {
+            if (in >= 0) close(in);
+            return logs;
+        }
+        off_t start = lseek(in, 0, SEEK_END);
+        vector<string> chunks;      // newest first
+        size_t lines = 0, bytes = 0;
+        // One newline more than count marks where the oldest wanted line starts
+        while (start > 0 && lines <= count) {
+            size_t length = (size_t)min<off_t>(start, READ_CHUNK);
+            start -= (off_t)length;
+            string chunk(length, '\0');
+            if (pread(in, &chunk[0], length, start) != (ssize_t)length) break;
+            lines += (size_t)std::count(chunk.begin(), chunk.end(), '\n');
+            bytes += length;
+            chunks.push_back(move(chunk));
+        }
+        close(in);
+        string tail;
+        tail.reserve(bytes);
+        for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) tail += *it;
+
+        // Skip all but the last count lines (and with them any partial first one)
+        size_t pos = 0, complete = (size_t)std::count(tail.begin(), tail.end(), '\n');
+        for (size_t skip = complete > count ? complete - count : 0; skip > 0; skip--) pos = tail.find('\n', pos) + 1;
+        AuditLog log("", "", "");
+        string line;
+        for (size_t next; (next = tail.find('\n', pos)) != string::npos; pos = next + 1) {
+            line.assign(tail, pos, next - pos);
+            if (parseLine(line, log)) logs.push_back(log);
+        }
+        return logs;
+    }
+};
+
 // Voting System class
 class VotingSystem {
 private:
-    vector<User> users;
+    UserRegistry users;
     vector<Candidate> candidates;
     vector<Vote> votes;
-    vector<AuditLog> auditLogs;
+    AuditSink audit{"audit.txt"};
     EncryptionService encryption;
     map<string, chrono::system_clock::time_point> rateLimitTracker;
     const int MAX_REQUESTS = 10;
@@ -111,8 +467,7 @@ private:
     }
 
     void logAudit(const string& userId, const string& action, const string& details) {
-        auditLogs.emplace_back(userId, action, details);
-        saveAuditLogs();
+        audit.append(AuditLog(userId, action, details));
     }
 
     bool checkRateLimit(const string& userId) {
@@ -133,7 +488,7 @@ private:
         ifstream usersFile("users.txt");
         if (usersFile.is_open()) {
             string u, p, f; bool v, a;
-            while (usersFile >> u >> p >> f >> v >> a) users.emplace_back(u, p, f, v, a);
+            while (usersFile >> u >> p >> f >> v >> a) users.add(User(u, p, f, v, a));
             usersFile.close();
         }
 
@@ -150,19 +505,33 @@ private:
             while (votesFile >> u >> e) votes.emplace_back(u, e);
             votesFile.close();
         }
+        recountVotes();
+    }
 
-        ifstream auditFile("audit.txt");
-        if (auditFile.is_open()) {
-            string u, a, d; time_t t;
-            while (auditFile >> u >> a >> t >> d) auditLogs.emplace_back(u, a, d);
-            auditFile.close();
+    // Tallies are not saved, so rebuild them from the stored votes
+    void recountVotes() {
+        vector<string> encrypted;
+        encrypted.reserve(votes.size());
+        for (const auto& v : votes) encrypted.push_back(v.encryptedCandidateId);
+        try {
+            map<int, Candidate*> byId;
+            for (auto& c : candidates) byId[c.id] = &c;
+            for (int id : encryption.decryptBatch(encrypted)) {
+                auto it = byId.find(id);
+                if (it != byId.end()) it->second->voteCount++;
+            }
+        }
+        catch (const exception& e) {
+            cout << "Could not recount votes from votes.txt: " << e.what() << endl;
         }
     }
 
     void saveData() {
         ofstream usersFile("users.txt");
-        for (const auto& u : users)
+        for (size_t i = 0; i < users.size(); i++) {
+            const User& u = users.at(UserHandle{(uint32_t)i});
             usersFile << u.username << " " << u.password << " " << u.fullName << " " << u.isEmailVerified << " " << u.isAdmin << endl;
+        }
         usersFile.close();
 
         ofstream candidatesFile("candidates.txt");
@@ -176,13 +545,6 @@ private:
         votesFile.close();
     }
 
-    void saveAuditLogs() {
-        ofstream auditFile("audit.txt");
-        for (const auto& l : auditLogs)
-            auditFile << l.userId << " " << l.action << " " << l.timestamp << " " << l.details << endl;
-        auditFile.close();
-    }
-
 public:
     VotingSystem() { loadData(); }
 
@@ -197,49 +559,47 @@ public:
             return;
         }
 
-        if (find_if(users.begin(), users.end(), [&](const User& u) { return u.username == username; }) != users.end()) {
+        if (users.find(username).valid()) {
             cout << "User already exists!" << endl;
             return;
         }
 
-        users.emplace_back(username, password, fullName);
         string token = generateVerificationToken();
         cout << "Verification token sent to " << username << ": " << token << endl;
         cout << "Enter token to verify: ";
         string inputToken; cin >> inputToken;
         if (inputToken == token) {
-            users.back().isEmailVerified = true;
+            users.add(User(username, password, fullName, true));
             saveData();
             logAudit(username, "Register", "User registered and verified");
             cout << "Registration successful!" << endl;
         } else {
-            users.pop_back();
             cout << "Verification failed!" << endl;
         }
     }
 
-    User* login() {
+    UserHandle login() {
         string username, password;
         cout << "Enter username: "; cin >> username;
         cout << "Enter password: "; cin >> password;
 
         if (!checkRateLimit(username)) {
             cout << "Rate limit exceeded. Try again later." << endl;
-            return nullptr;
+            return UserHandle();
         }
 
-        auto it = find_if(users.begin(), users.end(), [&](const User& u) {
-            return u.username == username && u.password == password && u.isEmailVerified;
-        });
-        if (it != users.end()) {
+        UserHandle handle = users.find(username);
+        const User* user = users.get(handle);
+        if (user && user->password == password && user->isEmailVerified) {
             logAudit(username, "Login", "User logged in");
-            return &(*it);
+            return handle;
         }
         cout << "Invalid credentials or email not verified!" << endl;
-        return nullptr;
+        return UserHandle();
     }
 
-    void vote(User* user) {
+    void vote(UserHandle handle) {
+        const User* user = users.get(handle);
         if (!user) throw runtime_error("User not logged in!");
 
         if (find_if(votes.begin(), votes.end(), [&](const Vote& v) { return v.userId == user->username; }) != votes.end()) {
@@ -281,7 +641,8 @@ public:
             cout << c.name << " - " << c.description << ": " << c.voteCount << " votes" << endl;
     }
 
-    void adminInterface(User* user) {
+    void adminInterface(UserHandle handle) {
+        const User* user = users.get(handle);
         if (!user || !user->isAdmin) throw runtime_error("Access denied!");
 
         while (true) {
@@ -301,10 +662,17 @@ public:
                     break;
                 }
                 case 2: {
-                    cout << "Audit Logs:\n";
-                    for (const auto& log : auditLogs) {
+                    cout << "Show how many recent events (0 for all): ";
+                    long count; cin >> count;
+                    auto show = [](const AuditLog& log) {
                         cout << "User: " << log.userId << ", Action: " << log.action
                              << ", Time: " << ctime(&log.timestamp) << "Details: " << log.details << endl;
+                    };
+                    cout << "Audit Logs:\n";
+                    if (count > 0) {
+                        for (const auto& log : audit.recent((size_t)count)) show(log);
+                    } else {
+                        audit.forEach(show);
                     }
                     break;
                 }
@@ -319,11 +687,54 @@ public:
     }
 };
 
+// Per-vote cost of encrypt()/decrypt() against the batch calls, checking
+// that every record decrypts back to its candidate ID
+static int benchmarkEncryption(long n) {
+    EncryptionService encryption;
+    vector<int> ids(n);
+    for (long i = 0; i < n; i++) ids[i] = (int)(i % 8) + 1;
+    auto nsPerVote = [n](chrono::steady_clock::time_point start) {
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / n;
+    };
+
+    vector<string> single(n);
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) single[i] = encryption.encrypt(ids[i]);
+    double encryptNs = nsPerVote(start);
+    bool ok = true;
+    start = chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) ok &= encryption.decrypt(single[i]) == ids[i];
+    double decryptNs = nsPerVote(start);
+
+    const long BATCH = 1024;
+    vector<string> batched;
+    batched.reserve(n);
+    start = chrono::steady_clock::now();
+    for (long i = 0; i < n; i += BATCH) {
+        vector<int> chunk(ids.begin() + i, ids.begin() + min(n, i + BATCH));
+        for (string& e : encryption.encryptBatch(chunk)) batched.push_back(move(e));
+    }
+    double encryptBatchNs = nsPerVote(start);
+    start = chrono::steady_clock::now();
+    vector<int> decrypted = encryption.decryptBatch(batched);
+    double decryptBatchNs = nsPerVote(start);
+    ok &= decrypted == ids && encryption.decryptBatch(single) == ids && encryption.decrypt(batched[0]) == ids[0];
+
+    printf("%ld votes\n", n);
+    printf("encrypt()      %7.1f ns/vote\ndecrypt()      %7.1f ns/vote\n", encryptNs, decryptNs);
+    printf("encryptBatch() %7.1f ns/vote (%ld per call)\ndecryptBatch() %7.1f ns/vote (one call)\n",
+           encryptBatchNs, BATCH, decryptBatchNs);
+    printf("round trip: %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
+
 // Main function
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--bench-encryption")
+        return benchmarkEncryption(argc > 2 ? max(1L, atol(argv[2])) : 1000000L);
     srand(static_cast<unsigned>(time(nullptr)));
     VotingSystem system;
-    User* currentUser = nullptr;
+    UserHandle currentUser;
 
     while (true) {
         try {
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "audit_writer.h"
+
+// Audit throughput: the async writer under concurrent producers vs. the old
+// fopen/fprintf/fclose per record. Usage: audit_bench [records] [threads]
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void runWriter(const char* label, AuditDurability durability, long records, int threads) {
+    remove("bench_audit.txt");
+    AuditPolicy policy = defaultAuditPolicy();
+    policy.durability = durability;
+    policy.segmentBytes = policy.segmentSeconds = 0;     // one file, as before
+    auditOpen("bench_audit.txt", &policy);
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; t++) {
+        producers.emplace_back([=] {
+            char user[64];
+            for (long i = t; i < records; i += threads) {
+                snprintf(user, sizeof(user), "voter%ld@example.com", i);
+                auditWrite(user, "Vote", 1700000000L + i, "Voted for candidate 2");
+            }
+        });
+    }
+    for (auto& p : producers) p.join();
+    double enqueued = secondsSince(start);
+    auditClose();
+    double total = secondsSince(start);
+    AuditStats stats = auditStats();
+    printf("%-16s %ld records, %d threads: %.0f rec/s enqueue, %.0f rec/s to disk\n",
+           label, records, threads, records / enqueued, records / total);
+    printf("%-16s %llu writes, %llu fsyncs, %llu producer stalls\n", "",
+           (unsigned long long)stats.writes, (unsigned long long)stats.syncs,
+           (unsigned long long)stats.producerStalls);
+}
+
+int main(int argc, char** argv) {
+    long records = argc > 1 ? atol(argv[1]) : 2000000L;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    runWriter("async/interval", AUDIT_DURABLE_INTERVAL, records, threads);
+    runWriter("async/batch", AUDIT_DURABLE_BATCH, records, threads);
+
+    // Baseline: logAudit() before the writer
+    long baseline = records / 20;
+    remove("bench_audit.txt");
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < baseline; i++) {
+        FILE* file = fopen("bench_audit.txt", "a");
+        fprintf(file, "voter%ld@example.com Vote %ld Voted for candidate 2\n", i, 1700000000L + i);
+        fclose(file);
+    }
+    double elapsed = secondsSince(start);
+    printf("%-16s %ld records, 1 thread: %.0f rec/s\n", "fopen/fclose", baseline,
+           baseline / elapsed);
+
+    remove("bench_audit.txt");
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "audit_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char* indexedUser(int slot, void* ctx) {
+    return ((const AuditIndex*)ctx)->users[slot].user;
+}
+
+// Doubles *array until it holds need elements
+static int reserve(void** array, uint32_t* capacity, uint32_t need, size_t size, uint32_t initial) {
+    if (need <= *capacity) return 1;
+    uint32_t grown = *capacity ? *capacity : initial;
+    while (grown < need) grown *= 2;
+    void* resized = realloc(*array, size * grown);
+    if (!resized) return 0;
+    *array = resized;
+    *capacity = grown;
+    return 1;
+}
+
+int initAuditIndex(AuditIndex* index, AuditTimeOf timeOf, void* ctx) {
+    memset(index, 0, sizeof(AuditIndex));
+    index->timeOf = timeOf;
+    index->ctx = ctx;
+    return initStringIndex(&index->userIndex, 1024, indexedUser, index);
+}
+
+void freeAuditIndex(AuditIndex* index) {
+    for (uint32_t i = 0; i < index->userCount; i++) free(index->users[i].events);
+    free(index->users);
+    free(index->sparse);
+    freeStringIndex(&index->userIndex);
+    memset(index, 0, sizeof(AuditIndex));
+}
+
+// Everything that can fail is allocated first, so a failed add leaves the
+// index as it was: no sparse entry, user or event past index->count.
+int auditIndexAdd(AuditIndex* index, const char* user, int64_t time) {
+    uint32_t event = index->count;
+    uint32_t entry = event / AUDIT_SPARSE_STRIDE;
+    if (event % AUDIT_SPARSE_STRIDE == 0 &&
+        !reserve((void**)&index->sparse, &index->sparseCapacity, entry + 1, sizeof(int64_t), 1024)) return 0;
+
+    uint64_t hash = hashString(user, strlen(user));
+    int slot = stringIndexFindHashed(&index->userIndex, user, hash);
+    if (slot < 0) {
+        uint32_t n = index->userCount;
+        if (!reserve((void**)&index->users, &index->userCapacity, n + 1, sizeof(AuditUserEvents), 1024)) return 0;
+        AuditUserEvents* added = &index->users[n];
+        *added = {user, NULL, 0, 0};
+        if (!reserve((void**)&added->events, &added->capacity, 1, sizeof(uint32_t), 8)) return 0;
+        if (!stringIndexInsertHashed(&index->userIndex, hash, (int)n)) {
+            free(added->events);
+            return 0;
+        }
+        index->userCount++;
+        slot = (int)n;
+    }
+    AuditUserEvents* events = &index->users[slot];
+    if (!reserve((void**)&events->events, &events->capacity, events->count + 1, sizeof(uint32_t), 8)) return 0;
+
+    if (event % AUDIT_SPARSE_STRIDE == 0) index->sparse[entry] = time;
+    events->events[events->count++] = event;
+    index->count++;
+    index->lastTime = time;
+    return 1;
+}
+
+int auditIndexUser(const AuditIndex* index, const char* user) {
+    return stringIndexFind(&index->userIndex, user);
+}
+
+// A query walks positions 0..length-1: event numbers for AUDIT_ALL_USERS,
+// places in the user's event list otherwise
+static inline uint32_t eventAt(const AuditIndex* index, int user, uint32_t position) {
+    return user == AUDIT_ALL_USERS ? position : index->users[user].events[position];
+}
+
+// First position in [lo, hi) whose event time is >= from, or hi
+static uint32_t searchEvents(const AuditIndex* index, int user, uint32_t lo, uint32_t hi, int64_t from) {
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->timeOf(eventAt(index, user, mid), index->ctx) < from) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static uint32_t firstAtOrAfter(const AuditIndex* index, int user, int64_t from) {
+    if (user != AUDIT_ALL_USERS) return searchEvents(index, user, 0, index->users[user].count, from);
+
+    // The first stride that starts at or after `from`; the answer is in the
+    // stride before it
+    uint32_t strides = (index->count + AUDIT_SPARSE_STRIDE - 1) / AUDIT_SPARSE_STRIDE;
+    uint32_t lo = 0, hi = strides;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->sparse[mid] < from) lo = mid + 1;
+        else hi = mid;
+    }
+    uint32_t first = lo ? (lo - 1) * AUDIT_SPARSE_STRIDE : 0;
+    uint32_t last = (uint64_t)lo * AUDIT_SPARSE_STRIDE < index->count ? lo * AUDIT_SPARSE_STRIDE : index->count;
+    return searchEvents(index, AUDIT_ALL_USERS, first, last, from);
+}
+
+int auditQueryPage(const AuditIndex* index, AuditQuery* query, uint32_t* events, int max) {
+    if (query->done) return 0;
+    if (query->user < AUDIT_ALL_USERS || query->user >= (int)index->userCount) {
+        query->done = 1;
+        return 0;
+    }
+    uint32_t length = query->user == AUDIT_ALL_USERS ? index->count : index->users[query->user].count;
+    uint32_t position = query->cursor ? query->cursor - 1 : firstAtOrAfter(index, query->user, query->from);
+
+    int n = 0;
+    while (n < max && position < length) {
+        uint32_t event = eventAt(index, query->user, position);
+        if (index->timeOf(event, index->ctx) > query->to) {
+            position = length;
+            break;
+        }
+        events[n++] = event;
+        position++;
+    }
+    query->cursor = position + 1;
+    if (position >= length) query->done = 1;
+    return n;
+}
@@ -0,0 +1,75 @@
+#ifndef AUDIT_INDEX_H
+#define AUDIT_INDEX_H
+
+// Time and user indexes over the in-memory audit log. Events are numbered
+// 0, 1, 2, ... in the order they are appended and are never changed or
+// removed; the index does not copy them but reads an event's time back
+// through timeOf(), as StringIndex does with keys.
+//
+//   sparse index   the time of every AUDIT_SPARSE_STRIDE-th event, so a time
+//                  lookup is a binary search of a small array and then of
+//                  one stride of events
+//   user index     per user, the numbers of that user's events in order
+//
+// Both rely on event times never going backwards, so the owner clamps each
+// time with auditIndexClamp() before storing the event. A range query is
+// then two binary searches plus the k events returned: O(log n + k).
+
+#include <stdint.h>
+
+#include "string_index.h"
+
+#define AUDIT_SPARSE_STRIDE 256
+#define AUDIT_ALL_USERS -1
+
+typedef int64_t (*AuditTimeOf)(uint32_t event, void* ctx);
+
+typedef struct {
+    const char* user;           // must outlive the index
+    uint32_t* events;
+    uint32_t count;
+    uint32_t capacity;
+} AuditUserEvents;
+
+typedef struct {
+    AuditTimeOf timeOf;
+    void* ctx;
+    uint32_t count;             // events indexed
+    int64_t lastTime;
+    int64_t* sparse;
+    uint32_t sparseCapacity;
+    AuditUserEvents* users;
+    uint32_t userCount;
+    uint32_t userCapacity;
+    StringIndex userIndex;
+} AuditIndex;
+
+// Returns 0 if memory could not be allocated
+int initAuditIndex(AuditIndex* index, AuditTimeOf timeOf, void* ctx);
+void freeAuditIndex(AuditIndex* index);
+
+static inline int64_t auditIndexClamp(const AuditIndex* index, int64_t time) {
+    return index->count && time < index->lastTime ? index->lastTime : time;
+}
+
+// Indexes event number index->count, which the caller has already stored
+// with a clamped time. Returns 0 on allocation failure, with the index
+// unchanged, so the caller can drop the event again.
+int auditIndexAdd(AuditIndex* index, const char* user, int64_t time);
+
+// User number for auditQueryPage(), or -1 if the user has no events
+int auditIndexUser(const AuditIndex* index, const char* user);
+
+// Events with from <= time <= to, for one user or AUDIT_ALL_USERS, one
+// page at a time. Start with a zeroed cursor; each call continues where the
+// previous page ended and sets done after the last event.
+typedef struct {
+    int64_t from, to;
+    int user;
+    uint32_t cursor;            // position to resume from, plus one
+    int done;
+} AuditQuery;
+
+int auditQueryPage(const AuditIndex* index, AuditQuery* query, uint32_t* events, int max);
+
+#endif // AUDIT_INDEX_H
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "audit_index.h"
+
+// "Actions by user X between T1 and T2": AuditIndex pages vs. the linear
+// scan of every event the admin view used to do.
+// Usage: audit_query_bench [events] [users]
+
+#define PAGE 20
+#define QUERIES 1000
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+typedef struct {
+    int64_t* times;
+    int* users;
+} Events;
+
+static int64_t eventTime(uint32_t event, void* ctx) {
+    return ((Events*)ctx)->times[event];
+}
+
+int main(int argc, char** argv) {
+    long count = argc > 1 ? atol(argv[1]) : 20000000L;
+    int userCount = argc > 2 ? atoi(argv[2]) : 100000;
+    if (count < 1 || userCount < 1) return 1;
+
+    char* names = (char*)malloc((size_t)userCount * 32);
+    Events events = {(int64_t*)malloc(sizeof(int64_t) * count), (int*)malloc(sizeof(int) * count)};
+    if (!names || !events.times || !events.users) return 1;
+    for (int u = 0; u < userCount; u++) snprintf(names + (size_t)u * 32, 32, "user%d@example.com", u);
+
+    // Roughly ten events a second; a few users are much busier than the rest
+    unsigned seed = 12345;
+    int64_t now = 1700000000;
+    for (long i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        now += (seed >> 8) % 10 == 0;
+        events.times[i] = now;
+        events.users[i] = (int)((seed >> 4) % (unsigned)userCount);
+        if (seed & 1) events.users[i] /= 64;
+    }
+
+    AuditIndex index;
+    if (!initAuditIndex(&index, eventTime, &events)) return 1;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < count; i++) {
+        if (!auditIndexAdd(&index, names + (size_t)events.users[i] * 32, events.times[i])) return 1;
+    }
+    printf("%ld events, %u users: indexed in %.2f s (%.0f ns/event)\n", count, index.userCount,
+           nsSince(start) / 1e9, nsSince(start) / count);
+
+    // One hour windows for random users, first page and the whole result
+    int64_t first = events.times[0], span = events.times[count - 1] - first + 1;
+    uint32_t page[PAGE];
+    long matched = 0;
+    double firstPage = 0, whole = 0;
+    for (int q = 0; q < QUERIES; q++) {
+        seed = seed * 1103515245u + 12345u;
+        AuditQuery query;
+        memset(&query, 0, sizeof(query));
+        query.user = auditIndexUser(&index, names + (size_t)((seed >> 8) % (unsigned)userCount) * 32);
+        query.from = first + (int64_t)(seed % (unsigned)span);
+        query.to = query.from + 3600;
+        if (query.user < 0) continue;
+        start = Clock::now();
+        int n = auditQueryPage(&index, &query, page, PAGE);
+        firstPage += nsSince(start);
+        while (!query.done) n += auditQueryPage(&index, &query, page, PAGE);
+        whole += nsSince(start);
+        matched += n;
+    }
+    printf("index: first page %.0f ns, whole result %.0f ns (%.1f events/query)\n", firstPage / QUERIES,
+           whole / QUERIES, (double)matched / QUERIES);
+
+    // The old view: every event checked
+    int scans = 5;
+    long scanned = 0;
+    start = Clock::now();
+    for (int q = 0; q < scans; q++) {
+        int user = q * 7 % userCount;
+        int64_t from = first + span * q / scans, to = from + 3600;
+        for (long i = 0; i < count; i++) {
+            scanned += events.users[i] == user && events.times[i] >= from && events.times[i] <= to;
+        }
+    }
+    printf("scan:  %.0f ns per query (%ld matches)\n", nsSince(start) / scans, scanned);
+
+    freeAuditIndex(&index);
+    free(names);
+    free(events.times);
+    free(events.users);
+    return 0;
+}
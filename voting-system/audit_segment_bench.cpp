@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "audit_segments.h"
+#include "audit_writer.h"
+#include "line_loader.h"
+#include "lz_codec.h"
+
+// Disk and startup cost of the audit stream: one ever-growing audit.txt, as
+// before, vs. rotated segments with the closed ones compressed. Startup is
+// the loadLines() pass loadData() makes over what it loads. The segments
+// are then read back and compared with the single file.
+// Usage: audit_segment_bench [events] [segment MB]
+
+#define SINGLE_FILE "bench_single.txt"
+#define SEGMENTED_FILE "bench_segmented.txt"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static long sizeOfFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static void countLine(const ParsedLine* line, void* ctx) {
+    (void)line;
+    (*(long*)ctx)++;
+}
+
+static double timeLoad(const char* path, long* lines) {
+    *lines = 0;
+    Clock::time_point start = Clock::now();
+    loadLines(path, countLine, lines);
+    return secondsSince(start);
+}
+
+// Roughly what the voting menu logs: logins, votes, the odd registration
+static void event(long i, char* user, const char** action, char* details) {
+    unsigned h = (unsigned)i * 2654435761u;
+    sprintf(user, "user%u@example.com", h % 500000);
+    switch (h >> 29) {
+    case 0:
+        *action = "Register";
+        strcpy(details, "User registered and verified");
+        break;
+    case 1: case 2: case 3:
+        *action = "Vote";
+        sprintf(details, "Voted for candidate %u", 1 + (h >> 8) % 12);
+        break;
+    default:
+        *action = "Login";
+        strcpy(details, "User logged in");
+    }
+}
+
+static void removeAll(const AuditManifest* manifest) {
+    char name[600];
+    for (int i = 0; i < manifest->count; i++) {
+        snprintf(name, sizeof(name), "%s.%u.lz", SEGMENTED_FILE, manifest->segments[i].seq);
+        remove(name);
+        snprintf(name, sizeof(name), "%s.%u", SEGMENTED_FILE, manifest->segments[i].seq);
+        remove(name);
+    }
+    remove(SEGMENTED_FILE ".manifest");
+    remove(SEGMENTED_FILE);
+    remove(SINGLE_FILE);
+}
+
+int main(int argc, char** argv) {
+    long events = argc > 1 ? atol(argv[1]) : 5000000L;
+    long segmentMb = argc > 2 ? atol(argv[2]) : 16;
+    AuditManifest manifest;
+    readAuditManifest(SEGMENTED_FILE, &manifest);
+    removeAll(&manifest);
+    freeAuditManifest(&manifest);
+
+    // The same events, one second apart, through the writer both ways
+    AuditPolicy policy = defaultAuditPolicy();
+    policy.durability = AUDIT_DURABLE_NONE;
+    char user[64], details[64];
+    const char* action;
+    for (int segmented = 0; segmented < 2; segmented++) {
+        policy.segmentBytes = segmented ? segmentMb << 20 : 0;
+        policy.segmentSeconds = 0;
+        if (!auditOpen(segmented ? SEGMENTED_FILE : SINGLE_FILE, &policy)) return 1;
+        for (long i = 0; i < events; i++) {
+            event(i, user, &action, details);
+            auditWrite(user, action, 1700000000 + i, details);
+        }
+        auditClose();
+    }
+    // auditClose() leaves unfinished segments for the next start
+    compressAuditSegments(SEGMENTED_FILE);
+
+    if (!readAuditManifest(SEGMENTED_FILE, &manifest)) return 1;
+    long single = sizeOfFile(SINGLE_FILE), live = sizeOfFile(SEGMENTED_FILE);
+    unsigned long long raw = live, stored = live;
+    for (int i = 0; i < manifest.count; i++) {
+        raw += manifest.segments[i].rawBytes;
+        stored += manifest.segments[i].storedBytes;
+    }
+    printf("%ld events, %.1f MB of audit text\n", events, single / 1048576.0);
+    printf("segments: %d closed, live %.1f MB\n", manifest.count, live / 1048576.0);
+    printf("disk:     %.1f MB -> %.1f MB (%.1fx)\n", single / 1048576.0, stored / 1048576.0, (double)single / stored);
+
+    long lines;
+    double before = timeLoad(SINGLE_FILE, &lines);
+    printf("startup:  one file   %6.3f s  (%ld events)\n", before, lines);
+    double after = timeLoad(SEGMENTED_FILE, &lines);
+    printf("          live only  %6.3f s  (%ld events)\n", after, lines);
+
+    // Everything must come back, in order and byte for byte
+    FILE* file = fopen(SINGLE_FILE, "rb");
+    char* expected = (char*)malloc(single + 1);
+    if (!file || !expected || fread(expected, 1, single, file) != (size_t)single) return 1;
+    fclose(file);
+    size_t offset = 0;
+    int bad = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < manifest.count; i++) {
+        size_t length;
+        char* segment = readAuditSegment(SEGMENTED_FILE, manifest.segments[i].seq, &length);
+        if (!segment || offset + length > (size_t)single || memcmp(segment, expected + offset, length) != 0) bad++;
+        else offset += length;
+        free(segment);
+    }
+    double readSeconds = secondsSince(start);
+    file = fopen(SEGMENTED_FILE, "rb");
+    char* tail = (char*)malloc(live + 1);
+    if (!file || !tail || fread(tail, 1, live, file) != (size_t)live) return 1;
+    fclose(file);
+    if (offset + live != (size_t)single || memcmp(tail, expected + offset, live) != 0) bad++;
+    printf("read back: %.0f MB/s with checksums, %s\n", (raw - live) / 1048576.0 / readSeconds,
+           bad ? "MISMATCH" : "identical to the single file");
+
+    // The codec alone, on the same text in segment-sized blocks
+    size_t block = 1 << 20;
+    char* packed = (char*)malloc(lzCompressBound(block));
+    char* unpacked = (char*)malloc(block);
+    double packSeconds = 0, unpackSeconds = 0;
+    for (size_t pos = 0; packed && unpacked && pos < (size_t)single; pos += block) {
+        size_t n = single - pos < block ? single - pos : block;
+        start = Clock::now();
+        size_t packedLength = lzCompress(expected + pos, n, packed, lzCompressBound(block));
+        packSeconds += secondsSince(start);
+        start = Clock::now();
+        if (!lzDecompress(packed, packedLength, unpacked, n)) bad++;
+        unpackSeconds += secondsSince(start);
+    }
+    printf("lz codec: compress %.0f MB/s, decompress %.0f MB/s\n", single / 1048576.0 / packSeconds,
+           single / 1048576.0 / unpackSeconds);
+    free(packed);
+    free(unpacked);
+
+    free(expected);
+    free(tail);
+    removeAll(&manifest);
+    freeAuditManifest(&manifest);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,363 @@
+#include "audit_segments.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "checksum.h"
+#include "durable_file.h"
+#include "line_loader.h"
+#include "lz_codec.h"
+#include "mapped_file.h"
+
+#define SEGMENT_PATH_MAX 512
+#define SEGMENT_BASE_MAX 256        // the live file's path; segment names add to it
+#define SEGMENT_BLOCK_BYTES (1 << 20)
+#define SEGMENT_MAGIC "OVSAUDLZ"
+
+// Compressed segment: magic, uint64 raw length, then blocks of
+//   uint32 raw length, uint32 stored length, uint32 CRC-32 of the raw bytes
+// followed by the stored bytes. A block stored at its raw length did not
+// compress and is kept as is.
+typedef struct {
+    uint32_t rawLength;
+    uint32_t storedLength;
+    uint32_t crc;
+} SegmentBlock;
+
+// The writer thread (closing segments) and the compressor both rewrite the
+// manifest
+static std::mutex manifestMutex;
+
+static void segmentName(char* dest, const char* path, uint32_t seq, int compressed) {
+    snprintf(dest, SEGMENT_PATH_MAX, compressed ? "%s.%u.lz" : "%s.%u", path, seq);
+}
+
+static long sizeOfFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+typedef struct {
+    AuditManifest* manifest;
+    int capacity;
+    int failed;
+} ManifestReader;
+
+static int appendSegment(AuditManifest* manifest, int* capacity, const AuditSegment* segment) {
+    if (manifest->count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 64;
+        AuditSegment* segments = (AuditSegment*)realloc(manifest->segments, sizeof(AuditSegment) * grown);
+        if (!segments) return 0;
+        manifest->segments = segments;
+        *capacity = grown;
+    }
+    manifest->segments[manifest->count++] = *segment;
+    return 1;
+}
+
+static void readManifestLine(const ParsedLine* line, void* ctx) {
+    ManifestReader* reader = (ManifestReader*)ctx;
+    if (line->count < 7) return;
+    char state[8];
+    fieldSpan(line, 1, 1, state, sizeof(state));
+    AuditSegment segment;
+    segment.seq = (uint32_t)fieldLong(line, 0);
+    segment.compressed = strcmp(state, "lz") == 0;
+    segment.firstTime = fieldLong(line, 2);
+    segment.lastTime = fieldLong(line, 3);
+    segment.records = (uint64_t)fieldLong(line, 4);
+    segment.rawBytes = (uint64_t)fieldLong(line, 5);
+    segment.storedBytes = (uint64_t)fieldLong(line, 6);
+    if (!appendSegment(reader->manifest, &reader->capacity, &segment)) reader->failed = 1;
+}
+
+int readAuditManifest(const char* path, AuditManifest* manifest) {
+    char name[SEGMENT_PATH_MAX];
+    snprintf(name, sizeof(name), "%s.manifest", path);
+    memset(manifest, 0, sizeof(AuditManifest));
+    ManifestReader reader = {manifest, 0, 0};
+    if (loadLines(name, readManifestLine, &reader) == LOADER_NO_MEMORY) reader.failed = 1;
+    if (reader.failed) freeAuditManifest(manifest);
+    return !reader.failed;
+}
+
+void freeAuditManifest(AuditManifest* manifest) {
+    free(manifest->segments);
+    memset(manifest, 0, sizeof(AuditManifest));
+}
+
+static int writeManifest(const char* path, const AuditManifest* manifest) {
+    char name[SEGMENT_PATH_MAX], tmp[SEGMENT_PATH_MAX];
+    snprintf(name, sizeof(name), "%s.manifest", path);
+    snprintf(tmp, sizeof(tmp), "%s.manifest.tmp", path);
+    FILE* file = fopen(tmp, "w");
+    if (!file) return 0;
+    for (int i = 0; i < manifest->count; i++) {
+        const AuditSegment* s = &manifest->segments[i];
+        fprintf(file, "%u\t%s\t%lld\t%lld\t%llu\t%llu\t%llu\n", s->seq, s->compressed ? "lz" : "raw",
+                (long long)s->firstTime, (long long)s->lastTime, (unsigned long long)s->records,
+                (unsigned long long)s->rawBytes, (unsigned long long)s->storedBytes);
+    }
+    int ok = syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    return ok && replaceFileDurably(tmp, name);
+}
+
+// A crash between renaming a segment and listing it leaves files for seqs
+// past the end of the manifest; they are listed here. Returns the next seq.
+static uint32_t adoptUnlisted(const char* path, AuditManifest* manifest, int* capacity) {
+    uint32_t seq = manifest->count ? manifest->segments[manifest->count - 1].seq + 1 : 1;
+    char name[SEGMENT_PATH_MAX];
+    while (1) {
+        int compressed = 1;
+        segmentName(name, path, seq, compressed);
+        long size = sizeOfFile(name);
+        if (size < 0) {
+            compressed = 0;
+            segmentName(name, path, seq, compressed);
+            size = sizeOfFile(name);
+        }
+        if (size < 0) return seq;
+        AuditSegment segment = {seq, compressed, 0, 0, 0, compressed ? 0 : (uint64_t)size, (uint64_t)size};
+        if (!appendSegment(manifest, capacity, &segment)) return 0;
+        seq++;
+    }
+}
+
+uint32_t closeAuditSegment(const char* path) {
+    std::lock_guard<std::mutex> lock(manifestMutex);
+    AuditManifest manifest;
+    if (!readAuditManifest(path, &manifest)) return 0;
+    int capacity = manifest.count;
+    uint32_t seq = adoptUnlisted(path, &manifest, &capacity);
+
+    char name[SEGMENT_PATH_MAX];
+    segmentName(name, path, seq, 0);
+    long size = sizeOfFile(path);
+    AuditSegment segment = {seq, 0, 0, 0, 0, (uint64_t)(size > 0 ? size : 0), (uint64_t)(size > 0 ? size : 0)};
+    int ok = seq && size >= 0 && rename(path, name) == 0 && appendSegment(&manifest, &capacity, &segment) &&
+             writeManifest(path, &manifest);
+    freeAuditManifest(&manifest);
+    return ok ? seq : 0;
+}
+
+typedef struct {
+    int64_t firstTime;
+    int64_t lastTime;
+    uint64_t records;
+} SegmentStats;
+
+// Audit lines are "userId action timestamp details"
+static void countRecord(const ParsedLine* line, void* ctx) {
+    SegmentStats* stats = (SegmentStats*)ctx;
+    if (line->count < 3) return;
+    int64_t time = fieldLong(line, 2);
+    if (stats->records == 0 || time < stats->firstTime) stats->firstTime = time;
+    if (time > stats->lastTime) stats->lastTime = time;
+    stats->records++;
+}
+
+static int writeCompressed(const char* dest, const MappedFile* raw) {
+    FILE* file = fopen(dest, "wb");
+    if (!file) return 0;
+    char* buffer = (char*)malloc(lzCompressBound(SEGMENT_BLOCK_BYTES));
+    uint64_t rawLength = raw->length;
+    int ok = buffer && fwrite(SEGMENT_MAGIC, 1, 8, file) == 8 && fwrite(&rawLength, sizeof(rawLength), 1, file) == 1;
+    for (size_t pos = 0; ok && pos < raw->length; pos += SEGMENT_BLOCK_BYTES) {
+        SegmentBlock block;
+        block.rawLength = (uint32_t)(raw->length - pos < SEGMENT_BLOCK_BYTES ? raw->length - pos : SEGMENT_BLOCK_BYTES);
+        block.crc = crc32(0, raw->data + pos, block.rawLength);
+        size_t stored = lzCompress(raw->data + pos, block.rawLength, buffer, lzCompressBound(SEGMENT_BLOCK_BYTES));
+        const char* data = buffer;
+        if (stored == 0 || stored >= block.rawLength) {
+            stored = block.rawLength;
+            data = raw->data + pos;
+        }
+        block.storedLength = (uint32_t)stored;
+        ok = fwrite(&block, sizeof(block), 1, file) == 1 && fwrite(data, 1, stored, file) == stored;
+    }
+    free(buffer);
+    ok = ok && syncFile(file);
+    return fclose(file) == 0 && ok;
+}
+
+// Compresses one segment and fills in what the manifest needs. The raw
+// file is removed by the caller once the manifest says "lz"; both the .lz
+// file and the manifest are synced, with their directory, before that.
+static int compressSegment(const char* path, AuditSegment* segment) {
+    char rawName[SEGMENT_PATH_MAX], lzName[SEGMENT_PATH_MAX], tmp[SEGMENT_PATH_MAX + 8];
+    segmentName(rawName, path, segment->seq, 0);
+    segmentName(lzName, path, segment->seq, 1);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", lzName);
+
+    MappedFile raw;
+    if (!mapFile(rawName, &raw)) {
+        // Compressed before, but the manifest was not updated
+        long size = sizeOfFile(lzName);
+        if (size < 0) return 0;
+        segment->compressed = 1;
+        segment->storedBytes = (uint64_t)size;
+        return 1;
+    }
+    SegmentStats stats = {0, 0, 0};
+    int ok = loadLines(rawName, countRecord, &stats) >= 0 && writeCompressed(tmp, &raw);
+    segment->rawBytes = raw.length;
+    unmapFile(&raw);
+    if (!ok || !replaceFileDurably(tmp, lzName)) {
+        remove(tmp);
+        return 0;
+    }
+    segment->compressed = 1;
+    segment->firstTime = stats.firstTime;
+    segment->lastTime = stats.lastTime;
+    segment->records = stats.records;
+    segment->storedBytes = (uint64_t)sizeOfFile(lzName);
+    return 1;
+}
+
+static int recordCompressed(const char* path, const AuditSegment* segment) {
+    std::lock_guard<std::mutex> lock(manifestMutex);
+    AuditManifest manifest;
+    if (!readAuditManifest(path, &manifest)) return 0;
+    for (int i = 0; i < manifest.count; i++) {
+        if (manifest.segments[i].seq == segment->seq) manifest.segments[i] = *segment;
+    }
+    int ok = writeManifest(path, &manifest);
+    freeAuditManifest(&manifest);
+    return ok;
+}
+
+// Segments closed while this runs are left for the next call
+static int compressPending(const char* path, const std::atomic<bool>* stop) {
+    AuditManifest pending;
+    {
+        std::lock_guard<std::mutex> lock(manifestMutex);
+        if (!readAuditManifest(path, &pending)) return -1;
+    }
+    int done = 0, failed = 0;
+    for (int i = 0; i < pending.count && !(stop && stop->load()); i++) {
+        AuditSegment segment = pending.segments[i];
+        if (segment.compressed) continue;
+        if (!compressSegment(path, &segment) || !recordCompressed(path, &segment)) {
+            failed = 1;
+            continue;
+        }
+        char rawName[SEGMENT_PATH_MAX];
+        segmentName(rawName, path, segment.seq, 0);
+        remove(rawName);
+        done++;
+    }
+    freeAuditManifest(&pending);
+    return failed ? -1 : done;
+}
+
+int compressAuditSegments(const char* path) {
+    return compressPending(path, NULL);
+}
+
+static std::thread compressorThread;
+static std::mutex compressorMutex;
+static std::condition_variable compressorWake;
+static bool compressorPending = false, compressorRunning = false;
+static std::atomic<bool> compressorStop{false};
+static char compressorPath[SEGMENT_BASE_MAX];
+
+static void compressorLoop() {
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(compressorMutex);
+            compressorWake.wait(lock, [] { return compressorPending || compressorStop.load(); });
+            if (compressorStop.load()) return;
+            compressorPending = false;
+        }
+        if (compressPending(compressorPath, &compressorStop) < 0) {
+            printf("Error compressing audit segments!\n");
+        }
+    }
+}
+
+void startSegmentCompressor(const char* path) {
+    if (compressorRunning) return;
+    snprintf(compressorPath, sizeof(compressorPath), "%s", path);
+    compressorStop = false;
+    compressorPending = true;      // segments left over from the last run
+    compressorRunning = true;
+    compressorThread = std::thread(compressorLoop);
+}
+
+void queueSegmentCompression(void) {
+    std::lock_guard<std::mutex> lock(compressorMutex);
+    compressorPending = true;
+    compressorWake.notify_one();
+}
+
+void stopSegmentCompressor(void) {
+    if (!compressorRunning) return;
+    {
+        std::lock_guard<std::mutex> lock(compressorMutex);
+        compressorStop = true;
+        compressorWake.notify_one();
+    }
+    compressorThread.join();
+    compressorRunning = false;
+}
+
+static char* readCompressed(const MappedFile* file, size_t* length) {
+    uint64_t rawLength;
+    if (file->length < 16 || memcmp(file->data, SEGMENT_MAGIC, 8) != 0) return NULL;
+    memcpy(&rawLength, file->data + 8, sizeof(rawLength));
+    char* raw = (char*)malloc(rawLength + 1);
+    if (!raw) return NULL;
+    size_t pos = 16, out = 0;
+    while (out < rawLength) {
+        SegmentBlock block;
+        if (file->length - pos < sizeof(block)) break;
+        memcpy(&block, file->data + pos, sizeof(block));
+        pos += sizeof(block);
+        if (block.storedLength > file->length - pos || block.rawLength > rawLength - out) break;
+        const char* stored = file->data + pos;
+        int ok = 1;
+        if (block.storedLength == block.rawLength) memcpy(raw + out, stored, block.rawLength);
+        else ok = lzDecompress(stored, block.storedLength, raw + out, block.rawLength);
+        if (!ok || crc32(0, raw + out, block.rawLength) != block.crc) break;
+        pos += block.storedLength;
+        out += block.rawLength;
+    }
+    if (out != rawLength) {
+        free(raw);
+        return NULL;
+    }
+    raw[rawLength] = 0;
+    *length = rawLength;
+    return raw;
+}
+
+char* readAuditSegment(const char* path, uint32_t seq, size_t* length) {
+    char name[SEGMENT_PATH_MAX];
+    MappedFile file;
+    segmentName(name, path, seq, 1);
+    if (mapFile(name, &file)) {
+        char* raw = readCompressed(&file, length);
+        unmapFile(&file);
+        return raw;
+    }
+    segmentName(name, path, seq, 0);
+    if (!mapFile(name, &file)) return NULL;
+    char* raw = (char*)malloc(file.length + 1);
+    if (raw) {
+        memcpy(raw, file.data, file.length);
+        raw[file.length] = 0;
+        *length = file.length;
+    }
+    unmapFile(&file);
+    return raw;
+}
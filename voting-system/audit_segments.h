@@ -0,0 +1,57 @@
+#ifndef AUDIT_SEGMENTS_H
+#define AUDIT_SEGMENTS_H
+
+// Closed audit segments. The audit writer appends to a live file (audit.txt)
+// and, once it passes a size or age limit, moves it aside as segment
+// audit.txt.<seq> and starts a new one. A background thread compresses each
+// closed segment with lz_codec into audit.txt.<seq>.lz and removes the raw
+// file. audit.txt.manifest lists the closed segments, one tab-separated
+// line each:
+//
+//   seq  raw|lz  firstTime  lastTime  records  rawBytes  storedBytes
+//
+// Closed segments are cold: startup loads only the live file, and history
+// is read back a segment at a time with readAuditSegment().
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t seq;
+    int compressed;
+    int64_t firstTime;          // 0 until the segment has been compressed
+    int64_t lastTime;
+    uint64_t records;
+    uint64_t rawBytes;
+    uint64_t storedBytes;       // on disk now
+} AuditSegment;
+
+typedef struct {
+    AuditSegment* segments;     // in seq order
+    int count;
+} AuditManifest;
+
+// A missing manifest reads as empty. Returns 0 on allocation failure.
+int readAuditManifest(const char* path, AuditManifest* manifest);
+void freeAuditManifest(AuditManifest* manifest);
+
+// Renames the (closed) live file to the next segment and lists it. Returns
+// the segment's seq, or 0 on failure.
+uint32_t closeAuditSegment(const char* path);
+
+// Background compression of every raw segment in the manifest, then of each
+// one closed after that (announced with queueSegmentCompression()). Stopping
+// finishes the segment in progress; the rest wait for the next start.
+void startSegmentCompressor(const char* path);
+void queueSegmentCompression(void);
+void stopSegmentCompressor(void);
+
+// Compresses every raw segment on the calling thread. Returns how many, or
+// -1 on error.
+int compressAuditSegments(const char* path);
+
+// Contents of a closed segment, raw or compressed, as a malloc'd buffer, or
+// NULL if it is missing or fails its checksums
+char* readAuditSegment(const char* path, uint32_t seq, size_t* length);
+
+#endif // AUDIT_SEGMENTS_H
@@ -0,0 +1,313 @@
+#include "audit_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+#include "audit_segments.h"
+
+#define AUDIT_LINE_MAX 512
+#define AUDIT_PATH_MAX 512
+
+using Clock = std::chrono::steady_clock;
+
+// Bounded MPSC ring (Vyukov-style sequence numbers). A cell is free for
+// position p when seq == p, and holds a record for p when seq == p + 1.
+typedef struct {
+    std::atomic<uint64_t> seq;
+    int length;
+    int64_t timestamp;
+    char line[AUDIT_LINE_MAX];
+} AuditCell;
+
+static AuditCell* ring = NULL;
+static uint64_t ringMask = 0;
+alignas(64) static std::atomic<uint64_t> tail{0};       // next position to reserve
+alignas(64) static uint64_t head = 0;                   // writer thread only
+alignas(64) static std::atomic<uint64_t> consumed{0};   // records taken off the ring
+static std::atomic<uint64_t> written{0}, synced{0};
+
+static AuditPolicy auditPolicy;
+static int auditFd = -1;
+static char auditPath[AUDIT_PATH_MAX];
+static long segmentBytes = 0;               // writer thread only, like the two below
+static int64_t segmentFirst = 0, segmentLast = 0;     // record times; 0 = none yet
+static std::thread writerThread;
+static std::atomic<bool> running{false}, stopping{false}, writerSleeping{false}, ioError{false};
+static std::atomic<int> blockedProducers{0}, flushWaiters{0};
+static std::mutex wakeMutex;
+static std::condition_variable wakeWriter, progress;
+
+static std::atomic<uint64_t> statRecords{0}, statWrites{0}, statSyncs{0}, statBytes{0}, statStalls{0},
+    statSegments{0};
+
+AuditPolicy defaultAuditPolicy(void) {
+    AuditPolicy policy;
+    policy.queueCapacity = 8192;
+    policy.batchBytes = 256 * 1024;
+    policy.durability = AUDIT_DURABLE_INTERVAL;
+    policy.syncIntervalMillis = 1000;
+    policy.segmentBytes = 64L << 20;
+    policy.segmentSeconds = 24L * 60 * 60;
+    return policy;
+}
+
+static int writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        long n = write(fd, data, length);
+        if (n <= 0) return 0;
+        data += n;
+        length -= n;
+    }
+    return 1;
+}
+
+static void notifyProgress() {
+    if (blockedProducers.load() > 0 || flushWaiters.load() > 0) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        progress.notify_all();
+    }
+}
+
+static void wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping.load()) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeWriter.notify_one();
+    }
+}
+
+static bool recordReady() {
+    return ring[head & ringMask].seq.load(std::memory_order_acquire) == head + 1;
+}
+
+static void syncNow(uint64_t upTo) {
+    if (fsync(auditFd) != 0) ioError = true;
+    statSyncs++;
+    synced.store(upTo);
+}
+
+static bool segmentFull() {
+    if (segmentBytes == 0) return false;
+    return (auditPolicy.segmentBytes > 0 && segmentBytes >= auditPolicy.segmentBytes) ||
+           (auditPolicy.segmentSeconds > 0 && segmentLast - segmentFirst >= auditPolicy.segmentSeconds);
+}
+
+// Everything written so far is synced (per policy) into the closing segment
+// before it is moved aside
+static void rotateSegment() {
+    if (auditPolicy.durability != AUDIT_DURABLE_NONE && synced.load() < written.load()) syncNow(written.load());
+    close(auditFd);
+    if (closeAuditSegment(auditPath)) {
+        statSegments++;
+        queueSegmentCompression();
+    } else {
+        printf("Error closing audit segment!\n");
+    }
+    auditFd = open(auditPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (auditFd < 0) ioError = true;
+    segmentBytes = 0;
+    segmentFirst = segmentLast = 0;
+}
+
+static void writerLoop() {
+    char* batch = (char*)malloc(auditPolicy.batchBytes);
+    Clock::time_point lastSync = Clock::now();
+    std::chrono::milliseconds interval(auditPolicy.syncIntervalMillis);
+
+    while (batch) {
+        size_t length = 0;
+        uint64_t taken = 0;
+        while (length + AUDIT_LINE_MAX <= (size_t)auditPolicy.batchBytes && recordReady()) {
+            AuditCell* cell = &ring[head & ringMask];
+            memcpy(batch + length, cell->line, cell->length);
+            length += cell->length;
+            if (segmentFirst == 0) segmentFirst = cell->timestamp;
+            segmentLast = cell->timestamp;
+            cell->seq.store(head + ringMask + 1, std::memory_order_release);
+            head++;
+            taken++;
+        }
+
+        if (taken > 0) {
+            consumed.store(head);
+            notifyProgress();
+            if (!writeAll(auditFd, batch, length)) ioError = true;
+            segmentBytes += (long)length;
+            written.store(head);
+            statRecords += taken;
+            statWrites++;
+            statBytes += length;
+        }
+
+        bool unsynced = synced.load() < written.load();
+        bool didSync = false;
+        if (unsynced && auditPolicy.durability != AUDIT_DURABLE_NONE &&
+            (auditPolicy.durability == AUDIT_DURABLE_BATCH || flushWaiters.load() > 0 ||
+             Clock::now() - lastSync >= interval)) {
+            syncNow(written.load());
+            lastSync = Clock::now();
+            didSync = true;
+            unsynced = false;
+        }
+        if (taken > 0 || didSync) notifyProgress();
+        if (taken > 0) {
+            if (segmentFull()) rotateSegment();
+            continue;
+        }
+
+        if (stopping.load() && tail.load() == head) break;
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        writerSleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool flushPending = flushWaiters.load() > 0 && unsynced && auditPolicy.durability != AUDIT_DURABLE_NONE;
+        if (!recordReady() && !stopping.load() && !flushPending) {
+            wakeWriter.wait_for(lock, unsynced ? interval : std::chrono::milliseconds(100));
+        }
+        writerSleeping = false;
+    }
+
+    if (auditPolicy.durability != AUDIT_DURABLE_NONE && synced.load() < written.load()) syncNow(written.load());
+    free(batch);
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    progress.notify_all();
+}
+
+int auditOpen(const char* path, const AuditPolicy* policy) {
+    if (running.load()) return 1;
+    auditPolicy = policy ? *policy : defaultAuditPolicy();
+    if (auditPolicy.batchBytes < AUDIT_LINE_MAX) auditPolicy.batchBytes = AUDIT_LINE_MAX;
+
+    uint64_t capacity = 2;
+    while (capacity < (uint64_t)auditPolicy.queueCapacity) capacity *= 2;
+    ring = new (std::nothrow) AuditCell[capacity];
+    if (!ring) return 0;
+    auditFd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (auditFd < 0) {
+        delete[] ring;
+        ring = NULL;
+        return 0;
+    }
+
+    // Carry on with the segment left by the last run
+    snprintf(auditPath, sizeof(auditPath), "%s", path);
+    struct stat info;
+    segmentBytes = fstat(auditFd, &info) == 0 ? (long)info.st_size : 0;
+    segmentFirst = segmentLast = 0;
+    FILE* existing = segmentBytes > 0 ? fopen(path, "r") : NULL;
+    if (existing) {
+        long long first;
+        if (fscanf(existing, "%*s %*s %lld", &first) == 1) segmentFirst = segmentLast = first;
+        fclose(existing);
+    }
+
+    ringMask = capacity - 1;
+    for (uint64_t i = 0; i < capacity; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+    tail = head = 0;
+    consumed = written = synced = 0;
+    statRecords = statWrites = statSyncs = statBytes = statStalls = statSegments = 0;
+    stopping = false;
+    ioError = false;
+    running = true;
+    writerThread = std::thread(writerLoop);
+    if (auditPolicy.segmentBytes > 0 || auditPolicy.segmentSeconds > 0) startSegmentCompressor(path);
+    return 1;
+}
+
+void auditClose(void) {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+        wakeWriter.notify_one();
+    }
+    writerThread.join();
+    stopSegmentCompressor();
+    close(auditFd);
+    auditFd = -1;
+    delete[] ring;
+    ring = NULL;
+}
+
+int auditWrite(const char* userId, const char* action, time_t timestamp, const char* details) {
+    if (!running.load(std::memory_order_relaxed)) return 0;
+
+    uint64_t pos = tail.load(std::memory_order_relaxed);
+    AuditCell* cell;
+    while (true) {
+        cell = &ring[pos & ringMask];
+        int64_t diff = (int64_t)(cell->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Full: block until the writer has taken the record a lap behind us
+            statStalls++;
+            blockedProducers++;
+            wake();
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                progress.wait_for(lock, std::chrono::milliseconds(10),
+                                  [pos] { return consumed.load() + ringMask + 1 > pos || !running.load(); });
+            }
+            blockedProducers--;
+            if (!running.load()) return 0;
+            pos = tail.load(std::memory_order_relaxed);
+        } else {
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    int n = snprintf(cell->line, AUDIT_LINE_MAX, "%s %s %ld %s\n", userId, action, (long)timestamp, details);
+    cell->timestamp = timestamp;
+    if (n >= AUDIT_LINE_MAX) {
+        n = AUDIT_LINE_MAX - 1;
+        cell->line[n - 1] = '\n';
+    }
+    cell->length = n;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    wake();
+    return 1;
+}
+
+int auditFlush(void) {
+    if (!running.load()) return !ioError.load();
+    uint64_t target = tail.load();
+    bool durable = auditPolicy.durability != AUDIT_DURABLE_NONE;
+
+    flushWaiters++;
+    wake();
+    {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeWriter.notify_one();
+        progress.wait(lock, [target, durable] {
+            return (durable ? synced.load() : written.load()) >= target || ioError.load() || !running.load();
+        });
+    }
+    flushWaiters--;
+    return !ioError.load();
+}
+
+AuditStats auditStats(void) {
+    AuditStats stats;
+    stats.records = statRecords.load();
+    stats.writes = statWrites.load();
+    stats.syncs = statSyncs.load();
+    stats.bytes = statBytes.load();
+    stats.producerStalls = statStalls.load();
+    stats.segmentsClosed = statSegments.load();
+    return stats;
+}
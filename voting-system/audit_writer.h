@@ -0,0 +1,56 @@
+#ifndef AUDIT_WRITER_H
+#define AUDIT_WRITER_H
+
+// Asynchronous audit writer. logAudit() callers format their record straight
+// into a slot of a bounded lock-free MPSC ring; a dedicated writer thread
+// drains the ring into large write() batches. When the ring is full,
+// producers block until the writer frees space (back-pressure) rather than
+// dropping records. auditClose() drains everything before returning.
+//
+// The file is the live segment of the audit stream: once it reaches
+// segmentBytes, or holds records spanning segmentSeconds, the writer moves
+// it aside as a closed segment and starts a new one, and a background
+// thread compresses the closed segments (see audit_segments.h).
+
+#include <stdint.h>
+#include <time.h>
+
+typedef enum {
+    AUDIT_DURABLE_NONE,         // write() only; the OS decides when it hits disk
+    AUDIT_DURABLE_INTERVAL,     // fsync at most every syncIntervalMillis
+    AUDIT_DURABLE_BATCH         // fsync after every batch
+} AuditDurability;
+
+typedef struct {
+    int queueCapacity;          // slots, rounded up to a power of two
+    int batchBytes;             // largest single write()
+    AuditDurability durability;
+    int syncIntervalMillis;
+    long segmentBytes;          // 0 = no size limit
+    long segmentSeconds;        // 0 = no age limit
+} AuditPolicy;
+
+AuditPolicy defaultAuditPolicy(void);
+
+int auditOpen(const char* path, const AuditPolicy* policy);
+void auditClose(void);
+
+// Thread-safe. Blocks only while the queue is full. Returns 0 if the writer
+// is not running.
+int auditWrite(const char* userId, const char* action, time_t timestamp, const char* details);
+// Waits until every record queued before the call is written (and synced,
+// unless the policy is AUDIT_DURABLE_NONE). Returns 0 on I/O error.
+int auditFlush(void);
+
+typedef struct {
+    uint64_t records;
+    uint64_t writes;
+    uint64_t syncs;
+    uint64_t bytes;
+    uint64_t producerStalls;    // times a producer found the queue full
+    uint64_t segmentsClosed;
+} AuditStats;
+
+AuditStats auditStats(void);
+
+#endif // AUDIT_WRITER_H
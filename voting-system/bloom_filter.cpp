@@ -0,0 +1,51 @@
+#include "bloom_filter.h"
+
+#include <stdlib.h>
+
+#define BLOOM_BITS_PER_KEY 12   // ~1% false positives with 6 probes in a 512-bit block
+
+int initBloom(BloomFilter* bloom, int expected) {
+    if (expected < 64) expected = 64;
+    uint64_t blocks = 1;
+    while (blocks * 512 < (uint64_t)expected * BLOOM_BITS_PER_KEY) blocks *= 2;
+    bloom->blocks = (uint64_t*)calloc(blocks * 8, sizeof(uint64_t));
+    bloom->blockMask = blocks - 1;
+    bloom->count = 0;
+    bloom->capacity = expected;
+    return bloom->blocks != NULL;
+}
+
+void freeBloom(BloomFilter* bloom) {
+    free(bloom->blocks);
+    bloom->blocks = NULL;
+}
+
+// The high half of the hash picks the block; 9-bit slices of a remixed hash
+// pick the bits inside it
+static uint64_t probeBits(uint64_t hash) {
+    hash ^= hash >> 31;
+    hash *= 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+void bloomAdd(BloomFilter* bloom, uint64_t hash) {
+    uint64_t* block = bloom->blocks + ((hash >> 32) & bloom->blockMask) * 8;
+    uint64_t bits = probeBits(hash);
+    for (int i = 0; i < BLOOM_PROBES; i++, bits >>= 9) {
+        block[(bits >> 6) & 7] |= 1ull << (bits & 63);
+    }
+    bloom->count++;
+}
+
+int bloomMayContain(const BloomFilter* bloom, uint64_t hash) {
+    const uint64_t* block = bloom->blocks + ((hash >> 32) & bloom->blockMask) * 8;
+    uint64_t bits = probeBits(hash);
+    for (int i = 0; i < BLOOM_PROBES; i++, bits >>= 9) {
+        if (!(block[(bits >> 6) & 7] & (1ull << (bits & 63)))) return 0;
+    }
+    return 1;
+}
+
+int bloomFull(const BloomFilter* bloom) {
+    return bloom->count >= bloom->capacity;
+}
@@ -0,0 +1,26 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+// Cache-blocked Bloom filter: every key maps to one 64-byte block and sets
+// BLOOM_PROBES bits inside it, so a lookup costs a single cache miss. Takes
+// the 64-bit hash from hashString(). Sized for `expected` keys; the owner
+// rebuilds it bigger once bloomFull() says so.
+
+#include <stdint.h>
+
+#define BLOOM_PROBES 6
+
+typedef struct {
+    uint64_t* blocks;           // 8 words per block
+    uint64_t blockMask;
+    int count;
+    int capacity;
+} BloomFilter;
+
+int initBloom(BloomFilter* bloom, int expected);
+void freeBloom(BloomFilter* bloom);
+void bloomAdd(BloomFilter* bloom, uint64_t hash);
+int bloomMayContain(const BloomFilter* bloom, uint64_t hash);
+int bloomFull(const BloomFilter* bloom);
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,18 @@
+#include "checksum.h"
+
+uint32_t crc32(uint32_t crc, const void* data, size_t length) {
+    static uint32_t table[256];
+    static int ready = [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return 1;
+    }();
+    (void)ready;
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t c = crc ^ 0xFFFFFFFFu;
+    while (length--) c = table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
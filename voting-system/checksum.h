@@ -0,0 +1,11 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE), table-driven. Pass the previous result to continue a CRC
+// over several pieces, 0 to start one.
+uint32_t crc32(uint32_t crc, const void* data, size_t length);
+
+#endif // CHECKSUM_H
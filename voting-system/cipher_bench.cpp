@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "vote_cipher.h"
+
+// Vote encryption throughput: the old per-vote XOR of a digit string (as
+// main.cpp's encryptVote()/decryptVote() were) vs. ChaCha20 ballots sealed
+// and opened one at a time and in batches. Checks the RFC 8439 block
+// vector first, and that tampered ballots are rejected.
+// Usage: cipher_bench [votes]
+
+#define BATCH 1024
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void xorEncrypt(int candidateId, char* output) {
+    char key[] = "SimpleKey123";
+    sprintf(output, "%d", candidateId);
+    for (int i = 0; output[i]; i++) output[i] ^= key[i % strlen(key)];
+}
+
+static int xorDecrypt(const char* encrypted) {
+    char key[] = "SimpleKey123";
+    char temp[100];
+    strcpy(temp, encrypted);
+    for (int i = 0; temp[i]; i++) temp[i] ^= key[i % strlen(key)];
+    return atoi(temp);
+}
+
+// RFC 8439 section 2.3.2
+static int checkBlockVector() {
+    uint8_t keyBytes[32], nonce[VOTE_NONCE_BYTES] = {0, 0, 0, 9, 0, 0, 0, 0x4a, 0, 0, 0, 0}, out[64];
+    for (int i = 0; i < 32; i++) keyBytes[i] = (uint8_t)i;
+    VoteCipher cipher;
+    initVoteCipher(&cipher, keyBytes);
+    chacha20Block(cipher.key, 1, nonce, out);
+    static const uint8_t expected[16] = {0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15,
+                                         0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4};
+    return memcmp(out, expected, sizeof(expected)) == 0;
+}
+
+static void report(const char* name, long votes, double seconds, long checksum) {
+    printf("%-16s %6.2f s  %6.1f M votes/s  (%ld)\n", name, seconds, votes / seconds / 1e6, checksum);
+}
+
+int main(int argc, char** argv) {
+    long votes = argc > 1 ? atol(argv[1]) : 10000000L;
+    if (!checkBlockVector()) {
+        printf("ChaCha20 block does not match RFC 8439!\n");
+        return 1;
+    }
+
+    int* ids = (int*)malloc(sizeof(int) * votes);
+    int* opened = (int*)malloc(sizeof(int) * votes);
+    VoteBallot* ballots = (VoteBallot*)malloc(sizeof(VoteBallot) * votes);
+    uint64_t* voters = (uint64_t*)malloc(sizeof(uint64_t) * (votes > BATCH ? votes : BATCH));
+    if (!ids || !opened || !ballots || !voters) return 1;
+    for (long i = 0; i < votes; i++) ids[i] = 1 + (int)(i * 7919 % 1000);
+    for (long i = 0; i < (votes > BATCH ? votes : BATCH); i++) voters[i] = (uint64_t)i * 0x9E3779B97F4A7C15ull;
+
+    Clock::time_point start = Clock::now();
+    long checksum = 0;
+    char encrypted[100];
+    for (long i = 0; i < votes; i++) {
+        xorEncrypt(ids[i], encrypted);
+        checksum += xorDecrypt(encrypted);
+    }
+    report("xor round trip:", votes, secondsSince(start), checksum);
+
+    uint8_t key[VOTE_KEY_BYTES];
+    for (int i = 0; i < VOTE_KEY_BYTES; i++) key[i] = (uint8_t)(i * 37 + 11);
+    VoteCipher cipher;
+    initVoteCipher(&cipher, key);
+
+    start = Clock::now();
+    checksum = 0;
+    for (long i = 0; i < votes; i++) {
+        VoteBallot ballot;
+        int id;
+        sealVotes(&cipher, &ids[i], &voters[i], 1, &ballot);
+        openVotes(&cipher, &ballot, &voters[i], 1, &id);
+        checksum += id;
+    }
+    report("chacha one by one:", votes, secondsSince(start), checksum);
+
+    start = Clock::now();
+    for (long i = 0; i < votes; i += BATCH)
+        sealVotes(&cipher, ids + i, voters + i, votes - i < BATCH ? (int)(votes - i) : BATCH, ballots + i);
+    double seal = secondsSince(start);
+    start = Clock::now();
+    for (long i = 0; i < votes; i += BATCH)
+        openVotes(&cipher, ballots + i, voters + i, votes - i < BATCH ? (int)(votes - i) : BATCH, opened + i);
+    double open = secondsSince(start);
+    checksum = 0;
+    for (long i = 0; i < votes; i++) checksum += opened[i];
+    report("chacha batched:", votes, seal + open, checksum);
+    printf("  seal %.1f M/s, open %.1f M/s, %s\n", votes / seal / 1e6, votes / open / 1e6,
+           memcmp(ids, opened, sizeof(int) * votes) == 0 ? "round trip ok" : "ROUND TRIP FAILED");
+
+    // The same candidate a thousand times should give unrelated ciphertexts
+    int one[BATCH];
+    for (int i = 0; i < BATCH; i++) one[i] = 1;
+    sealVotes(&cipher, one, voters, BATCH, ballots);
+    int repeats = 0;
+    for (int i = 1; i < BATCH; i++) repeats += memcmp(ballots[i].sealed, ballots[0].sealed, 4) == 0;
+    printf("  %d of %d ballots for one candidate repeat the first ciphertext\n", repeats, BATCH - 1);
+
+    // A ballot opened for another voter, as if copied into their row, must
+    // not go unnoticed
+    openVotes(&cipher, ballots, voters + 1, BATCH, one);
+    int accepted = 0;
+    for (int i = 0; i < BATCH; i++) accepted += one[i] != VOTE_TAMPERED;
+    printf("  %d of %d ballots opened for another voter\n", accepted, BATCH);
+
+    // Nor must flipping sealed bits (vote 1 -> vote 2)
+    for (int i = 0; i < BATCH; i++) ballots[i].sealed[0] ^= 1 ^ 2;
+    openVotes(&cipher, ballots, voters, BATCH, one);
+    accepted = 0;
+    for (int i = 0; i < BATCH; i++) accepted += one[i] != VOTE_TAMPERED;
+    printf("  %d of %d tampered ballots opened\n", accepted, BATCH);
+
+    free(ids);
+    free(opened);
+    free(ballots);
+    free(voters);
+    return 0;
+}
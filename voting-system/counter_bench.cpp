@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "vote_counters.h"
+
+// Per-vote cost of the live counts at 1 to 64 voting threads: one shared
+// array of atomic counts (every thread hits the same few cache lines)
+// against VoteCounters' per-thread slabs, with a reader publishing a
+// results snapshot every millisecond throughout. Each run checks that the
+// final snapshot counts every vote.
+// Usage: counter_bench [votes per thread] [candidates]
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Runs threads x votes calls of vote(thread, candidate) and returns ns per
+// vote of wall time
+template <typename Vote>
+static double run(int threads, long votes, int candidates, Vote vote) {
+    std::vector<std::thread> voters;
+    Clock::time_point start = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        voters.emplace_back([=] {
+            unsigned seed = 12345u + t;
+            for (long v = 0; v < votes; v++) {
+                seed = seed * 1103515245u + 12345u;
+                vote((int)((seed >> 16) % candidates));
+            }
+        });
+    }
+    for (std::thread& t : voters) t.join();
+    return secondsSince(start) * 1e9 / ((double)threads * votes);
+}
+
+int main(int argc, char** argv) {
+    long votes = argc > 1 ? atol(argv[1]) : 2000000L;
+    int candidates = argc > 2 ? atoi(argv[2]) : 8;
+    if (votes < 1 || candidates < 1) return 1;
+    printf("%ld votes per thread, %d candidates, %u core(s)\n", votes, candidates, std::thread::hardware_concurrency());
+    printf("threads  shared ns/vote  sharded ns/vote  snapshots\n");
+
+    int bad = 0;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        std::vector<std::atomic<long>> shared(candidates);
+        for (std::atomic<long>& c : shared) c = 0;
+        double sharedNs = run(threads, votes, candidates, [&](int c) { shared[c].fetch_add(1, std::memory_order_relaxed); });
+
+        VoteCounters* counters = createVoteCounters(candidates, 0);
+        if (!counters) return 1;
+        std::atomic<bool> done{false};
+        long published = 0;
+        std::thread reader([&] {
+            while (!done) {
+                countersPublish(counters, candidates, (uint64_t)published++);
+                const VoteCountSnapshot* s = countersAcquire(counters);
+                countersRelease(counters, s);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        double shardedNs = run(threads, votes, candidates, [&](int c) { countersAdd(counters, c, 1); });
+        done = true;
+        reader.join();
+
+        countersPublish(counters, candidates, (uint64_t)published);
+        const VoteCountSnapshot* s = countersAcquire(counters);
+        long sharedTotal = 0;
+        for (std::atomic<long>& c : shared) sharedTotal += c;
+        if (!s || s->total != (int64_t)threads * votes || sharedTotal != (long)threads * votes) bad = 1;
+        for (int rank = 1; s && rank < s->count; rank++) {
+            if (s->votes[s->order[rank]] > s->votes[s->order[rank - 1]]) bad = 1;
+        }
+        printf("%7d %15.2f %16.2f %10ld\n", threads, sharedNs, shardedNs, published);
+        countersRelease(counters, s);
+        destroyVoteCounters(counters);
+    }
+    printf("totals and ranking: %s\n", bad ? "MISMATCH" : "ok");
+    return bad;
+}
@@ -0,0 +1,37 @@
+#include "durable_file.h"
+
+#include <string.h>
+#include <string>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+int syncFile(FILE* file) {
+    return fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+int syncParentDirectory(const char* path) {
+#ifdef _WIN32
+    (void)path;
+    return 1;
+#else
+    const char* slash = strrchr(path, '/');
+    std::string dir = slash ? std::string(path, slash == path ? 1 : slash - path) : std::string(".");
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return 0;
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+int replaceFileDurably(const char* tmp, const char* path) {
+#ifdef _WIN32
+    remove(path);
+#endif
+    return rename(tmp, path) == 0 && syncParentDirectory(path);
+}
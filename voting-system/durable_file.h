@@ -0,0 +1,17 @@
+#ifndef DURABLE_FILE_H
+#define DURABLE_FILE_H
+
+// Helpers for files that must survive a power loss once written: flush and
+// fsync a stream, fsync the directory holding a path (so a rename or create
+// in it is durable), and replace a file with a fully synced temp file.
+
+#include <stdio.h>
+
+// fflush + fsync; returns 0 on failure. The stream stays open.
+int syncFile(FILE* file);
+// fsync of the directory containing path; a no-op returning 1 on Windows
+int syncParentDirectory(const char* path);
+// Renames tmp over path and syncs the directory. tmp must already be synced.
+int replaceFileDurably(const char* tmp, const char* path);
+
+#endif // DURABLE_FILE_H
@@ -0,0 +1,157 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "record_store.h"
+#include "user_import.h"
+
+// Voter-roll import: a generated CSV with a known share of bad rows goes
+// through importUsers() into the same kind of user table main.cpp keeps,
+// on one thread and on all of them, and the table is then written out once
+// the way the users.txt snapshot is.
+// Usage: import_bench [rows]
+
+#define BENCH_FILE "bench_roll.csv"
+#define SNAPSHOT_FILE "bench_users.txt"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+typedef struct {
+    StrRef username, password, fullName;
+} BenchUser;
+
+typedef struct {
+    RecordStore users;
+    StringArena strings;
+    StringIndex index;
+} Table;
+
+static const char* benchUsername(int slot, void* ctx) {
+    Table* table = (Table*)ctx;
+    return arenaGet(&table->strings, ((BenchUser*)storeAt(&table->users, slot))->username);
+}
+
+static int passwordOk(const char* password) {
+    int hasDigit = 0, hasUpper = 0, hasSpecial = 0;
+    if (strlen(password) < 8) return 0;
+    for (int i = 0; password[i]; i++) {
+        if (isdigit(password[i])) hasDigit = 1;
+        else if (isupper(password[i])) hasUpper = 1;
+        else if (!isalnum(password[i])) hasSpecial = 1;
+    }
+    return hasDigit && hasUpper && hasSpecial;
+}
+
+static int exists(const char* username, uint64_t hash, void* ctx) {
+    return stringIndexFindHashed(&((Table*)ctx)->index, username, hash) >= 0;
+}
+
+static int accept(ImportRow* row, void* ctx) {
+    Table* table = (Table*)ctx;
+    BenchUser* u = (BenchUser*)storePush(&table->users);
+    if (!u) return 0;
+    u->username = arenaAdd(&table->strings, row->username);
+    u->password = arenaAdd(&table->strings, row->password);
+    u->fullName = arenaAdd(&table->strings, row->fullName);
+    return stringIndexInsertHashed(&table->index, row->usernameHash, table->users.count - 1);
+}
+
+// One row in 200 is bad, one in 500 repeats an earlier username, and one
+// in 50 has a quoted name with a comma. Returns the expected reason.
+static ImportReason writeRow(FILE* file, long i) {
+    long kind = i % 1000;
+    if (i >= 1000 && kind == 7) {
+        fprintf(file, "voter%ld@example.com,Dup%ld!pass,Repeat Voter\n", i - 999, i);
+        return IMPORT_DUPLICATE;
+    }
+    if (kind == 3 || kind == 503) {
+        fprintf(file, "voter%ld@example.com,weakpass,Weak Password\n", i);
+        return IMPORT_WEAK_PASSWORD;
+    }
+    if (kind == 13 || kind == 513) {
+        fprintf(file, "voter%ld@example.com,Pass%ld!xy\n", i, i);
+        return IMPORT_FIELD_COUNT;
+    }
+    if (kind == 23 || kind == 523) {
+        fprintf(file, "voter%ld@example.com,Pass%ld!xy,%0120d\n", i, i, 0);
+        return IMPORT_TOO_LONG;
+    }
+    if (kind == 33 || kind == 533) {
+        fprintf(file, "voter %ld@example.com,Pass%ld!xy,Space In Name\n", i, i);
+        return IMPORT_BAD_CHARACTERS;
+    }
+    if (kind % 50 == 1) fprintf(file, "voter%ld@example.com,Pass%ld!xy,\"Voter, Number %ld\"\n", i, i, i);
+    else fprintf(file, "voter%ld@example.com,Pass%ld!xy,Voter Number %ld\n", i, i, i);
+    return IMPORT_OK;
+}
+
+int main(int argc, char** argv) {
+    long rows = argc > 1 ? atol(argv[1]) : 10000000L;
+
+    long expected[IMPORT_REASONS];
+    memset(expected, 0, sizeof(expected));
+    FILE* file = fopen(BENCH_FILE, "w");
+    if (!file) return 1;
+    fprintf(file, "username,password,full name\n");
+    for (long i = 0; i < rows; i++) expected[writeRow(file, i)]++;
+    long size = ftell(file);
+    fclose(file);
+    printf("%ld rows, %.0f MB\n", rows, size / 1048576.0);
+
+    int bad = 0;
+    for (int threads = 1; threads >= 0; threads--) {
+        Table table;
+        initRecordStore(&table.users, sizeof(BenchUser));
+        if (!initStringArena(&table.strings) || !initStringIndex(&table.index, 1024, benchUsername, &table)) return 1;
+        ImportHandler handler;
+        memset(&handler, 0, sizeof(handler));
+        handler.passwordOk = passwordOk;
+        handler.exists = exists;
+        handler.accept = accept;
+        handler.ctx = &table;
+        handler.threads = threads;
+
+        ImportStats stats;
+        Clock::time_point start = Clock::now();
+        int ok = importUsers(BENCH_FILE, &handler, &stats);
+        double seconds = secondsSince(start);
+        printf("import, %s: %6.2f s  %5.2f M rows/s  %ld accepted\n", threads ? "1 thread  " : "all cores ",
+               seconds, rows / seconds / 1e6, stats.accepted);
+        for (int r = 0; r < IMPORT_REASONS; r++) {
+            long got = r == IMPORT_OK ? stats.accepted : stats.rejected[r];
+            if (got != expected[r]) {
+                printf("  %s: %ld, expected %ld\n", importReasonText((ImportReason)r), got, expected[r]);
+                bad = 1;
+            }
+        }
+        if (!ok || stats.rows != rows) bad = 1;
+
+        if (threads == 0) {
+            start = Clock::now();
+            file = fopen(SNAPSHOT_FILE, "w");
+            if (!file) return 1;
+            for (int i = 0; i < table.users.count; i++) {
+                const BenchUser* u = (const BenchUser*)storeAt(&table.users, i);
+                fprintf(file, "%s\t%s\t%s\t1\t0\n", arenaGet(&table.strings, u->username),
+                        arenaGet(&table.strings, u->password), arenaGet(&table.strings, u->fullName));
+            }
+            fclose(file);
+            printf("snapshot, one pass:  %6.2f s\n", secondsSince(start));
+        }
+        freeStringIndex(&table.index);
+        freeStringArena(&table.strings);
+        freeRecordStore(&table.users);
+    }
+    long rejected = rows - expected[IMPORT_OK];
+    printf("%ld rejected rows, %s\n", rejected, bad ? "MISMATCH" : "all with the expected reason");
+
+    remove(BENCH_FILE);
+    remove(SNAPSHOT_FILE);
+    return bad;
+}
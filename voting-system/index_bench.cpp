@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "string_index.h"
+
+// Login lookup: linear strcmp scan over users[] vs. the username index.
+// Records mirror User's 100-byte username field. Usage: index_bench [users]
+
+#define MAX_STRING 100
+
+using Clock = std::chrono::steady_clock;
+
+typedef struct {
+    char username[MAX_STRING];
+} BenchUser;
+
+static BenchUser* users;
+
+static const char* userName(int slot, void* ctx) {
+    (void)ctx;
+    return users[slot].username;
+}
+
+static double nsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    users = (BenchUser*)malloc(sizeof(BenchUser) * count);
+    if (!users) return 1;
+    for (int i = 0; i < count; i++) snprintf(users[i].username, MAX_STRING, "voter%d@example.com", i);
+
+    Clock::time_point start = Clock::now();
+    StringIndex index;
+    initStringIndex(&index, count, userName, NULL);
+    for (int i = 0; i < count; i++) stringIndexInsert(&index, users[i].username, i);
+    printf("build:  %d users in %.0f ms, %.0f MB of index\n", count, nsSince(start) / 1e6,
+           (index.mask + 1) * sizeof(IndexEntry) / 1048576.0);
+
+    // Random logins, so nearly every probe misses the cache
+    int lookups = 2000000;
+    char name[MAX_STRING];
+    long found = 0;
+    unsigned seed = 12345;
+    start = Clock::now();
+    for (int i = 0; i < lookups; i++) {
+        seed = seed * 1103515245u + 12345u;
+        snprintf(name, MAX_STRING, "voter%d@example.com", (int)(seed % (unsigned)count));
+        if (stringIndexFind(&index, name) >= 0) found++;
+    }
+    printf("index:  %.0f ns/login (%ld found)\n", nsSince(start) / lookups, found);
+
+    int scans = 200;
+    found = 0;
+    start = Clock::now();
+    for (int i = 0; i < scans; i++) {
+        seed = seed * 1103515245u + 12345u;
+        snprintf(name, MAX_STRING, "voter%d@example.com", (int)(seed % (unsigned)count));
+        for (int u = 0; u < count; u++) {
+            if (strcmp(users[u].username, name) == 0) {
+                found++;
+                break;
+            }
+        }
+    }
+    printf("scan:   %.0f ns/login (%ld found)\n", nsSince(start) / scans, found);
+
+    freeStringIndex(&index);
+    free(users);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "leaderboard.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void initLeaderboard(Leaderboard* board) {
+    memset(board, 0, sizeof(Leaderboard));
+}
+
+void freeLeaderboard(Leaderboard* board) {
+    free(board->order);
+    free(board->position);
+    free(board->counts);
+    initLeaderboard(board);
+}
+
+static int grow(Leaderboard* board) {
+    int capacity = board->capacity ? board->capacity * 2 : 16;
+    int* order = (int*)realloc(board->order, sizeof(int) * capacity);
+    if (order) board->order = order;
+    int* position = (int*)realloc(board->position, sizeof(int) * capacity);
+    if (position) board->position = position;
+    int64_t* counts = (int64_t*)realloc(board->counts, sizeof(int64_t) * capacity);
+    if (counts) board->counts = counts;
+    if (!order || !position || !counts) return 0;
+    board->capacity = capacity;
+    return 1;
+}
+
+static void swapRanks(Leaderboard* board, int a, int b) {
+    int itemA = board->order[a], itemB = board->order[b];
+    board->order[a] = itemB;
+    board->order[b] = itemA;
+    board->position[itemA] = b;
+    board->position[itemB] = a;
+}
+
+// Moves the item at rank from to rank to, shifting the ones in between
+static void moveRank(Leaderboard* board, int from, int to) {
+    int item = board->order[from];
+    int step = from < to ? 1 : -1;
+    for (int rank = from; rank != to; rank += step) {
+        board->order[rank] = board->order[rank + step];
+        board->position[board->order[rank]] = rank;
+    }
+    board->order[to] = item;
+    board->position[item] = to;
+}
+
+int leaderboardAdd(Leaderboard* board, int64_t votes) {
+    if (board->count == board->capacity && !grow(board)) return 0;
+    int item = board->count++;
+    board->counts[item] = votes;
+    board->order[item] = item;
+    board->position[item] = item;
+    for (int rank = item; rank > 0 && board->counts[board->order[rank - 1]] < votes; rank--)
+        swapRanks(board, rank - 1, rank);
+    return 1;
+}
+
+void leaderboardIncrement(Leaderboard* board, int item) {
+    int rank = board->position[item];
+    int64_t votes = board->counts[item];
+    // First rank in [0, rank] whose count equals votes; everything before it
+    // has more
+    int lo = 0, hi = rank;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (board->counts[board->order[mid]] > votes) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo != rank) swapRanks(board, lo, rank);
+    board->counts[item] = votes + 1;
+}
+
+void leaderboardSet(Leaderboard* board, int item, int64_t votes) {
+    int64_t old = board->counts[item];
+    if (votes == old + 1) {
+        leaderboardIncrement(board, item);
+        return;
+    }
+    int rank = board->position[item];
+    int lo, hi;
+    if (votes > old) {
+        // First rank in [0, rank] whose count is below votes
+        lo = 0, hi = rank;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (board->counts[board->order[mid]] >= votes) lo = mid + 1;
+            else hi = mid;
+        }
+    } else {
+        // Last rank in [rank, count - 1] whose count is above votes
+        lo = rank, hi = board->count - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (board->counts[board->order[mid]] > votes) lo = mid;
+            else hi = mid - 1;
+        }
+    }
+    if (lo != rank) moveRank(board, rank, lo);
+    board->counts[item] = votes;
+}
+
+int leaderboardTop(const Leaderboard* board, int k, int* out) {
+    if (k > board->count) k = board->count;
+    if (k > 0) memcpy(out, board->order, sizeof(int) * k);
+    return k;
+}
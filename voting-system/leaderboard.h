@@ -0,0 +1,43 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+// Live ranking of items (candidate slots) by vote count, highest first.
+// A count that goes up by one swaps its item with the first item of its tie
+// run, found by binary search: O(log n) per vote. A larger change moves the
+// item past the items it overtakes. The ranking is always sorted, so reading
+// the top K is O(K). Items are numbered 0..count-1 in the order they are
+// added. Ties have no fixed order. Not thread-safe.
+
+#include <stdint.h>
+
+typedef struct {
+    int* order;                 // rank -> item
+    int* position;              // item -> rank
+    int64_t* counts;            // item -> votes
+    int count;
+    int capacity;
+} Leaderboard;
+
+void initLeaderboard(Leaderboard* board);
+void freeLeaderboard(Leaderboard* board);
+
+// Adds item number board->count with an initial count. O(n); candidates are
+// rarely added. Returns 0 if memory could not be allocated.
+int leaderboardAdd(Leaderboard* board, int64_t votes);
+void leaderboardIncrement(Leaderboard* board, int item);
+// Sets an item's count, moving it up or down the ranking
+void leaderboardSet(Leaderboard* board, int item, int64_t votes);
+
+// Item at rank (0 = leading)
+static inline int leaderboardAt(const Leaderboard* board, int rank) {
+    return board->order[rank];
+}
+
+static inline int64_t leaderboardVotes(const Leaderboard* board, int item) {
+    return board->counts[item];
+}
+
+// Copies up to k leading items into out and returns how many
+int leaderboardTop(const Leaderboard* board, int k, int* out);
+
+#endif // LEADERBOARD_H
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "leaderboard.h"
+
+// Results refresh: the old bubble sort of every candidate vs. reading the top
+// of the live Leaderboard, plus the per-vote cost of keeping it ranked and
+// the cost of applying a publish's worth of counts at once, as VoteCounters
+// does.
+// Usage: leaderboard_bench [candidates] [votes]
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int candidates = argc > 1 ? atoi(argv[1]) : 1000;
+    long votes = argc > 2 ? atol(argv[2]) : 10000000L;
+    if (candidates < 10) return 1;
+
+    Leaderboard board;
+    initLeaderboard(&board);
+    for (int i = 0; i < candidates; i++) leaderboardAdd(&board, 0);
+    int* counts = (int*)calloc(candidates, sizeof(int));
+
+    // Skewed towards low-numbered candidates, so ties break up over time
+    unsigned seed = 12345;
+    Clock::time_point start = Clock::now();
+    for (long v = 0; v < votes; v++) {
+        seed = seed * 1103515245u + 12345u;
+        int item = (int)((seed >> 8) % (unsigned)candidates);
+        if (seed & 1) item /= 4;
+        leaderboardIncrement(&board, item);
+    }
+    printf("vote:    %.1f ns/increment over %d candidates\n", nsSince(start) / votes, candidates);
+
+    // Batches of counts moved up by a few votes each, some back down
+    int publishes = 10000;
+    start = Clock::now();
+    for (int p = 0; p < publishes; p++) {
+        for (int k = 0; k < 8; k++) {
+            seed = seed * 1103515245u + 12345u;
+            int item = (int)((seed >> 8) % (unsigned)candidates);
+            int64_t votes = leaderboardVotes(&board, item) + (int64_t)(seed >> 28) - 2;
+            leaderboardSet(&board, item, votes < 0 ? 0 : votes);
+        }
+    }
+    printf("publish: %.1f ns/count set\n", nsSince(start) / (publishes * 8.0));
+
+    for (int i = 0; i < candidates; i++) counts[i] = (int)leaderboardVotes(&board, i);
+    for (int rank = 1; rank < candidates; rank++) {
+        if (leaderboardVotes(&board, leaderboardAt(&board, rank - 1)) <
+            leaderboardVotes(&board, leaderboardAt(&board, rank))) {
+            printf("ranking out of order at %d\n", rank);
+            return 1;
+        }
+    }
+
+    int top[10];
+    int refreshes = 1000000;
+    long checksum = 0;
+    start = Clock::now();
+    for (int r = 0; r < refreshes; r++) {
+        int k = leaderboardTop(&board, 10, top);
+        checksum += top[k - 1];
+    }
+    printf("top-10:  %.1f ns/refresh (%ld)\n", nsSince(start) / refreshes, checksum);
+
+    // Baseline: showResults() before, bubble sort of a scrambled copy
+    int sorts = 20;
+    int* sorted = (int*)malloc(sizeof(int) * candidates);
+    start = Clock::now();
+    for (int r = 0; r < sorts; r++) {
+        for (int i = 0; i < candidates; i++) sorted[i] = counts[(i * 7919 + r) % candidates];
+        for (int i = 0; i < candidates - 1; i++) {
+            for (int j = 0; j < candidates - i - 1; j++) {
+                if (sorted[j] < sorted[j + 1]) {
+                    int temp = sorted[j];
+                    sorted[j] = sorted[j + 1];
+                    sorted[j + 1] = temp;
+                }
+            }
+        }
+        checksum += sorted[0];
+    }
+    printf("bubble:  %.0f ns/refresh (%ld)\n", nsSince(start) / sorts, checksum);
+
+    free(sorted);
+    free(counts);
+    freeLeaderboard(&board);
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "line_loader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "mapped_file.h"
+#include "string_index.h"
+
+#define LOADER_SLICE_BYTES (4 << 20)
+#define LOADER_MAX_THREADS 16
+
+static void splitLine(const char* line, size_t length, ParsedLine* out) {
+    const char* end = line + length;
+    out->line = line;
+    out->count = 0;
+    out->tabs = memchr(line, '\t', length) != NULL;
+    if (out->tabs) {
+        const char* p = line;
+        while (out->count < LOADER_MAX_FIELDS - 1) {
+            const char* tab = (const char*)memchr(p, '\t', end - p);
+            if (!tab) break;
+            out->fields[out->count++] = {(uint32_t)(p - line), (uint32_t)(tab - p)};
+            p = tab + 1;
+        }
+        out->fields[out->count++] = {(uint32_t)(p - line), (uint32_t)(end - p)};
+    } else {
+        const char* p = line;
+        while (p < end) {
+            while (p < end && *p == ' ') p++;
+            if (p == end) break;
+            const char* start = p;
+            if (out->count == LOADER_MAX_FIELDS - 1) p = end;
+            while (p < end && *p != ' ') p++;
+            out->fields[out->count++] = {(uint32_t)(start - line), (uint32_t)(p - start)};
+        }
+    }
+    out->keyHash = out->count ? hashString(line + out->fields[0].offset, out->fields[0].length) : 0;
+}
+
+typedef struct {
+    const char* start;
+    const char* end;
+    ParsedLine* lines;
+    long count;
+    long capacity;
+    int failed;                 // out of memory: lines is incomplete
+} Slice;
+
+// Newline search is memchr, which libc vectorises
+static void parseSlice(Slice* slice) {
+    slice->count = 0;
+    slice->failed = 0;
+    const char* p = slice->start;
+    while (p < slice->end) {
+        const char* newline = (const char*)memchr(p, '\n', slice->end - p);
+        const char* lineEnd = newline ? newline : slice->end;
+        size_t length = lineEnd - p;
+        if (length > 0 && p[length - 1] == '\r') length--;
+        if (length > 0) {
+            if (slice->count == slice->capacity) {
+                long capacity = slice->capacity ? slice->capacity * 2 : 4096;
+                ParsedLine* lines = (ParsedLine*)realloc(slice->lines, sizeof(ParsedLine) * capacity);
+                if (!lines) {
+                    slice->failed = 1;
+                    return;
+                }
+                slice->lines = lines;
+                slice->capacity = capacity;
+            }
+            splitLine(p, length, &slice->lines[slice->count]);
+            if (slice->lines[slice->count].count > 0) slice->count++;
+        }
+        p = lineEnd + 1;
+    }
+}
+
+// Cuts the next round of up to `threads` slices starting at *pos
+static int cutRound(const MappedFile* file, size_t* pos, Slice* slices, int threads) {
+    int n = 0;
+    while (n < threads && *pos < file->length) {
+        size_t start = *pos, end = start + LOADER_SLICE_BYTES;
+        if (end >= file->length) {
+            end = file->length;
+        } else {
+            const char* newline = (const char*)memchr(file->data + end, '\n', file->length - end);
+            end = newline ? newline - file->data + 1 : file->length;
+        }
+        slices[n].start = file->data + start;
+        slices[n].end = file->data + end;
+        n++;
+        *pos = end;
+    }
+    return n;
+}
+
+long loadLines(const char* path, LineHandler handler, void* ctx) {
+    MappedFile file;
+    if (!mapFile(path, &file)) return -1;
+
+    int threads = (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    if (threads > LOADER_MAX_THREADS) threads = LOADER_MAX_THREADS;
+
+    // Two rounds of slices: workers parse one while this thread consumes
+    // the other
+    Slice rounds[2][LOADER_MAX_THREADS];
+    memset(rounds, 0, sizeof(rounds));
+    size_t pos = 0;
+    long total = 0;
+    std::thread workers[LOADER_MAX_THREADS];
+    int ready = cutRound(&file, &pos, rounds[0], threads);
+    for (int i = 0; i < ready; i++) workers[i] = std::thread(parseSlice, &rounds[0][i]);
+    for (int i = 0; i < ready; i++) workers[i].join();
+
+    for (int round = 0; ready > 0; round ^= 1) {
+        int failed = 0;
+        for (int i = 0; i < ready; i++) failed |= rounds[round][i].failed;
+        if (failed) {
+            total = LOADER_NO_MEMORY;
+            break;
+        }
+        Slice* next = rounds[round ^ 1];
+        int pending = cutRound(&file, &pos, next, threads);
+        for (int i = 0; i < pending; i++) workers[i] = std::thread(parseSlice, &next[i]);
+
+        for (int i = 0; i < ready; i++) {
+            Slice* slice = &rounds[round][i];
+            for (long l = 0; l < slice->count; l++) handler(&slice->lines[l], ctx);
+            total += slice->count;
+        }
+
+        for (int i = 0; i < pending; i++) workers[i].join();
+        ready = pending;
+    }
+
+    for (int r = 0; r < 2; r++) {
+        for (int i = 0; i < LOADER_MAX_THREADS; i++) free(rounds[r][i].lines);
+    }
+    unmapFile(&file);
+    return total;
+}
+
+void fieldSpan(const ParsedLine* line, int first, int last, char* dest, size_t size) {
+    size_t length = 0;
+    if (first <= last && last < line->count) {
+        const LineField* a = &line->fields[first];
+        const LineField* b = &line->fields[last];
+        length = b->offset + b->length - a->offset;
+        if (length > size - 1) length = size - 1;
+        memcpy(dest, line->line + a->offset, length);
+    }
+    dest[length] = 0;
+}
+
+long fieldLong(const ParsedLine* line, int i) {
+    char buffer[32];
+    fieldSpan(line, i, i, buffer, sizeof(buffer));
+    return atol(buffer);
+}
@@ -0,0 +1,45 @@
+#ifndef LINE_LOADER_H
+#define LINE_LOADER_H
+
+// Bulk loader for the snapshot files. The file is memory-mapped and cut
+// into slices at line boundaries; worker threads split the lines of one
+// round of slices into fields (and hash the first field) while the calling
+// thread hands the previous round to the handler, in file order.
+//
+// A line containing a tab is split on tabs, which is how snapshots are
+// written now. Otherwise it is a legacy space-separated line: fields are
+// runs of non-spaces, and a handler that expects free text (names, audit
+// details) takes the span from one field to the end of a later one.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOADER_MAX_FIELDS 8
+#define LOADER_NO_MEMORY -2
+
+typedef struct {
+    uint32_t offset;            // from the start of the line
+    uint32_t length;            // not NUL-terminated
+} LineField;
+
+typedef struct {
+    const char* line;
+    uint64_t keyHash;           // hashString() of fields[0]
+    int count;                  // extra fields are merged into the last one
+    int tabs;                   // 0 for a legacy space-separated line
+    LineField fields[LOADER_MAX_FIELDS];
+} ParsedLine;
+
+typedef void (*LineHandler)(const ParsedLine* line, void* ctx);
+
+// Calls handler for every non-empty line. Returns the number of lines, -1
+// if the file could not be opened, or LOADER_NO_MEMORY if it ran out of
+// memory partway (handler has then seen only a prefix of the file).
+long loadLines(const char* path, LineHandler handler, void* ctx);
+
+// Copies fields [first, last] of line, with whatever separated them, into
+// dest as a NUL-terminated string of at most size - 1 bytes
+void fieldSpan(const ParsedLine* line, int first, int last, char* dest, size_t size);
+long fieldLong(const ParsedLine* line, int i);
+
+#endif // LINE_LOADER_H
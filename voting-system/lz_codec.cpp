@@ -0,0 +1,131 @@
+#include "lz_codec.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 14
+
+static inline uint32_t read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+size_t lzCompressBound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+// Lengths of 15 and more continue in bytes of up to 255 each
+static char* putLength(char* op, size_t length) {
+    for (; length >= 255; length -= 255) *op++ = (char)255;
+    *op++ = (char)length;
+    return op;
+}
+
+// One sequence; matchLength 0 for the final, literals-only one. Returns
+// NULL if it does not fit.
+static char* emit(char* op, const char* end, const char* literals, size_t literalLength,
+                  size_t offset, size_t matchLength) {
+    size_t need = 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1;
+    if ((size_t)(end - op) < need) return NULL;
+    char* token = op++;
+    uint8_t high = literalLength >= 15 ? 15 : (uint8_t)literalLength;
+    if (high == 15) op = putLength(op, literalLength - 15);
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+    if (matchLength == 0) {
+        *token = (char)(high << 4);
+        return op;
+    }
+    *op++ = (char)(offset & 0xFF);
+    *op++ = (char)(offset >> 8);
+    size_t extra = matchLength - LZ_MIN_MATCH;
+    uint8_t low = extra >= 15 ? 15 : (uint8_t)extra;
+    if (low == 15) op = putLength(op, extra - 15);
+    *token = (char)(high << 4 | low);
+    return op;
+}
+
+size_t lzCompress(const char* src, size_t length, char* dest, size_t capacity) {
+    uint32_t table[1 << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+    const char* ip = src;
+    const char* anchor = src;
+    const char* end = src + length;
+    char* op = dest;
+    const char* destEnd = dest + capacity;
+
+    while (length >= LZ_MIN_MATCH && ip <= end - LZ_MIN_MATCH) {
+        uint32_t sequence = read32(ip);
+        uint32_t h = hash4(sequence);
+        const char* ref = src + table[h];
+        table[h] = (uint32_t)(ip - src);
+        if (ref >= ip || ip - ref > LZ_MAX_OFFSET || read32(ref) != sequence) {
+            ip++;
+            continue;
+        }
+        const char* matchEnd = ip + LZ_MIN_MATCH;
+        ref += LZ_MIN_MATCH;
+        while (matchEnd < end && *matchEnd == *ref) {
+            matchEnd++;
+            ref++;
+        }
+        op = emit(op, destEnd, anchor, ip - anchor, matchEnd - ref, matchEnd - ip);
+        if (!op) return 0;
+        ip = anchor = matchEnd;
+    }
+    op = emit(op, destEnd, anchor, end - anchor, 0, 0);
+    return op ? (size_t)(op - dest) : 0;
+}
+
+// Adds continuation bytes to *length. Returns 0 if the input runs out.
+static int getLength(const uint8_t** ip, const uint8_t* end, size_t* length) {
+    uint8_t b;
+    do {
+        if (*ip >= end) return 0;
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+    return 1;
+}
+
+int lzDecompress(const char* src, size_t length, char* dest, size_t rawLength) {
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* end = ip + length;
+    char* op = dest;
+    char* destEnd = dest + rawLength;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(&ip, end, &literals)) return 0;
+        if (literals > (size_t)(end - ip) || literals > (size_t)(destEnd - op)) return 0;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == end) break;
+
+        if (end - ip < 2) return 0;
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t match = token & 15;
+        if (match == 15 && !getLength(&ip, end, &match)) return 0;
+        match += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - dest) || match > (size_t)(destEnd - op)) return 0;
+        const char* ref = op - offset;
+        if (offset >= match) {
+            memcpy(op, ref, match);
+            op += match;
+        } else {
+            // Overlapping: the match repeats its own output
+            while (match--) *op++ = *ref++;
+        }
+    }
+    return op == destEnd;
+}
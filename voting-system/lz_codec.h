@@ -0,0 +1,24 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+// Byte-oriented LZ77 block codec in the style of LZ4, for closed audit
+// segments. A block is a run of sequences, each a token byte (literal
+// length in the high nibble, match length - 4 in the low one; 15 means more
+// length bytes follow, each adding up to 255), the literals, and a 2-byte
+// little-endian match offset into the last 64 KB. The final sequence has
+// literals only. Matches are found through a hash table of 4-byte prefixes:
+// one probe per position, so compression is fast rather than tight.
+
+#include <stddef.h>
+
+// Largest compressed size for length input bytes
+size_t lzCompressBound(size_t length);
+
+// Returns the compressed size, or 0 if dest (capacity bytes) is too small
+size_t lzCompress(const char* src, size_t length, char* dest, size_t capacity);
+
+// Decodes exactly rawLength bytes into dest. Returns 0 if the input is
+// malformed or does not decode to rawLength bytes.
+int lzDecompress(const char* src, size_t length, char* dest, size_t rawLength);
+
+#endif // LZ_CODEC_H
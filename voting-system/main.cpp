@@ -3,81 +3,269 @@
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <algorithm>
+#include <chrono>
+#include <limits.h>
+#include <mutex>
+#include <shared_mutex>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#endif
+
+#include "audit_index.h"
+#include "audit_segments.h"
+#include "audit_writer.h"
+#include "bloom_filter.h"
+#include "durable_file.h"
+#include "line_loader.h"
+#include "password_pool.h"
+#include "rate_limiter.h"
+#include "secure_random.h"
+#include "record_store.h"
+#include "session_table.h"
+#include "string_index.h"
+#include "token_service.h"
+#include "user_import.h"
+#include "vote_cipher.h"
+#include "vote_counters.h"
+#include "vote_file.h"
+#include "vote_journal.h"
+#include "vote_server.h"
+#include "vote_tally.h"
 
 // Constants
-#define MAX_USERS 100
-#define MAX_CANDIDATES 50
-#define MAX_VOTES 100
-#define MAX_AUDIT_LOGS 200
 #define MAX_STRING 100
 #define RATE_LIMIT_WINDOW 60 // 1 minute in seconds
 #define MAX_REQUESTS 10
+#define AUDIT_PAGE 20
+#define IMPORT_SHOWN 10 // rejected rows printed; the rest go to the .rejects file
+#define IMPORT_HASH_BATCH 256
+#define PLAINTEXT_HASH_BATCH 256 // legacy passwords hashed at once at startup
+#define RESULTS_REFRESH_MS 100 // server mode serves results up to this old
 
-// Structs
+// Structs. Strings are StrRefs into the shared arena; a vote's userId is the
+// voter's own username ref, and repeated strings (audit actions and details)
+// are interned. A vote's candidate is a sealed ChaCha20 ballot, and a user's
+// password an scrypt hash (plaintext ones left from before hashing are
+// hashed at startup).
 typedef struct {
-    char username[MAX_STRING];
-    char password[MAX_STRING];
-    char fullName[MAX_STRING];
+    StrRef username;
+    StrRef password;
+    StrRef fullName;
     int isEmailVerified;
     int isAdmin;
 } User;
 
 typedef struct {
     int id;
-    char name[MAX_STRING];
-    char description[MAX_STRING];
-    int voteCount;
+    StrRef name;
+    StrRef description;
+    int voteCount;      // in candidates.txt, -1 if none; live counts are in voteCounters
 } Candidate;
 
 typedef struct {
-    char userId[MAX_STRING];
-    char encryptedCandidateId[MAX_STRING];
+    StrRef userId;
+    VoteBallot ballot;
     time_t voteDate;
 } Vote;
 
 typedef struct {
-    char userId[MAX_STRING];
-    char action[MAX_STRING];
+    StrRef userId;
+    StrRef action;
     time_t timestamp;
-    char details[MAX_STRING];
+    StrRef details;
 } AuditLog;
 
-typedef struct {
-    char userId[MAX_STRING];
-    time_t lastRequest;
-} RateLimit;
-
 // Global data
-User users[MAX_USERS];
-Candidate candidates[MAX_CANDIDATES];
-Vote votes[MAX_VOTES];
-AuditLog auditLogs[MAX_AUDIT_LOGS];
-RateLimit rateLimits[MAX_USERS];
-int userCount = 0, candidateCount = 0, voteCount = 0, auditCount = 0, rateLimitCount = 0;
+RecordStore users, candidates, votes, auditLogs;
+StringArena strings;
+RateLimiter* rateLimiter = NULL;
+TokenTable* tokens = NULL;
+PasswordPool* passwordPool = NULL;
+// Guards the stores in server mode (see serveRequest)
+static std::shared_mutex dataLock;
+// Live counts by candidate slot. Candidates never move in their store, and
+// their fields do not change once added, so results can be read from a
+// counts snapshot without holding dataLock.
+VoteCounters* voteCounters = NULL;
 
-// Utility Functions
-void generateVerificationToken(char* token) {
-    sprintf(token, "TOKEN%d", rand() % 10000);
+// Ballot key: $OVS_BALLOT_KEY, else ballot.key, 64 hex digits either way. A
+// data directory with neither gets a new random key in ballot.key, and
+// BALLOT_MIGRATE_FILE is created with it: the votes already there were
+// sealed under the key this program used to compile in, or are older XOR
+// strings. Those legacy formats are accepted and re-sealed only while that
+// file exists, and it is removed once a compaction has written every vote
+// back under the new key. (Moving legacy data to an $OVS_BALLOT_KEY setup
+// means creating it by hand.)
+#define BALLOT_KEY_ENV "OVS_BALLOT_KEY"
+#define BALLOT_KEY_FILE "ballot.key"
+#define BALLOT_MIGRATE_FILE "ballot.key.migrate"
+static const uint8_t legacyBallotKey[VOTE_KEY_BYTES] = "OnlineVotingSystem-BallotKey-v1";
+VoteCipher voteCipher;
+static VoteCipher legacyCipher;
+static int migratingBallots = 0;
+static long migratedVotes = 0, rejectedLegacyVotes = 0;
+
+static inline User* userAt(int i) { return (User*)storeAt(&users, i); }
+static inline Candidate* candidateAt(int i) { return (Candidate*)storeAt(&candidates, i); }
+static inline Vote* voteAt(int i) { return (Vote*)storeAt(&votes, i); }
+static inline AuditLog* auditAt(int i) { return (AuditLog*)storeAt(&auditLogs, i); }
+static inline const char* text(StrRef ref) { return arenaGet(&strings, ref); }
+
+// Time and per-user indexes over auditLogs[], for the admin audit view.
+// Only the live audit.txt segment is loaded; auditArchive lists the closed
+// segments that were skipped.
+AuditIndex auditIndex;
+AuditManifest auditArchive;
+
+static int64_t auditTime(uint32_t event, void* ctx) {
+    (void)ctx;
+    return auditAt((int)event)->timestamp;
+}
+
+static int parseBallotKey(const char* text, uint8_t key[VOTE_KEY_BYTES]) {
+    for (int i = 0; i < VOTE_KEY_BYTES; i++) {
+        unsigned int byte;
+        if (!isxdigit((unsigned char)text[2 * i]) || !isxdigit((unsigned char)text[2 * i + 1]) ||
+            sscanf(text + 2 * i, "%2x", &byte) != 1) return 0;
+        key[i] = (uint8_t)byte;
+    }
+    for (const char* p = text + 2 * VOTE_KEY_BYTES; *p; p++) {
+        if (!isspace((unsigned char)*p)) return 0;
+    }
+    return 1;
+}
+
+// Creates an empty file and makes it durable
+static int createMarker(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return 0;
+    int ok = syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    return ok && syncParentDirectory(path);
+}
+
+static int writeBallotKey(const uint8_t key[VOTE_KEY_BYTES]) {
+    FILE* file = fopen(BALLOT_KEY_FILE ".tmp", "w");
+    if (!file) return 0;
+#ifdef __linux__
+    fchmod(fileno(file), 0600);
+#endif
+    for (int i = 0; i < VOTE_KEY_BYTES; i++) fprintf(file, "%02x", key[i]);
+    fputc('\n', file);
+    int ok = syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    return ok && replaceFileDurably(BALLOT_KEY_FILE ".tmp", BALLOT_KEY_FILE);
+}
+
+static void loadBallotKey() {
+    uint8_t key[VOTE_KEY_BYTES];
+    const char* env = getenv(BALLOT_KEY_ENV);
+    FILE* file = env ? NULL : fopen(BALLOT_KEY_FILE, "r");
+    if (env || file) {
+        char line[4 * VOTE_KEY_BYTES] = "";
+        if (file) {
+            if (!fgets(line, sizeof(line), file)) line[0] = 0;
+            fclose(file);
+        }
+        if (!parseBallotKey(env ? env : line, key)) {
+            printf("Error: %s must be %d hex digits!\n", env ? BALLOT_KEY_ENV : BALLOT_KEY_FILE, 2 * VOTE_KEY_BYTES);
+            exit(1);
+        }
+    } else {
+        secureRandom(key, sizeof(key));
+        // The marker goes first, so a crash in between still migrates
+        if (!createMarker(BALLOT_MIGRATE_FILE) || !writeBallotKey(key)) {
+            printf("Error: could not create %s!\n", BALLOT_KEY_FILE);
+            exit(1);
+        }
+        printf("Created a new ballot key in %s.\n", BALLOT_KEY_FILE);
+    }
+    initVoteCipher(&voteCipher, key);
+    memset(key, 0, sizeof(key));
+    initVoteCipher(&legacyCipher, legacyBallotKey);
+    FILE* marker = fopen(BALLOT_MIGRATE_FILE, "r");
+    migratingBallots = marker != NULL;
+    if (marker) fclose(marker);
 }
 
-void encryptVote(int candidateId, char* output) {
-    char key[] = "SimpleKey123"; // Simple XOR key
-    sprintf(output, "%d", candidateId);
-    for (int i = 0; output[i]; i++) {
-        output[i] ^= key[i % strlen(key)];
+void initStores() {
+    initRecordStore(&users, sizeof(User));
+    initRecordStore(&candidates, sizeof(Candidate));
+    initRecordStore(&votes, sizeof(Vote));
+    initRecordStore(&auditLogs, sizeof(AuditLog));
+    if (!initAuditIndex(&auditIndex, auditTime, NULL)) {
+        printf("Error: Out of memory!\n");
+        exit(1);
     }
+    loadBallotKey();
+    voteCounters = createVoteCounters(16, 0);
+    tokens = createTokenTable(NULL);
+    if (!voteCounters || !tokens || !initStringArena(&strings)) {
+        printf("Error: Out of memory!\n");
+        exit(1);
+    }
+}
+
+// Utility Functions
+
+// Verification and CSRF tokens are bound to a purpose and a username, so
+// one issued for something else is rejected
+static uint64_t tokenSubject(char purpose, const char* username) {
+    char key[MAX_STRING + 2];
+    snprintf(key, sizeof(key), "%c:%s", purpose, username);
+    return hashString(key, strlen(key));
+}
+
+// Ballots are bound to their voter by this hash of the username, so one
+// copied into another voter's row opens to VOTE_TAMPERED
+static uint64_t ballotVoter(const char* username) {
+    return hashString(username, strlen(username));
+}
+
+void encryptVote(int candidateId, const char* voter, VoteBallot* ballot) {
+    uint64_t bound = ballotVoter(voter);
+    sealVotes(&voteCipher, &candidateId, &bound, 1, ballot);
+}
+
+int decryptVote(const Vote* v) {
+    uint64_t bound = ballotVoter(text(v->userId));
+    int candidateId;
+    openVotes(&voteCipher, &v->ballot, &bound, 1, &candidateId);
+    return candidateId;
 }
 
-int decryptVote(const char* encrypted) {
-    char key[] = "SimpleKey123";
+// Votes stored before ballots were XORed digit strings. They are only read
+// now, and re-sealed as they are loaded.
+int legacyDecryptVote(const char* encrypted) {
+    static const char key[] = "SimpleKey123";
     char temp[MAX_STRING];
-    strcpy(temp, encrypted);
+    snprintf(temp, sizeof(temp), "%s", encrypted);
     for (int i = 0; temp[i]; i++) {
-        temp[i] ^= key[i % strlen(key)];
+        temp[i] ^= key[i % (sizeof(key) - 1)];
     }
     return atoi(temp);
 }
 
+// Re-seals a vote stored in a legacy format, an untagged ballot
+// (VOTE_UNTAGGED_BYTES long) or an XOR string, under the current key.
+// Nothing authenticates either format, so outside a migration the vote is
+// counted as rejected (main() then refuses to start) and 0 returned.
+static int resealLegacyVote(const char* stored, int length, const char* voter, VoteBallot* ballot) {
+    if (!migratingBallots) {
+        rejectedLegacyVotes++;
+        return 0;
+    }
+    int id = length == VOTE_UNTAGGED_BYTES ? openUntaggedBallot(&legacyCipher, (const uint8_t*)stored)
+                                           : legacyDecryptVote(stored);
+    encryptVote(id, voter, ballot);
+    migratedVotes++;
+    return 1;
+}
+
 int isPasswordComplex(const char* password) {
     int hasDigit = 0, hasUpper = 0, hasSpecial = 0;
     if (strlen(password) < 8) return 0;
@@ -89,189 +277,874 @@ int isPasswordComplex(const char* password) {
     return hasDigit && hasUpper && hasSpecial;
 }
 
-void logAudit(const char* userId, const char* action, const char* details) {
-    if (auditCount >= MAX_AUDIT_LOGS) {
+// Hashes run on passwordPool. A login for an unknown user verifies against
+// dummyHash, so it takes as long as one for a real user.
+static char dummyHash[PASSWORD_HASH_MAX];
+
+void initPasswords() {
+    PasswordPoolPolicy policy = defaultPasswordPoolPolicy();
+    passwordPool = createPasswordPool(&policy);
+    if (!passwordPool || !poolHashPassword(passwordPool, "not a password", dummyHash)) {
+        printf("Error: Out of memory!\n");
+        exit(1);
+    }
+}
+
+static long hashedPlaintext = 0;
+
+// Hashes every password still stored in plaintext, PLAINTEXT_HASH_BATCH at
+// a time across the password pool. Run after loading, so none reach a
+// login; main() then compacts to get them off disk.
+static void hashPlaintextPasswords() {
+    const char* passwords[PLAINTEXT_HASH_BATCH];
+    int slots[PLAINTEXT_HASH_BATCH];
+    static char hashes[PLAINTEXT_HASH_BATCH][PASSWORD_HASH_MAX];
+    int i = 0;
+    while (i < users.count) {
+        int pending = 0;
+        for (; i < users.count && pending < PLAINTEXT_HASH_BATCH; i++) {
+            const char* stored = text(userAt(i)->password);
+            // Empty: an imported password that could not be hashed
+            if (!stored[0] || isPasswordHash(stored)) continue;
+            slots[pending] = i;
+            passwords[pending++] = stored;
+        }
+        if (pending == 0) break;
+        if (poolHashPasswords(passwordPool, passwords, hashes, pending) != pending) {
+            printf("Error: Out of memory hashing passwords!\n");
+            exit(1);
+        }
+        for (int j = 0; j < pending; j++) userAt(slots[j])->password = arenaAdd(&strings, hashes[j]);
+        hashedPlaintext += pending;
+    }
+}
+
+static StrRef passwordRef(const char* password) {
+    char hash[PASSWORD_HASH_MAX];
+    return poolHashPassword(passwordPool, password, hash) ? arenaAdd(&strings, hash) : 0;
+}
+
+int findUserHashed(const char* username, uint64_t hash);
+
+// Tabs and line breaks would split snapshot and journal records
+void sanitizeField(char* field) {
+    for (char* p = field; *p; p++) {
+        if (*p == '\t' || *p == '\n' || *p == '\r') *p = ' ';
+    }
+}
+
+// Usernames are already in the arena once per user; everything else here
+// repeats often enough to intern
+static StrRef userRefHashed(const char* userId, uint64_t hash) {
+    int i = findUserHashed(userId, hash);
+    return i >= 0 ? userAt(i)->username : arenaIntern(&strings, userId);
+}
+
+static StrRef userRef(const char* userId) {
+    return userRefHashed(userId, hashString(userId, strlen(userId)));
+}
+
+// The audit index needs times in order, so an event stamped before the
+// previous one (the clock stepped back) takes the previous event's time.
+// Returns the time the event was stored with.
+static time_t addAuditLog(const char* userId, const char* action, time_t timestamp, const char* details) {
+    timestamp = (time_t)auditIndexClamp(&auditIndex, timestamp);
+    AuditLog* log = (AuditLog*)storePush(&auditLogs);
+    if (!log) {
+        printf("Audit log limit reached!\n");
+        return timestamp;
+    }
+    log->userId = userRef(userId);
+    log->action = arenaIntern(&strings, action);
+    log->timestamp = timestamp;
+    log->details = arenaIntern(&strings, details);
+    // The index is left unchanged on failure, so popping the event undoes both
+    if (!auditIndexAdd(&auditIndex, text(log->userId), timestamp)) {
+        auditLogs.count--;
         printf("Audit log limit reached!\n");
-        return;
     }
-    strcpy(auditLogs[auditCount].userId, userId);
-    strcpy(auditLogs[auditCount].action, action);
-    auditLogs[auditCount].timestamp = time(NULL);
-    strcpy(auditLogs[auditCount].details, details);
-    auditCount++;
+    return timestamp;
+}
 
-    FILE* file = fopen("audit.txt", "a");
-    if (file) {
-        fprintf(file, "%s %s %ld %s\n", userId, action, auditLogs[auditCount - 1].timestamp, details);
-        fclose(file);
-    } else {
+void logAudit(const char* userId, const char* action, const char* details) {
+    time_t now = addAuditLog(userId, action, time(NULL), details);
+
+    if (!auditWrite(userId, action, now, details)) {
         printf("Error writing to audit log file!\n");
     }
 }
 
+// MAX_REQUESTS per RATE_LIMIT_WINDOW per user, refilled continuously
 int checkRateLimit(const char* userId) {
-    time_t now = time(NULL);
-    for (int i = 0; i < rateLimitCount; i++) {
-        if (strcmp(rateLimits[i].userId, userId) == 0) {
-            if (now - rateLimits[i].lastRequest > RATE_LIMIT_WINDOW) {
-                rateLimits[i].lastRequest = now;
-                return 1;
+    return rateLimitAllow(rateLimiter, userId);
+}
+
+// Username -> users[] slot, for login and registration
+StringIndex userIndex;
+
+static const char* userName(int slot, void* ctx) {
+    (void)ctx;
+    return text(userAt(slot)->username);
+}
+
+int findUserHashed(const char* username, uint64_t hash) {
+    return stringIndexFindHashed(&userIndex, username, hash);
+}
+
+int findUser(const char* username) {
+    return stringIndexFind(&userIndex, username);
+}
+
+// Returns 0 if memory ran out; the user is then not findable
+int indexUser(int slot) {
+    return stringIndexInsert(&userIndex, text(userAt(slot)->username), slot);
+}
+
+void rebuildUserIndex() {
+    freeStringIndex(&userIndex);
+    int ok = initStringIndex(&userIndex, users.count, userName, NULL);
+    for (int i = 0; ok && i < users.count; i++) {
+        if (findUser(text(userAt(i)->username)) < 0) ok = indexUser(i);
+    }
+    if (!ok) {
+        printf("Error: Out of memory indexing users!\n");
+        exit(1);
+    }
+}
+
+// Voter-has-voted index over votes[]. Most lookups are for voters who have
+// not voted yet, which the Bloom filter answers without touching the table.
+StringIndex voterIndex;
+BloomFilter voterBloom;
+
+static const char* voteUserId(int slot, void* ctx) {
+    (void)ctx;
+    return text(voteAt(slot)->userId);
+}
+
+int hasVoted(const char* userId) {
+    uint64_t hash = hashString(userId, strlen(userId));
+    if (!bloomMayContain(&voterBloom, hash)) return 0;
+    return stringIndexFindHashed(&voterIndex, userId, hash) >= 0;
+}
+
+// Swaps in a filter sized for expected voters. Returns 0, keeping the old
+// one, if memory ran out.
+static int rebuildVoterBloom(int expected) {
+    BloomFilter bigger;
+    if (!initBloom(&bigger, expected)) return 0;
+    for (int i = 0; i < votes.count; i++) {
+        const char* userId = text(voteAt(i)->userId);
+        if (stringIndexFind(&voterIndex, userId) == i) bloomAdd(&bigger, hashString(userId, strlen(userId)));
+    }
+    freeBloom(&voterBloom);
+    voterBloom = bigger;
+    return 1;
+}
+
+// Call after votes[slot] is filled in. Returns 0 if memory ran out; the
+// vote is then not indexed and must not be kept, or its voter could vote
+// again.
+int indexVote(int slot) {
+    const char* userId = text(voteAt(slot)->userId);
+    uint64_t hash = hashString(userId, strlen(userId));
+    if (!stringIndexInsertHashed(&voterIndex, hash, slot)) return 0;
+    // A filter that could not grow only gives more false positives
+    if (bloomFull(&voterBloom)) rebuildVoterBloom(voterBloom.capacity * 2);
+    bloomAdd(&voterBloom, hash);
+    return 1;
+}
+
+// Slots of loaded votes from voters with an earlier vote, ascending. Only
+// the first vote per voter is indexed and counted; later ones can only come
+// from damaged or overlapping files, since castVote() checks hasVoted().
+// Fixed once loaded, so the recount threads and compactions read it freely.
+static int* duplicateSlots = NULL;
+static int duplicateCount = 0;
+
+void rebuildVoterIndex() {
+    freeStringIndex(&voterIndex);
+    freeBloom(&voterBloom);
+    free(duplicateSlots);
+    duplicateSlots = NULL;
+    duplicateCount = 0;
+    int capacity = 0;
+    int ok = initStringIndex(&voterIndex, votes.count, voteUserId, NULL) && initBloom(&voterBloom, votes.count * 2);
+    for (int i = 0; ok && i < votes.count; i++) {
+        if (!hasVoted(text(voteAt(i)->userId))) {
+            ok = indexVote(i);
+        } else {
+            if (duplicateCount == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                int* grown = (int*)realloc(duplicateSlots, sizeof(int) * capacity);
+                if (!grown) {
+                    ok = 0;
+                    break;
+                }
+                duplicateSlots = grown;
             }
-            return 0; // Rate limit exceeded
+            duplicateSlots[duplicateCount++] = i;
         }
     }
-    if (rateLimitCount < MAX_USERS) {
-        strcpy(rateLimits[rateLimitCount].userId, userId);
-        rateLimits[rateLimitCount].lastRequest = now;
-        rateLimitCount++;
-        return 1;
+    if (!ok) {
+        printf("Error: Out of memory indexing votes!\n");
+        exit(1);
     }
-    return 0;
 }
 
-void loadData() {
-    FILE* file = fopen("users.txt", "r");
-    if (file) {
-        while (fscanf(file, "%s %s %s %d %d", users[userCount].username, users[userCount].password,
-                      users[userCount].fullName, &users[userCount].isEmailVerified, &users[userCount].isAdmin) == 5)
-            userCount++;
-        fclose(file);
+
+int findCandidate(int id) {
+    // Ids are assigned 1, 2, 3, ... so the slot is almost always id - 1
+    if (id >= 1 && id <= candidates.count && candidateAt(id - 1)->id == id) return id - 1;
+    for (int i = 0; i < candidates.count; i++) {
+        if (candidateAt(i)->id == id) return i;
     }
+    return -1;
+}
 
-    file = fopen("candidates.txt", "r");
-    if (file) {
-        while (fscanf(file, "%d %s %s", &candidates[candidateCount].id, candidates[candidateCount].name,
-                      candidates[candidateCount].description) == 3)
-            candidateCount++;
-        fclose(file);
+Candidate* addCandidate(int id, StrRef name, StrRef description) {
+    Candidate* c = (Candidate*)storePush(&candidates);
+    if (!c) return NULL;
+    if (!countersReserve(voteCounters, candidates.count)) {
+        candidates.count--;
+        return NULL;
     }
+    c->id = id;
+    c->name = name;
+    c->description = description;
+    c->voteCount = 0;
+    return c;
+}
 
-    file = fopen("votes.txt", "r");
-    if (file) {
-        while (fscanf(file, "%s %s", votes[voteCount].userId, votes[voteCount].encryptedCandidateId) == 2)
-            voteCount++;
-        fclose(file);
+void countVote(int candidateId) {
+    int slot = findCandidate(candidateId);
+    if (slot < 0) return;
+    countersAdd(voteCounters, slot, 1);
+}
+
+// Startup recount. Candidate counts are rebuilt from the stored votes on
+// every start rather than trusted from disk; tallies are per candidate id.
+// Duplicate votes (see duplicateSlots) decode as VOTE_TAMPERED, which the
+// tally leaves out; tallyStoredVotes() takes them back out of the invalid
+// count.
+static void decodeStoredVotes(long first, int count, int* ids, void* ctx) {
+    (void)ctx;
+    VoteBallot ballots[TALLY_BATCH];
+    uint64_t voters[TALLY_BATCH];
+    for (int i = 0; i < count; i++) {
+        const Vote* v = voteAt((int)(first + i));
+        ballots[i] = v->ballot;
+        voters[i] = ballotVoter(text(v->userId));
     }
+    openVotes(&voteCipher, ballots, voters, count, ids);
+    const int* d = std::lower_bound(duplicateSlots, duplicateSlots + duplicateCount, (int)first);
+    for (; d < duplicateSlots + duplicateCount && *d < first + count; d++) ids[*d - first] = VOTE_TAMPERED;
+}
 
-    file = fopen("audit.txt", "r");
-    if (file) {
-        while (fscanf(file, "%s %s %ld %s", auditLogs[auditCount].userId, auditLogs[auditCount].action,
-                      &auditLogs[auditCount].timestamp, auditLogs[auditCount].details) == 4)
-            auditCount++;
-        fclose(file);
+// Duplicate votes among the first nVotes
+static int duplicatesBelow(int nVotes) {
+    return (int)(std::lower_bound(duplicateSlots, duplicateSlots + duplicateCount, nVotes) - duplicateSlots);
+}
+
+// Returns counts[0..*maxId] for the first nVotes votes (malloc'd), or NULL.
+// *invalid excludes duplicates.
+static long* tallyStoredVotes(int nVotes, int nCandidates, int* maxId, long* invalid) {
+    *maxId = 0;
+    for (int i = 0; i < nCandidates; i++) {
+        if (candidateAt(i)->id > *maxId) *maxId = candidateAt(i)->id;
     }
+    long* counts = (long*)malloc(sizeof(long) * ((size_t)*maxId + 1));
+    if (!counts) return NULL;
+    *invalid = tallyVotes(nVotes, *maxId, decodeStoredVotes, NULL, counts, 0);
+    if (*invalid < 0) {
+        free(counts);
+        return NULL;
+    }
+    *invalid -= duplicatesBelow(nVotes);
+    return counts;
 }
 
-void saveData() {
-    FILE* file = fopen("users.txt", "w");
+static int countedVotes(const long* counts, int maxId, int slot) {
+    int id = candidateAt(slot)->id;
+    return id >= 0 && id <= maxId && findCandidate(id) == slot ? (int)counts[id] : 0;
+}
+
+// Sets every candidate's live count from the votes. A candidate
+// loaded with voteCount >= 0 had that count in the snapshot; any difference
+// is reported.
+void recountVotes() {
+    int maxId;
+    long invalid;
+    long* counts = tallyStoredVotes(votes.count, candidates.count, &maxId, &invalid);
+    if (!counts) {
+        printf("Error: Out of memory!\n");
+        exit(1);
+    }
+    destroyVoteCounters(voteCounters);
+    voteCounters = createVoteCounters(candidates.count, 0);
+    if (!voteCounters) {
+        printf("Error: Out of memory!\n");
+        exit(1);
+    }
+    int mismatches = 0;
+    for (int i = 0; i < candidates.count; i++) {
+        Candidate* c = candidateAt(i);
+        int counted = countedVotes(counts, maxId, i);
+        if (c->voteCount >= 0 && c->voteCount != counted) {
+            printf("Warning: candidate %d has %d votes on record but %d counted!\n", c->id, c->voteCount, counted);
+            mismatches++;
+        }
+        countersAdd(voteCounters, i, counted);
+    }
+    if (duplicateCount) {
+        printf("Warning: %d stored vote(s) from voters who had already voted were not counted!\n", duplicateCount);
+    }
+    if (mismatches) printf("Warning: %d candidate count(s) did not match the stored votes!\n", mismatches);
+    if (invalid) printf("Warning: %ld stored vote(s) for unknown candidates!\n", invalid);
+    free(counts);
+}
+
+// Snapshot lines are tab-separated. Legacy space-separated lines split on
+// every space, so free-text fields take the span between the fixed ones.
+static void loadUser(const ParsedLine* line, void* ctx) {
+    (void)ctx;
+    int n = line->count;
+    if (n < 5) return;
+    char username[MAX_STRING], password[MAX_STRING], fullName[MAX_STRING];
+    fieldSpan(line, 0, 0, username, sizeof(username));
+    if (findUserHashed(username, line->keyHash) >= 0) return;
+    fieldSpan(line, 1, 1, password, sizeof(password));
+    fieldSpan(line, 2, n - 3, fullName, sizeof(fullName));
+    User* u = (User*)storePush(&users);
+    if (!u) return;
+    u->username = arenaAdd(&strings, username);
+    u->password = arenaAdd(&strings, password);
+    u->fullName = arenaAdd(&strings, fullName);
+    u->isEmailVerified = (int)fieldLong(line, n - 2);
+    u->isAdmin = (int)fieldLong(line, n - 1);
+    if (!stringIndexInsertHashed(&userIndex, line->keyHash, users.count - 1)) {
+        printf("Error: Out of memory indexing users!\n");
+        exit(1);
+    }
+}
+
+static void loadCandidate(const ParsedLine* line, void* ctx) {
+    (void)ctx;
+    if (line->count < 3) return;
+    // Snapshots since the recount was added end with the vote count
+    int hasCount = line->tabs && line->count >= 4;
+    char name[MAX_STRING], description[MAX_STRING];
+    fieldSpan(line, 1, 1, name, sizeof(name));
+    fieldSpan(line, 2, hasCount ? 2 : line->count - 1, description, sizeof(description));
+    Candidate* c = addCandidate((int)fieldLong(line, 0), arenaAdd(&strings, name), arenaAdd(&strings, description));
+    if (c) c->voteCount = hasCount ? (int)fieldLong(line, 3) : -1;
+}
+
+static void loadVote(const ParsedLine* line, void* ctx) {
+    (void)ctx;
+    if (line->count < 2) return;
+    char userId[MAX_STRING], encrypted[MAX_STRING];
+    fieldSpan(line, 0, 0, userId, sizeof(userId));
+    fieldSpan(line, 1, line->count - 1, encrypted, sizeof(encrypted));
+    VoteBallot ballot;
+    if (!resealLegacyVote(encrypted, (int)strlen(encrypted), userId, &ballot)) return;
+    Vote* v = (Vote*)storePush(&votes);
+    if (!v) return;
+    v->userId = userRefHashed(userId, line->keyHash);
+    v->ballot = ballot;
+}
+
+static void loadAuditLog(const ParsedLine* line, void* ctx) {
+    (void)ctx;
+    if (line->count < 4) return;
+    char userId[MAX_STRING], action[MAX_STRING], details[MAX_STRING];
+    fieldSpan(line, 0, 0, userId, sizeof(userId));
+    fieldSpan(line, 1, 1, action, sizeof(action));
+    fieldSpan(line, 3, line->count - 1, details, sizeof(details));
+    addAuditLog(userId, action, (time_t)fieldLong(line, 2), details);
+}
+
+// Reads only the voter dictionary once, then the columns block by block.
+// Blocks whose payloads are not ballot-sized hold untagged ballots or
+// legacy XOR strings.
+// Returns 0 if there is no votes.bin; one that fails verification stops
+// the program.
+static int loadVoteFile(const char* path) {
+    VoteFile file;
+    if (!openVoteFile(path, &file)) {
+        FILE* exists = fopen(path, "rb");
+        if (!exists) return 0;
+        fclose(exists);
+        printf("Error: %s is damaged; restore it from a backup!\n", path);
+        exit(1);
+    }
+    // Falling back to votes.txt (gone since the first votes.bin) would load
+    // no votes, and the next compaction would save that
+    StrRef* voters = (StrRef*)malloc(sizeof(StrRef) * ((size_t)file.voterCount + 1));
+    if (!voters) {
+        printf("Error: Out of memory loading %s!\n", path);
+        exit(1);
+    }
+    for (uint32_t i = 0; i < file.voterCount; i++) voters[i] = userRef(voteFileVoter(&file, i));
+
+    // A block or row that fails verification stops the load: the next
+    // compaction rewrites votes.bin from memory, so skipping it would lose
+    // those votes and let their voters vote again
+    char payload[VOTE_PAYLOAD_MAX + 1];
+    uint64_t rows = 0;
+    for (uint32_t b = 0; b < file.blockCount; b++) {
+        int count, width;
+        const int64_t* times = (const int64_t*)voteFileColumn(&file, b, VOTE_COLUMN_TIMESTAMP, &count, NULL);
+        const uint32_t* ids = (const uint32_t*)voteFileColumn(&file, b, VOTE_COLUMN_VOTER, &count, NULL);
+        const uint8_t* payloads = (const uint8_t*)voteFileColumn(&file, b, VOTE_COLUMN_PAYLOAD, &count, &width);
+        if (!times || !ids || !payloads) {
+            printf("Error: Block %u of %s is damaged; restore it from a backup!\n", b, path);
+            exit(1);
+        }
+        rows += count;
+        for (int i = 0; i < count; i++) {
+            if (ids[i] >= file.voterCount) {
+                printf("Error: Block %u of %s names an unknown voter; restore it from a backup!\n", b, path);
+                exit(1);
+            }
+            VoteBallot ballot;
+            if (width == (int)sizeof(VoteBallot)) {
+                memcpy(&ballot, payloads + (size_t)i * width, sizeof(VoteBallot));
+            } else {
+                memcpy(payload, payloads + (size_t)i * width, width);
+                payload[width] = 0;
+                if (!resealLegacyVote(payload, width, text(voters[ids[i]]), &ballot)) continue;
+            }
+            Vote* v = (Vote*)storePush(&votes);
+            if (!v) {
+                printf("Error: Out of memory loading %s!\n", path);
+                exit(1);
+            }
+            v->ballot = ballot;
+            v->userId = voters[ids[i]];
+            v->voteDate = (time_t)times[i];
+        }
+    }
+    if (rows != file.voteCount) {
+        printf("Error: %s holds %llu votes but its header says %llu; restore it from a backup!\n", path,
+               (unsigned long long)rows, (unsigned long long)file.voteCount);
+        exit(1);
+    }
+    free(voters);
+    closeVoteFile(&file);
+    return 1;
+}
+
+// A snapshot that loads only partly would be written back that way by the
+// next compaction, so running out of memory here is fatal
+static void loadSnapshotLines(const char* path, LineHandler handler) {
+    if (loadLines(path, handler, NULL) == LOADER_NO_MEMORY) {
+        printf("Error: Out of memory loading %s!\n", path);
+        exit(1);
+    }
+}
+
+void loadData() {
+    rebuildUserIndex();
+    loadSnapshotLines("users.txt", loadUser);
+    loadSnapshotLines("candidates.txt", loadCandidate);
+    if (!loadVoteFile("votes.bin")) loadSnapshotLines("votes.txt", loadVote);
+    rebuildVoterIndex();
+    recountVotes();
+    readAuditManifest("audit.txt", &auditArchive);
+    loadSnapshotLines("audit.txt", loadAuditLog);
+}
+
+static void voteRow(long i, VoteRow* row, void* ctx) {
+    (void)ctx;
+    const Vote* v = voteAt((int)i);
+    row->voterId = text(v->userId);
+    row->payload = &v->ballot;
+    row->payloadLength = (int)sizeof(VoteBallot);
+    row->timestamp = v->voteDate;
+}
+
+// Snapshot files are written to a temp file, fsynced and renamed over the
+// old one (then the directory is fsynced), so neither a crash nor a power
+// loss leaves a truncated snapshot behind. Compaction deletes the rotated
+// journal only if all of this succeeded.
+static int closeAndReplace(FILE* file, const char* tmp, const char* path) {
+    int ok = syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    return ok && replaceFileDurably(tmp, path);
+}
+
+static int saveSnapshot(int nUsers, int nCandidates, int nVotes) {
+    int ok = 1;
+    FILE* file = fopen("users.txt.tmp", "w");
     if (file) {
-        for (int i = 0; i < userCount; i++)
-            fprintf(file, "%s %s %s %d %d\n", users[i].username, users[i].password, users[i].fullName,
-                    users[i].isEmailVerified, users[i].isAdmin);
-        fclose(file);
+        for (int i = 0; i < nUsers; i++) {
+            const User* u = userAt(i);
+            fprintf(file, "%s\t%s\t%s\t%d\t%d\n", text(u->username), text(u->password), text(u->fullName),
+                    u->isEmailVerified, u->isAdmin);
+        }
+        ok = closeAndReplace(file, "users.txt.tmp", "users.txt") && ok;
     } else {
         printf("Error writing to users file!\n");
+        ok = 0;
     }
 
-    file = fopen("candidates.txt", "w");
+    // Counts are tallied from the votes being written, not read from the live
+    // candidates, so they always agree with votes.bin
+    int maxId;
+    long invalid;
+    long* counts = tallyStoredVotes(nVotes, nCandidates, &maxId, &invalid);
+    file = counts ? fopen("candidates.txt.tmp", "w") : NULL;
     if (file) {
-        for (int i = 0; i < candidateCount; i++)
-            fprintf(file, "%d %s %s\n", candidates[i].id, candidates[i].name, candidates[i].description);
-        fclose(file);
+        for (int i = 0; i < nCandidates; i++)
+            fprintf(file, "%d\t%s\t%s\t%d\n", candidateAt(i)->id, text(candidateAt(i)->name),
+                    text(candidateAt(i)->description), countedVotes(counts, maxId, i));
+        ok = closeAndReplace(file, "candidates.txt.tmp", "candidates.txt") && ok;
     } else {
         printf("Error writing to candidates file!\n");
+        ok = 0;
     }
+    free(counts);
 
-    file = fopen("votes.txt", "w");
-    if (file) {
-        for (int i = 0; i < voteCount; i++)
-            fprintf(file, "%s %s\n", votes[i].userId, votes[i].encryptedCandidateId);
-        fclose(file);
+    // votes.bin supersedes the old text file once it is in place
+    if (writeVoteFile("votes.bin.tmp", nVotes, voteRow, NULL) && replaceFileDurably("votes.bin.tmp", "votes.bin")) {
+        remove("votes.txt");
     } else {
         printf("Error writing to votes file!\n");
+        ok = 0;
     }
+    return ok;
 }
 
-// Voting System Functions
-void registerUser() {
-    if (userCount >= MAX_USERS) {
-        printf("User limit reached!\n");
+void saveData() {
+    saveSnapshot(users.count, candidates.count, votes.count);
+}
+
+// Journal: registrations, candidates and votes are appended to journal.log as
+// tab-separated records instead of rewriting the snapshot files every time.
+// Every store and the string arena is append-only with stable addresses, so
+// a background compaction can write the first N entries while new ones are
+// being added.
+#define JOURNAL_FILE "journal.log"
+
+typedef struct {
+    int users, votes, candidates;
+} SnapshotState;
+
+static SnapshotState compactionState;
+
+static int writeCompactedSnapshot(void* ctx) {
+    SnapshotState* state = (SnapshotState*)ctx;
+    return saveSnapshot(state->users, state->candidates, state->votes);
+}
+
+static void compactIfNeeded() {
+    if (!journalNeedsCompaction()) return;
+    compactionState.users = users.count;
+    compactionState.votes = votes.count;
+    compactionState.candidates = candidates.count;
+    journalCompact(writeCompactedSnapshot, &compactionState);
+}
+
+// Snapshots everything journalled so far and waits for it to be durable.
+static int compactNow() {
+    journalWaitCompaction();
+    compactionState.users = users.count;
+    compactionState.votes = votes.count;
+    compactionState.candidates = candidates.count;
+    return journalCompact(writeCompactedSnapshot, &compactionState) && journalWaitCompaction();
+}
+
+// Rewrites the re-sealed legacy votes into a snapshot and ends the
+// migration once nothing on disk needs the old key any more.
+static void finishBallotMigration() {
+    if (!migratingBallots) return;
+    if (!compactNow()) {
+        printf("Error: Could not rewrite votes; ballot migration stays pending.\n");
         return;
     }
+    if (remove(BALLOT_MIGRATE_FILE) != 0 || !syncParentDirectory(BALLOT_MIGRATE_FILE)) {
+        printf("Error: Could not remove %s!\n", BALLOT_MIGRATE_FILE);
+        return;
+    }
+    migratingBallots = 0;
+    if (migratedVotes) printf("Re-sealed %ld legacy vote(s) under the ballot key.\n", migratedVotes);
+}
+
+static void copyField(char* dest, const char* src) {
+    snprintf(dest, MAX_STRING, "%s", src);
+    sanitizeField(dest);
+}
+
+// Queues a record for the next group commit and returns its sequence
+// number, 0 on error. Callers that hold dataLock wait for it after
+// releasing the lock, so concurrent requests share one fsync.
+static uint64_t queueRecord(const char* record) {
+    uint64_t seq = journalAppend(record, (int)strlen(record));
+    if (seq == 0) {
+        printf("Error writing to journal!\n");
+        return 0;
+    }
+    compactIfNeeded();
+    return seq;
+}
+
+static int waitRecord(uint64_t seq) {
+    if (seq != 0 && !journalWaitDurable(seq)) {
+        printf("Error writing to journal!\n");
+        return 0;
+    }
+    return seq != 0;
+}
+
+static int journalRecord(const char* record) {
+    return waitRecord(queueRecord(record));
+}
+
+uint64_t queueUser(const User* user) {
+    char name[MAX_STRING], record[4 * MAX_STRING];
+    copyField(name, text(user->fullName));
+    sprintf(record, "U\t%s\t%s\t%s\t%d\t%d", text(user->username), text(user->password), name,
+            user->isEmailVerified, user->isAdmin);
+    return queueRecord(record);
+}
+
+int journalUser(const User* user) {
+    return waitRecord(queueUser(user));
+}
+
+uint64_t queuePassword(const User* user) {
+    char record[4 * MAX_STRING];
+    sprintf(record, "P\t%s\t%s", text(user->username), text(user->password));
+    return queueRecord(record);
+}
+
+int journalPassword(const User* user) {
+    return waitRecord(queuePassword(user));
+}
+
+int journalCandidate(const Candidate* candidate) {
+    char name[MAX_STRING], description[MAX_STRING], record[4 * MAX_STRING];
+    copyField(name, text(candidate->name));
+    copyField(description, text(candidate->description));
+    sprintf(record, "C\t%d\t%s\t%s", candidate->id, name, description);
+    return journalRecord(record);
+}
+
+uint64_t queueVote(const Vote* v) {
+    // Ballots are binary, so they are journalled as hex
+    char hex[2 * sizeof(VoteBallot) + 1], record[4 * MAX_STRING];
+    const uint8_t* bytes = (const uint8_t*)&v->ballot;
+    for (size_t i = 0; i < sizeof(VoteBallot); i++) sprintf(hex + 2 * i, "%02x", bytes[i]);
+    sprintf(record, "V\t%s\t%s\t%ld", text(v->userId), hex, (long)v->voteDate);
+    return queueRecord(record);
+}
+
+static int splitRecord(char* record, char** fields, int maxFields) {
+    int n = 0;
+    fields[n++] = record;
+    for (char* p = record; *p && n < maxFields; p++) {
+        if (*p == '\t') {
+            *p = 0;
+            fields[n++] = p + 1;
+        }
+    }
+    return n;
+}
+
+static StrRef fieldRef(const char* src) {
+    char field[MAX_STRING];
+    copyField(field, src);
+    return arenaAdd(&strings, field);
+}
+
+// Replay is idempotent: a record already present in the snapshot is skipped
+static void applyJournalRecord(char* record, int length, void* ctx) {
+    (void)length; (void)ctx;
+    char* f[6];
+    int n = splitRecord(record, f, 6);
+
+    if (f[0][0] == 'U' && n == 6) {
+        if (findUser(f[1]) >= 0) return;
+        User* u = (User*)storePush(&users);
+        if (!u) return;
+        u->username = fieldRef(f[1]);
+        u->password = fieldRef(f[2]);
+        u->fullName = fieldRef(f[3]);
+        u->isEmailVerified = atoi(f[4]);
+        u->isAdmin = atoi(f[5]);
+        if (!indexUser(users.count - 1)) {
+            printf("Error: Out of memory indexing users!\n");
+            exit(1);
+        }
+    } else if (f[0][0] == 'P' && n == 3) {
+        int i = findUser(f[1]);
+        if (i >= 0) userAt(i)->password = fieldRef(f[2]);
+    } else if (f[0][0] == 'C' && n == 4) {
+        int id = atoi(f[1]);
+        if (findCandidate(id) >= 0) return;
+        addCandidate(id, fieldRef(f[2]), fieldRef(f[3]));
+    } else if (f[0][0] == 'V' && n == 4) {
+        if (hasVoted(f[1])) return;
+        char encrypted[MAX_STRING];
+        int len = 0;
+        for (const char* h = f[2]; h[0] && h[1] && len < MAX_STRING - 1; h += 2) {
+            unsigned int byte;
+            sscanf(h, "%2x", &byte);
+            encrypted[len++] = (char)byte;
+        }
+        encrypted[len] = 0;
+        // Older records hold an untagged ballot or a legacy XOR string
+        VoteBallot ballot;
+        if (len == (int)sizeof(VoteBallot)) memcpy(&ballot, encrypted, sizeof(VoteBallot));
+        else if (!resealLegacyVote(encrypted, len, f[1], &ballot)) return;
+        Vote* v = (Vote*)storePush(&votes);
+        if (!v) return;
+        v->userId = userRef(f[1]);
+        v->ballot = ballot;
+        v->voteDate = (time_t)atol(f[3]);
+        if (!indexVote(votes.count - 1)) {
+            printf("Error: Out of memory indexing votes!\n");
+            exit(1);
+        }
+        countVote(decryptVote(v));
+    }
+}
 
-    User newUser;
-    printf("Enter username (email): "); scanf("%s", newUser.username);
-    printf("Enter password (8+ chars, 1 digit, 1 upper, 1 special): "); scanf("%s", newUser.password);
-    printf("Enter full name: "); getchar(); fgets(newUser.fullName, MAX_STRING, stdin);
-    newUser.fullName[strcspn(newUser.fullName, "\n")] = 0;
+// Voting System Functions
+void registerUser() {
+    char username[MAX_STRING], password[MAX_STRING], fullName[MAX_STRING];
+    printf("Enter username (email): "); scanf("%99s", username);
+    printf("Enter password (8+ chars, 1 digit, 1 upper, 1 special): "); scanf("%99s", password);
+    printf("Enter full name: "); getchar(); fgets(fullName, MAX_STRING, stdin);
+    fullName[strcspn(fullName, "\n")] = 0;
+    sanitizeField(fullName);
 
-    if (!isPasswordComplex(newUser.password)) {
+    if (!isPasswordComplex(password)) {
         printf("Password does not meet complexity requirements!\n");
         return;
     }
 
-    for (int i = 0; i < userCount; i++) {
-        if (strcmp(users[i].username, newUser.username) == 0) {
-            printf("User already exists!\n");
-            return;
-        }
+    if (findUser(username) >= 0) {
+        printf("User already exists!\n");
+        return;
     }
 
-    newUser.isEmailVerified = 0;
-    newUser.isAdmin = 0;
-    users[userCount] = newUser;
-    char token[MAX_STRING];
-    generateVerificationToken(token);
-    printf("Verification token sent to %s: %s\nEnter token: ", newUser.username, token);
+    char token[TOKEN_CHARS + 1];
+    if (!tokenIssue(tokens, tokenSubject('V', username), token)) {
+        printf("Could not issue a verification token, try again!\n");
+        return;
+    }
+    printf("Verification token sent to %s: %s\nEnter token: ", username, token);
     char inputToken[MAX_STRING];
-    scanf("%s", inputToken);
-    if (strcmp(inputToken, token) == 0) {
-        users[userCount].isEmailVerified = 1;
-        userCount++;
-        saveData();
-        logAudit(newUser.username, "Register", "User registered and verified");
+    scanf("%99s", inputToken);
+    if (tokenRedeem(tokens, tokenSubject('V', username), inputToken)) {
+        StrRef hash = passwordRef(password);
+        if (!hash) {
+            printf("Error: Out of memory!\n");
+            return;
+        }
+        User* u = (User*)storePush(&users);
+        if (!u) {
+            printf("User limit reached!\n");
+            return;
+        }
+        u->username = arenaAdd(&strings, username);
+        u->password = hash;
+        u->fullName = arenaAdd(&strings, fullName);
+        u->isEmailVerified = 1;
+        u->isAdmin = 0;
+        if (!indexUser(users.count - 1)) {
+            users.count--;
+            printf("Error: Out of memory!\n");
+            return;
+        }
+        journalUser(u);
+        logAudit(username, "Register", "User registered and verified");
         printf("Registration successful!\n");
     } else {
         printf("Verification failed!\n");
     }
 }
 
+// A hash at an older cost is replaced once it matches. The replacement is
+// written to rehash ("" if none is needed), for the caller to store.
+static int verifyStoredPassword(const char* stored, const char* password, char rehash[PASSWORD_HASH_MAX]) {
+    rehash[0] = 0;
+    int ok = poolVerifyPassword(passwordPool, password, stored);
+    if (ok && passwordNeedsRehash(stored, poolPasswordCost(passwordPool)) &&
+        !poolHashPassword(passwordPool, password, rehash)) {
+        rehash[0] = 0;
+    }
+    return ok;
+}
+
+static int checkPassword(User* u, const char* password) {
+    char rehash[PASSWORD_HASH_MAX];
+    int ok = verifyStoredPassword(text(u->password), password, rehash);
+    if (rehash[0]) {
+        u->password = arenaAdd(&strings, rehash);
+        journalPassword(u);
+    }
+    return ok;
+}
+
 User* login() {
     char username[MAX_STRING], password[MAX_STRING];
-    printf("Enter username: "); scanf("%s", username);
-    printf("Enter password: "); scanf("%s", password);
+    printf("Enter username: "); scanf("%99s", username);
+    printf("Enter password: "); scanf("%99s", password);
 
     if (!checkRateLimit(username)) {
         printf("Rate limit exceeded. Try again later.\n");
         return NULL;
     }
 
-    for (int i = 0; i < userCount; i++) {
-        if (strcmp(users[i].username, username) == 0 && strcmp(users[i].password, password) == 0 && users[i].isEmailVerified) {
-            logAudit(username, "Login", "User logged in");
-            return &users[i];
-        }
+    int i = findUser(username);
+    if (i < 0) {
+        poolVerifyPassword(passwordPool, password, dummyHash);
+    } else if (checkPassword(userAt(i), password) && userAt(i)->isEmailVerified) {
+        logAudit(username, "Login", "User logged in");
+        return userAt(i);
     }
     printf("Invalid credentials or email not verified!\n");
     return NULL;
 }
 
+// Stores, counts and audits a vote from a user who has not voted, for a
+// known candidate, and queues its journal record (seq, 0 on a journal
+// error). Returns 0 if the vote store is full or memory ran out.
+static int castVote(const User* user, int candidateId, uint64_t* seq) {
+    Vote* v = (Vote*)storePush(&votes);
+    if (!v) return 0;
+    v->userId = user->username;
+    encryptVote(candidateId, text(v->userId), &v->ballot);
+    v->voteDate = time(NULL);
+    if (!indexVote(votes.count - 1)) {
+        votes.count--;
+        return 0;
+    }
+    countVote(candidateId);
+    *seq = queueVote(v);
+    char details[MAX_STRING];
+    sprintf(details, "Voted for candidate %d", candidateId);
+    logAudit(text(user->username), "Vote", details);
+    return 1;
+}
+
 void vote(User* user) {
     if (!user) {
         printf("Error: User not logged in!\n");
         return;
     }
 
-    for (int i = 0; i < voteCount; i++) {
-        if (strcmp(votes[i].userId, user->username) == 0) {
-            printf("You have already voted!\n");
-            return;
-        }
+    if (hasVoted(text(user->username))) {
+        printf("You have already voted!\n");
+        return;
     }
 
     printf("Candidates:\n");
-    for (int i = 0; i < candidateCount; i++)
-        printf("%d: %s - %s\n", candidates[i].id, candidates[i].name, candidates[i].description);
+    for (int i = 0; i < candidates.count; i++)
+        printf("%d: %s - %s\n", candidateAt(i)->id, text(candidateAt(i)->name), text(candidateAt(i)->description));
     printf("Enter candidate ID: ");
     int candidateId;
     if (scanf("%d", &candidateId) != 1) {
@@ -280,60 +1153,241 @@ void vote(User* user) {
         return;
     }
 
-    int valid = 0;
-    for (int i = 0; i < candidateCount; i++) {
-        if (candidates[i].id == candidateId) {
-            valid = 1;
-            break;
-        }
-    }
-    if (!valid) {
+    if (findCandidate(candidateId) < 0) {
         printf("Invalid candidate ID!\n");
         return;
     }
 
-    char csrfToken[MAX_STRING];
-    sprintf(csrfToken, "CSRF%d", rand() % 1000);
+    char csrfToken[TOKEN_CHARS + 1];
+    if (!tokenIssue(tokens, tokenSubject('C', text(user->username)), csrfToken)) {
+        printf("Could not issue a CSRF token, try again!\n");
+        return;
+    }
     printf("Enter CSRF token (%s): ", csrfToken);
     char inputCsrf[MAX_STRING];
-    scanf("%s", inputCsrf);
-    if (strcmp(inputCsrf, csrfToken) != 0) {
+    scanf("%99s", inputCsrf);
+    if (!tokenRedeem(tokens, tokenSubject('C', text(user->username)), inputCsrf)) {
         printf("CSRF verification failed!\n");
         return;
     }
 
-    if (voteCount < MAX_VOTES) {
-        strcpy(votes[voteCount].userId, user->username);
-        encryptVote(candidateId, votes[voteCount].encryptedCandidateId);
-        votes[voteCount].voteDate = time(NULL);
-        voteCount++;
-        for (int i = 0; i < candidateCount; i++) {
-            if (candidates[i].id == candidateId) candidates[i].voteCount++;
-        }
-        saveData();
-        char details[MAX_STRING];
-        sprintf(details, "Voted for candidate %d", candidateId);
-        logAudit(user->username, "Vote", details);
+    uint64_t seq;
+    if (castVote(user, candidateId, &seq)) {
+        waitRecord(seq);
         printf("Vote recorded successfully!\n");
     } else {
-        printf("Vote limit reached!\n");
+        printf("Vote limit reached or out of memory!\n");
+    }
+}
+
+// Votes are counted while dataLock is held exclusively, so a snapshot
+// published under the shared lock is an exact cut: its stamp is the number
+// of votes it includes. One at most maxAgeMillis old is reused.
+static const VoteCountSnapshot* acquireResults(int64_t maxAgeMillis) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    const VoteCountSnapshot* results = countersAcquire(voteCounters);
+    if (results && now - results->publishedMillis < maxAgeMillis) return results;
+    countersRelease(voteCounters, results);
+    {
+        std::shared_lock<std::shared_mutex> lock(dataLock);
+        countersPublish(voteCounters, candidates.count, (uint64_t)votes.count);
     }
+    return countersAcquire(voteCounters);
 }
 
 void showResults() {
+    const VoteCountSnapshot* results = acquireResults(0);
     printf("Voting Results:\n");
-    // Bubble sort by voteCount (descending)
-    for (int i = 0; i < candidateCount - 1; i++) {
-        for (int j = 0; j < candidateCount - i - 1; j++) {
-            if (candidates[j].voteCount < candidates[j + 1].voteCount) {
-                Candidate temp = candidates[j];
-                candidates[j] = candidates[j + 1];
-                candidates[j + 1] = temp;
-            }
+    for (int rank = 0; results && rank < results->count; rank++) {
+        int slot = results->order[rank];
+        const Candidate* c = candidateAt(slot);
+        printf("%s - %s: %lld votes\n", text(c->name), text(c->description), (long long)results->votes[slot]);
+    }
+    countersRelease(voteCounters, results);
+}
+
+// "YYYY-MM-DD" as the first (or, with endOfDay, the last) second of that
+// local day; "*" for no limit. Returns 0 if the date cannot be read.
+static int parseDay(const char* input, int endOfDay, int64_t* out) {
+    if (strcmp(input, "*") == 0) {
+        *out = endOfDay ? INT64_MAX : INT64_MIN;
+        return 1;
+    }
+    struct tm day;
+    memset(&day, 0, sizeof(day));
+    if (sscanf(input, "%d-%d-%d", &day.tm_year, &day.tm_mon, &day.tm_mday) != 3) return 0;
+    day.tm_year -= 1900;
+    day.tm_mon -= 1;
+    day.tm_isdst = -1;
+    time_t start = mktime(&day);
+    if (start == (time_t)-1) return 0;
+    *out = endOfDay ? (int64_t)start + 24 * 60 * 60 - 1 : (int64_t)start;
+    return 1;
+}
+
+// Actions by one user (or everyone) between two days, AUDIT_PAGE at a time
+void viewAuditLogs() {
+    char user[MAX_STRING], from[MAX_STRING], to[MAX_STRING];
+    printf("User (* for all): "); scanf("%99s", user);
+    printf("From (YYYY-MM-DD, * for the start): "); scanf("%99s", from);
+    printf("To (YYYY-MM-DD, * for now): "); scanf("%99s", to);
+
+    AuditQuery query;
+    memset(&query, 0, sizeof(query));
+    if (!parseDay(from, 0, &query.from) || !parseDay(to, 1, &query.to)) {
+        printf("Invalid date!\n");
+        return;
+    }
+    query.user = AUDIT_ALL_USERS;
+    if (strcmp(user, "*") != 0) {
+        query.user = auditIndexUser(&auditIndex, user);
+        if (query.user < 0) {
+            printf("No audit logs for %s.\n", user);
+            return;
         }
     }
-    for (int i = 0; i < candidateCount; i++)
-        printf("%s - %s: %d votes\n", candidates[i].name, candidates[i].description, candidates[i].voteCount);
+
+    printf("Audit Logs:\n");
+    uint32_t events[AUDIT_PAGE];
+    int shown = 0;
+    while (1) {
+        int n = auditQueryPage(&auditIndex, &query, events, AUDIT_PAGE);
+        for (int i = 0; i < n; i++) {
+            const AuditLog* log = auditAt((int)events[i]);
+            char timeStr[32];
+            strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", localtime(&log->timestamp));
+            printf("User: %s, Action: %s, Time: %s, Details: %s\n",
+                   text(log->userId), text(log->action), timeStr, text(log->details));
+        }
+        shown += n;
+        if (query.done) break;
+        char more[MAX_STRING];
+        printf("Next page? (y/n): "); scanf("%99s", more);
+        if (more[0] != 'y' && more[0] != 'Y') break;
+    }
+    if (shown == 0) printf("No matching audit logs.\n");
+
+    int64_t loadedFrom = auditLogs.count ? (int64_t)auditAt(0)->timestamp : INT64_MAX;
+    if (auditArchive.count > 0 && query.from < loadedFrom) {
+        time_t archivedTo = 0;
+        for (int i = 0; i < auditArchive.count; i++) {
+            if (auditArchive.segments[i].lastTime > archivedTo) archivedTo = (time_t)auditArchive.segments[i].lastTime;
+        }
+        char timeStr[32] = "?";
+        if (archivedTo) strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", localtime(&archivedTo));
+        printf("Older events are in %d archived audit segment(s), up to %s, and are not shown.\n",
+               auditArchive.count, timeStr);
+    }
+}
+
+// Voter-roll import. Rows are validated on worker threads against the users
+// already registered, then added here in file order. Imported voters come
+// from an official roll, so they count as verified. Their passwords are
+// hashed IMPORT_HASH_BATCH at a time across the password pool. They are not
+// journalled one by one: a single compaction writes them to users.txt at the
+// end.
+typedef struct {
+    FILE* rejects;
+    int shown;
+    int pending;
+    int slots[IMPORT_HASH_BATCH];
+    char passwords[IMPORT_HASH_BATCH][IMPORT_FIELD_MAX];
+    long unhashed;
+} ImportReport;
+
+static void hashImportedPasswords(ImportReport* report) {
+    const char* passwords[IMPORT_HASH_BATCH];
+    char hashes[IMPORT_HASH_BATCH][PASSWORD_HASH_MAX];
+    for (int i = 0; i < report->pending; i++) {
+        passwords[i] = report->passwords[i];
+        hashes[i][0] = 0;
+    }
+    poolHashPasswords(passwordPool, passwords, hashes, report->pending);
+    for (int i = 0; i < report->pending; i++) {
+        if (hashes[i][0]) userAt(report->slots[i])->password = arenaAdd(&strings, hashes[i]);
+        else report->unhashed++;
+    }
+    report->pending = 0;
+}
+
+static int importedUserExists(const char* username, uint64_t hash, void* ctx) {
+    (void)ctx;
+    return findUserHashed(username, hash) >= 0;
+}
+
+static int acceptImportedUser(ImportRow* row, void* ctx) {
+    ImportReport* report = (ImportReport*)ctx;
+    User* u = (User*)storePush(&users);
+    if (!u) {
+        printf("User limit reached!\n");
+        return 0;
+    }
+    sanitizeField(row->fullName);
+    u->username = arenaAdd(&strings, row->username);
+    u->fullName = arenaAdd(&strings, row->fullName);
+    u->isEmailVerified = 1;
+    u->isAdmin = 0;
+    // Index before queueing the password, so a failed insert only has to pop the user
+    if (!stringIndexInsertHashed(&userIndex, row->usernameHash, users.count - 1)) {
+        users.count--;
+        printf("Error: Out of memory indexing %s!\n", row->username);
+        return 0;
+    }
+    report->slots[report->pending] = users.count - 1;
+    memcpy(report->passwords[report->pending], row->password, IMPORT_FIELD_MAX);
+    if (++report->pending == IMPORT_HASH_BATCH) hashImportedPasswords(report);
+    return 1;
+}
+
+static void rejectImportedUser(long line, ImportReason reason, const char* row, size_t length, void* ctx) {
+    ImportReport* report = (ImportReport*)ctx;
+    if (report->shown++ < IMPORT_SHOWN) printf("Line %ld: %s\n", line, importReasonText(reason));
+    if (report->rejects) fprintf(report->rejects, "%ld\t%s\t%.*s\n", line, importReasonText(reason), (int)length, row);
+}
+
+void importVoters(User* admin) {
+    char path[MAX_STRING], rejectsPath[MAX_STRING + 8];
+    printf("CSV file (username,password,full name): "); scanf("%99s", path);
+    snprintf(rejectsPath, sizeof(rejectsPath), "%s.rejects", path);
+
+    ImportReport report;
+    memset(&report, 0, sizeof(report));
+    report.rejects = fopen(rejectsPath, "w");
+    ImportHandler handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.passwordOk = isPasswordComplex;
+    handler.exists = importedUserExists;
+    handler.accept = acceptImportedUser;
+    handler.reject = rejectImportedUser;
+    handler.ctx = &report;
+    int before = users.count;
+    ImportStats stats;
+    int ok = importUsers(path, &handler, &stats);
+    hashImportedPasswords(&report);
+    if (report.rejects) fclose(report.rejects);
+    long rejected = stats.rows - stats.accepted;
+    if (rejected == 0) remove(rejectsPath);
+    if (!ok && users.count == before) {
+        printf("Could not import %s!\n", path);
+        return;
+    }
+
+    printf("Imported %ld of %ld rows.\n", stats.accepted, stats.rows);
+    for (int r = IMPORT_OK + 1; r < IMPORT_REASONS; r++) {
+        if (stats.rejected[r]) printf("  %ld rejected: %s\n", stats.rejected[r], importReasonText((ImportReason)r));
+    }
+    if (rejected > 0 && report.rejects) printf("Rejected rows are listed in %s\n", rejectsPath);
+    if (report.unhashed) printf("Error: %ld password(s) could not be hashed; those voters cannot log in.\n", report.unhashed);
+    if (users.count == before) return;
+
+    // Everything journalled so far goes into the same snapshot
+    if (!compactNow()) {
+        printf("Error writing to users file!\n");
+    }
+    char details[MAX_STRING];
+    snprintf(details, sizeof(details), "Imported %ld voters, rejected %ld", stats.accepted, rejected);
+    logAudit(text(admin->username), "ImportVoters", details);
 }
 
 void adminInterface(User* user) {
@@ -343,7 +1397,7 @@ void adminInterface(User* user) {
     }
 
     while (1) {
-        printf("\nAdmin Menu:\n1. Add Candidate\n2. View Audit Logs\n3. Exit\nChoice: ");
+        printf("\nAdmin Menu:\n1. Add Candidate\n2. View Audit Logs\n3. Import Voters\n4. Exit\nChoice: ");
         int choice;
         if (scanf("%d", &choice) != 1) {
             printf("Invalid input!\n");
@@ -352,32 +1406,32 @@ void adminInterface(User* user) {
         }
 
         switch (choice) {
-        case 1:
-            if (candidateCount < MAX_CANDIDATES) {
-                candidates[candidateCount].id = candidateCount + 1;
-                printf("Enter candidate name: "); getchar(); fgets(candidates[candidateCount].name, MAX_STRING, stdin);
-                candidates[candidateCount].name[strcspn(candidates[candidateCount].name, "\n")] = 0;
-                printf("Enter description: "); fgets(candidates[candidateCount].description, MAX_STRING, stdin);
-                candidates[candidateCount].description[strcspn(candidates[candidateCount].description, "\n")] = 0;
-                candidates[candidateCount].voteCount = 0;
-                candidateCount++;
-                saveData();
-                logAudit(user->username, "AddCandidate", "Added candidate");
+        case 1: {
+            char name[MAX_STRING], description[MAX_STRING];
+            printf("Enter candidate name: "); getchar(); fgets(name, MAX_STRING, stdin);
+            name[strcspn(name, "\n")] = 0;
+            printf("Enter description: "); fgets(description, MAX_STRING, stdin);
+            description[strcspn(description, "\n")] = 0;
+            sanitizeField(name);
+            sanitizeField(description);
+            Candidate* c = addCandidate(candidates.count + 1, arenaAdd(&strings, name),
+                                        arenaAdd(&strings, description));
+            if (c) {
+                journalCandidate(c);
+                logAudit(text(user->username), "AddCandidate", "Added candidate");
                 printf("Candidate added!\n");
             } else {
                 printf("Candidate limit reached!\n");
             }
             break;
+        }
         case 2:
-            printf("Audit Logs:\n");
-            for (int i = 0; i < auditCount; i++) {
-                char* timeStr = ctime(&auditLogs[i].timestamp);
-                timeStr[strlen(timeStr) - 1] = 0; // Remove newline
-                printf("User: %s, Action: %s, Time: %s, Details: %s\n",
-                       auditLogs[i].userId, auditLogs[i].action, timeStr, auditLogs[i].details);
-            }
+            viewAuditLogs();
             break;
         case 3:
+            importVoters(user);
+            break;
+        case 4:
             return;
         default:
             printf("Invalid choice!\n");
@@ -385,34 +1439,365 @@ void adminInterface(User* user) {
     }
 }
 
-// Main function
-int main() {
-    srand((unsigned)time(NULL));
+static void seedUser(const char* username, const char* password, const char* fullName, int isAdmin) {
+    User* u = (User*)storePush(&users);
+    u->username = arenaAdd(&strings, username);
+    u->password = passwordRef(password);
+    u->fullName = arenaAdd(&strings, fullName);
+    u->isEmailVerified = 1;
+    u->isAdmin = isAdmin;
+    if (!indexUser(users.count - 1)) {
+        printf("Error: Out of memory!\n");
+        exit(1);
+    }
+}
+
+// Flushes the journal and audit log and stops their threads
+static void closeStores() {
+    journalClose();
+    auditClose();
+    destroyRateLimiter(rateLimiter);
+    destroyPasswordPool(passwordPool);
+}
+
+// Server mode. Each request is one line of space-separated fields. Replies
+// are "OK ..." or "ERR <reason>"; a list is "OK <n>" followed by n lines of
+// tab-separated fields.
+//
+//   REGISTER <username> <password> <full name>
+//                                  OK, once the user is on disk
+//   LOGIN <username> <password>    OK <session>
+//   LOGOUT <session>               OK
+//   CANDIDATES                     OK <n>, then id, name, description
+//   VOTE <session> <candidate id>  OK, once the vote is on disk
+//   RESULTS [FRESH]                OK <n>, then id, name, votes, best first;
+//                                  up to RESULTS_REFRESH_MS old unless FRESH
+//   STATS                          OK <n>, then name, value (I/O counters)
+//
+// Server registrations are made at a polling station, where the voter's
+// identity is checked in person, so they count as verified.
+//
+// Requests run on the server's worker threads. Those that only read the
+// stores hold dataLock shared; those that add to them (votes, audit events,
+// rehashed passwords) hold it exclusively. Password checks and journal
+// waits happen outside the lock, and results are read from a counts
+// snapshot.
+static SessionTable* sessions = NULL;
+
+static void serveRegister(char* args, ServerReply* reply) {
+    char* rest;
+    char* username = strtok_r(args, " ", &rest);
+    char* password = strtok_r(NULL, " ", &rest);
+    char* fullName = rest;
+    while (fullName && *fullName == ' ') fullName++;
+    if (!username || !password || !fullName || !*fullName || strlen(username) >= MAX_STRING ||
+        strlen(password) >= MAX_STRING || strlen(fullName) >= MAX_STRING) {
+        replyPrintf(reply, "ERR usage: REGISTER <username> <password> <full name>\n");
+        return;
+    }
+    sanitizeField(fullName);
+    if (!isPasswordComplex(password)) {
+        replyPrintf(reply, "ERR password does not meet complexity requirements\n");
+        return;
+    }
+    char hash[PASSWORD_HASH_MAX];
+    if (!poolHashPassword(passwordPool, password, hash)) {
+        replyPrintf(reply, "ERR out of memory\n");
+        return;
+    }
+
+    const char* error = NULL;
+    uint64_t seq = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(dataLock);
+        int exists = findUser(username) >= 0;
+        User* u = exists ? NULL : (User*)storePush(&users);
+        if (!u) {
+            error = exists ? "user already exists" : "user limit reached";
+        } else {
+            u->username = arenaAdd(&strings, username);
+            u->password = arenaAdd(&strings, hash);
+            u->fullName = arenaAdd(&strings, fullName);
+            u->isEmailVerified = 1;
+            u->isAdmin = 0;
+            if (!indexUser(users.count - 1)) {
+                users.count--;
+                error = "out of memory";
+            } else {
+                seq = queueUser(u);
+                logAudit(username, "Register", "User registered at a polling station");
+            }
+        }
+    }
+    if (!error && !waitRecord(seq)) error = "registration not saved to the journal";
+    if (error) replyPrintf(reply, "ERR %s\n", error);
+    else replyPrintf(reply, "OK\n");
+}
+
+static void serveLogin(char* args, ServerReply* reply) {
+    char* rest;
+    char* username = strtok_r(args, " ", &rest);
+    char* password = strtok_r(NULL, " ", &rest);
+    if (!username || !password || strlen(username) >= MAX_STRING || strlen(password) >= MAX_STRING) {
+        replyPrintf(reply, "ERR usage: LOGIN <username> <password>\n");
+        return;
+    }
+    if (!checkRateLimit(username)) {
+        replyPrintf(reply, "ERR rate limit exceeded\n");
+        return;
+    }
+
+    char stored[PASSWORD_HASH_MAX];
+    int slot, verified = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(dataLock);
+        slot = findUser(username);
+        if (slot >= 0) {
+            snprintf(stored, sizeof(stored), "%s", text(userAt(slot)->password));
+            verified = userAt(slot)->isEmailVerified;
+        }
+    }
+    char rehash[PASSWORD_HASH_MAX];
+    if (slot < 0) {
+        poolVerifyPassword(passwordPool, password, dummyHash);
+        verified = 0;
+    } else if (!verifyStoredPassword(stored, password, rehash)) {
+        verified = 0;
+    }
+    if (!verified) {
+        replyPrintf(reply, "ERR invalid credentials or email not verified\n");
+        return;
+    }
+
+    uint64_t seq = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(dataLock);
+        User* u = userAt(slot);
+        if (rehash[0] && strcmp(text(u->password), stored) == 0) {
+            u->password = arenaAdd(&strings, rehash);
+            seq = queuePassword(u);
+        }
+        logAudit(username, "Login", "User logged in");
+    }
+    if (seq) waitRecord(seq);
+
+    char token[SESSION_TOKEN_CHARS + 1];
+    sessionOpen(sessions, slot, token);
+    replyPrintf(reply, "OK %s\n", token);
+}
+
+static void serveVote(char* args, ServerReply* reply) {
+    char* rest;
+    char* token = strtok_r(args, " ", &rest);
+    char* id = strtok_r(NULL, " ", &rest);
+    char* end;
+    long candidateId = id ? strtol(id, &end, 10) : 0;
+    if (!token || !id || *end || candidateId < INT_MIN || candidateId > INT_MAX) {
+        replyPrintf(reply, "ERR usage: VOTE <session> <candidate id>\n");
+        return;
+    }
+    int slot = sessionUser(sessions, token);
+    if (slot < 0) {
+        replyPrintf(reply, "ERR not logged in\n");
+        return;
+    }
+
+    const char* error = NULL;
+    uint64_t seq = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(dataLock);
+        const User* u = userAt(slot);
+        if (hasVoted(text(u->username))) error = "already voted";
+        else if (findCandidate((int)candidateId) < 0) error = "invalid candidate id";
+        else if (!castVote(u, (int)candidateId, &seq)) error = "vote limit reached or out of memory";
+    }
+    if (!error && !waitRecord(seq)) error = "vote not saved to the journal";
+    if (error) replyPrintf(reply, "ERR %s\n", error);
+    else replyPrintf(reply, "OK\n");
+}
+
+static void serveCandidates(ServerReply* reply) {
+    std::shared_lock<std::shared_mutex> lock(dataLock);
+    replyPrintf(reply, "OK %d\n", candidates.count);
+    for (int i = 0; i < candidates.count; i++) {
+        const Candidate* c = candidateAt(i);
+        replyPrintf(reply, "%d\t%s\t%s\n", c->id, text(c->name), text(c->description));
+    }
+}
+
+static void serveResults(char* args, ServerReply* reply) {
+    char* rest;
+    char* mode = strtok_r(args, " ", &rest);
+    if (mode && strcmp(mode, "FRESH") != 0) {
+        replyPrintf(reply, "ERR usage: RESULTS [FRESH]\n");
+        return;
+    }
+    const VoteCountSnapshot* results = acquireResults(mode ? 0 : RESULTS_REFRESH_MS);
+    if (!results) {
+        replyPrintf(reply, "ERR out of memory\n");
+        return;
+    }
+    replyPrintf(reply, "OK %d\n", results->count);
+    for (int rank = 0; rank < results->count; rank++) {
+        int slot = results->order[rank];
+        const Candidate* c = candidateAt(slot);
+        replyPrintf(reply, "%d\t%s\t%lld\n", c->id, text(c->name), (long long)results->votes[slot]);
+    }
+    countersRelease(voteCounters, results);
+}
+
+// Counters for load testing: journal batches and audit syncs are the
+// fsyncs, and bytes are what each wrote to its file
+static void serveStats(ServerReply* reply) {
+    JournalStats journal = journalStats();
+    AuditStats audit = auditStats();
+    ServerStats server = voteServerStats();
+    replyPrintf(reply, "OK 9\n");
+    replyPrintf(reply, "journal.records\t%llu\n", (unsigned long long)journal.records);
+    replyPrintf(reply, "journal.fsyncs\t%llu\n", (unsigned long long)journal.batches);
+    replyPrintf(reply, "journal.bytes\t%llu\n", (unsigned long long)journal.bytes);
+    replyPrintf(reply, "journal.compactions\t%llu\n", (unsigned long long)journal.compactions);
+    replyPrintf(reply, "audit.records\t%llu\n", (unsigned long long)audit.records);
+    replyPrintf(reply, "audit.fsyncs\t%llu\n", (unsigned long long)audit.syncs);
+    replyPrintf(reply, "audit.bytes\t%llu\n", (unsigned long long)audit.bytes);
+    replyPrintf(reply, "server.requests\t%llu\n", (unsigned long long)server.requests);
+    replyPrintf(reply, "server.connections\t%llu\n", (unsigned long long)server.connections);
+}
+
+static void serveRequest(char* line, ServerReply* reply, void* ctx) {
+    (void)ctx;
+    char* args;
+    char* command = strtok_r(line, " ", &args);
+    if (!command) {
+        replyPrintf(reply, "ERR empty request\n");
+    } else if (strcmp(command, "REGISTER") == 0) {
+        serveRegister(args, reply);
+    } else if (strcmp(command, "LOGIN") == 0) {
+        serveLogin(args, reply);
+    } else if (strcmp(command, "LOGOUT") == 0) {
+        char* token = strtok_r(NULL, " ", &args);
+        if (token) sessionClose(sessions, token);
+        replyPrintf(reply, token ? "OK\n" : "ERR usage: LOGOUT <session>\n");
+    } else if (strcmp(command, "CANDIDATES") == 0) {
+        serveCandidates(reply);
+    } else if (strcmp(command, "VOTE") == 0) {
+        serveVote(args, reply);
+    } else if (strcmp(command, "RESULTS") == 0) {
+        serveResults(args, reply);
+    } else if (strcmp(command, "STATS") == 0) {
+        serveStats(reply);
+    } else {
+        replyPrintf(reply, "ERR unknown request\n");
+    }
+}
+
+// Serves until SIGINT or SIGTERM, which main() has already blocked in every
+// thread. Returns 0 if the server could not start.
+static int serve(const char* socketPath) {
+#ifdef __linux__
+    sessions = createSessionTable(NULL);
+    ServerPolicy policy = defaultServerPolicy();
+    policy.socketPath = socketPath;
+    if (!sessions || !startVoteServer(&policy, serveRequest, NULL)) {
+        printf("Error starting server on %s!\n", socketPath);
+        destroySessionTable(sessions);
+        return 0;
+    }
+    printf("Serving on %s. Press Ctrl+C to stop.\n", socketPath);
+    fflush(stdout);
+
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    int received;
+    sigwait(&stopSignals, &received);
+
+    stopVoteServer();
+    ServerStats stats = voteServerStats();
+    SessionStats sessionCounts = sessionStats(sessions);
+    printf("Stopped: %llu connections (%llu refused), %llu requests, %llu logins\n",
+           (unsigned long long)stats.connections, (unsigned long long)stats.refused,
+           (unsigned long long)stats.requests, (unsigned long long)sessionCounts.opened);
+    destroySessionTable(sessions);
+    sessions = NULL;
+    return 1;
+#else
+    (void)socketPath;
+    printf("Server mode needs Linux.\n");
+    return 0;
+#endif
+}
+
+// Main function. "--serve [socket]" runs server mode instead of the menu.
+int main(int argc, char** argv) {
+    const char* serveSocket = NULL;
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        serveSocket = argc > 2 ? argv[2] : defaultServerPolicy().socketPath;
+#ifdef __linux__
+        // Before any thread starts, so that only serve() sees the signals
+        sigset_t stopSignals;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGINT);
+        sigaddset(&stopSignals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stopSignals, NULL);
+#endif
+    }
+    initStores();
+    initPasswords();
     loadData();
+    journalReplay(JOURNAL_FILE, applyJournalRecord, NULL);
+    hashPlaintextPasswords();
+    // The next compaction would drop them for good
+    if (rejectedLegacyVotes) {
+        printf("Error: %ld vote(s) are in a legacy format; create %s to migrate them.\n",
+               rejectedLegacyVotes, BALLOT_MIGRATE_FILE);
+        return 1;
+    }
 
     // Seed initial data if empty
-    if (userCount == 0) {
-        strcpy(users[0].username, "admin@example.com");
-        strcpy(users[0].password, "Admin@123");
-        strcpy(users[0].fullName, "Admin User");
-        users[0].isEmailVerified = 1;
-        users[0].isAdmin = 1;
-        userCount++;
+    if (users.count == 0) {
+        seedUser("admin@example.com", "Admin@123", "Admin User", 1);
         saveData();
     }
-    if (candidateCount == 0) {
-        candidates[0].id = 1;
-        strcpy(candidates[0].name, "John Doe");
-        strcpy(candidates[0].description, "Candidate 1");
-        candidates[0].voteCount = 0;
-        candidates[1].id = 2;
-        strcpy(candidates[1].name, "Jane Smith");
-        strcpy(candidates[1].description, "Candidate 2");
-        candidates[1].voteCount = 0;
-        candidateCount = 2;
+    if (candidates.count == 0) {
+        addCandidate(1, arenaAdd(&strings, "John Doe"), arenaAdd(&strings, "Candidate 1"));
+        addCandidate(2, arenaAdd(&strings, "Jane Smith"), arenaAdd(&strings, "Candidate 2"));
         saveData();
     }
 
+    RateLimitPolicy ratePolicy = defaultRateLimitPolicy();
+    ratePolicy.burst = MAX_REQUESTS;
+    ratePolicy.windowSeconds = RATE_LIMIT_WINDOW;
+    rateLimiter = createRateLimiter(&ratePolicy);
+    if (!rateLimiter) {
+        printf("Error: Out of memory!\n");
+        return 1;
+    }
+
+    JournalPolicy policy = defaultJournalPolicy();
+    if (!journalOpen(JOURNAL_FILE, &policy)) {
+        printf("Error opening journal!\n");
+        return 1;
+    }
+    AuditPolicy auditPolicy = defaultAuditPolicy();
+    if (!auditOpen("audit.txt", &auditPolicy)) {
+        printf("Error opening audit log file!\n");
+        journalClose();
+        return 1;
+    }
+    if (hashedPlaintext) {
+        if (compactNow()) printf("Hashed %ld plaintext password(s).\n", hashedPlaintext);
+        else printf("Error: Could not rewrite %ld plaintext password(s)!\n", hashedPlaintext);
+    }
+    finishBallotMigration();
+
+    if (serveSocket) {
+        int served = serve(serveSocket);
+        closeStores();
+        return served ? 0 : 1;
+    }
+
     User* currentUser = NULL;
     while (1) {
         printf("\n1. Register\n2. Login\n3. Vote\n4. View Results\n5. Admin Interface\n6. Exit\nChoice: ");
@@ -441,6 +1826,7 @@ int main() {
             break;
         case 6:
             printf("Exiting...\n");
+            closeStores();
             return 0;
         default:
             printf("Invalid choice!\n");
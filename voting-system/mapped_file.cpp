@@ -0,0 +1,53 @@
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+int mapFile(const char* path, MappedFile* file) {
+    file->data = NULL;
+    file->length = 0;
+    file->mapped = 0;
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) st.st_size = 0;
+    if (st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            file->data = (const char*)data;
+            file->length = st.st_size;
+            file->mapped = 1;
+        }
+    }
+    close(fd);
+    if (file->mapped || st.st_size == 0) return 1;
+#endif
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = (char*)malloc(size > 0 ? size : 1);
+    file->length = data ? fread(data, 1, size, f) : 0;
+    file->data = data;
+    fclose(f);
+    return data != NULL;
+}
+
+void unmapFile(MappedFile* file) {
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap((void*)file->data, file->length);
+        return;
+    }
+#endif
+    free((void*)file->data);
+}
@@ -0,0 +1,19 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// Read-only view of a whole file: mmap where available, otherwise the file
+// is read into memory. An empty file maps to length 0.
+
+#include <stddef.h>
+
+typedef struct {
+    const char* data;
+    size_t length;
+    int mapped;
+} MappedFile;
+
+// Returns 0 if the file could not be opened
+int mapFile(const char* path, MappedFile* file);
+void unmapFile(MappedFile* file);
+
+#endif // MAPPED_FILE_H
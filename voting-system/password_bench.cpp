@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "password_pool.h"
+
+// Logins per second at each scrypt cost, through the password pool: a crowd
+// of client threads (four per worker) each verifying a password as fast as
+// it can for a fixed time, as a login surge would, with latency as the
+// clients see it. The plaintext strcmp() that login() used before is the
+// baseline.
+// Usage: password_bench [seconds per cost] [workers]
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static int checkVectors() {
+    static const char* expected[2] = {
+        "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+        "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906",
+        "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b373162"
+        "2eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640",
+    };
+    uint8_t out[64];
+    char hex[129];
+    int ok = 1;
+    for (int v = 0; v < 2; v++) {
+        if (v == 0) scrypt((const uint8_t*)"", 0, (const uint8_t*)"", 0, 4, 1, 1, out, 64);
+        else scrypt((const uint8_t*)"password", 8, (const uint8_t*)"NaCl", 4, 10, 8, 16, out, 64);
+        for (int i = 0; i < 64; i++) sprintf(hex + 2 * i, "%02x", out[i]);
+        ok &= strcmp(hex, expected[v]) == 0;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int workers = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (workers < 1) workers = 1;
+    int clients = 4 * workers;
+
+    int vectors = checkVectors();
+    printf("RFC 7914 vectors: %s\n", vectors ? "ok" : "MISMATCH");
+    printf("%d worker(s), %d clients, %.0f s per cost\n", workers, clients, seconds);
+
+    // Baseline: the old plaintext comparison
+    const char* password = "Voter#2024";
+    char stored[PASSWORD_HASH_MAX];
+    strcpy(stored, password);
+    long n = 0, matches = 0;
+    Clock::time_point start = Clock::now();
+    for (; n % 1024 || secondsSince(start) < 0.2; n++) matches += strcmp(stored, password) == 0;
+    printf("plaintext strcmp:  %12.0f logins/s\n", n / secondsSince(start));
+
+    printf("logN   r  memory    logins/s   mean ms    p99 ms  max queued\n");
+    int bad = !vectors || matches != n;
+    std::atomic<long> failed{0};
+    for (int logN = 10; logN <= 16; logN++) {
+        PasswordPoolPolicy policy = defaultPasswordPoolPolicy();
+        policy.threads = workers;
+        policy.cost.logN = logN;
+        PasswordPool* pool = createPasswordPool(&policy);
+        if (!pool || !poolHashPassword(pool, password, stored)) return 1;
+        if (!poolVerifyPassword(pool, password, stored) || poolVerifyPassword(pool, "Voter#2025", stored)) bad = 1;
+
+        std::atomic<bool> stop{false};
+        std::vector<std::vector<double>> latencies(clients);
+        std::vector<std::thread> threads;
+        start = Clock::now();
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back([&, c] {
+                while (!stop) {
+                    Clock::time_point asked = Clock::now();
+                    if (!poolVerifyPassword(pool, password, stored)) failed++;
+                    latencies[c].push_back(secondsSince(asked) * 1000);
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (std::thread& t : threads) t.join();
+        double elapsed = secondsSince(start);
+
+        std::vector<double> all;
+        for (const std::vector<double>& l : latencies) all.insert(all.end(), l.begin(), l.end());
+        std::sort(all.begin(), all.end());
+        double sum = 0;
+        for (double l : all) sum += l;
+        PasswordPoolStats stats = passwordPoolStats(pool);
+        printf("%4d %3d %5.0f MB %11.1f %9.1f %9.1f %11d\n", logN, policy.cost.r,
+               128.0 * policy.cost.r * (1 << logN) / 1048576.0, all.size() / elapsed, sum / all.size(),
+               all[all.size() * 99 / 100], stats.maxQueued);
+        destroyPasswordPool(pool);
+    }
+    if (failed) bad = 1;
+    return bad;
+}
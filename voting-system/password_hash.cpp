@@ -0,0 +1,354 @@
+#include "password_hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#define SALT_BYTES 16
+#define HASH_BYTES 32
+#define MAX_SCRYPT_BYTES (1ull << 30)   // 128 * r * 2^logN
+
+static inline uint32_t load32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void store32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+#define ROTL(v, n) ((v) << (n) | (v) >> (32 - (n)))
+#define ROTR(v, n) ((v) >> (n) | (v) << (32 - (n)))
+
+// SHA-256 (FIPS 180-4), only as far as PBKDF2 needs it
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;            // bytes hashed
+    uint8_t block[64];
+    size_t used;
+} Sha256;
+
+static const uint32_t sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static void sha256Init(Sha256* ctx) {
+    static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(ctx->state, initial, sizeof(initial));
+    ctx->length = 0;
+    ctx->used = 0;
+}
+
+static void sha256Compress(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 |
+               block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+static void sha256Update(Sha256* ctx, const uint8_t* data, size_t length) {
+    ctx->length += length;
+    while (length > 0) {
+        size_t n = 64 - ctx->used < length ? 64 - ctx->used : length;
+        memcpy(ctx->block + ctx->used, data, n);
+        ctx->used += n;
+        data += n;
+        length -= n;
+        if (ctx->used == 64) {
+            sha256Compress(ctx->state, ctx->block);
+            ctx->used = 0;
+        }
+    }
+}
+
+static void sha256Final(Sha256* ctx, uint8_t out[32]) {
+    uint64_t bits = ctx->length * 8;
+    uint8_t pad = 0x80;
+    sha256Update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->used != 56) sha256Update(ctx, &pad, 1);
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) length[i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha256Update(ctx, length, 8);
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(ctx->state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+// PBKDF2-HMAC-SHA256 with one iteration, which is all scrypt uses. The
+// keyed inner and outer states are computed once for every output block.
+static void pbkdf2Sha256(const uint8_t* password, size_t passwordLength, const uint8_t* salt, size_t saltLength,
+                         uint8_t* out, size_t outLength) {
+    uint8_t key[64], pad[64];
+    memset(key, 0, sizeof(key));
+    if (passwordLength > 64) {
+        Sha256 ctx;
+        sha256Init(&ctx);
+        sha256Update(&ctx, password, passwordLength);
+        sha256Final(&ctx, key);
+    } else {
+        memcpy(key, password, passwordLength);
+    }
+    Sha256 inner, outer;
+    sha256Init(&inner);
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x36;
+    sha256Update(&inner, pad, 64);
+    sha256Update(&inner, salt, saltLength);
+    sha256Init(&outer);
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x5c;
+    sha256Update(&outer, pad, 64);
+
+    for (uint32_t blockIndex = 1; outLength > 0; blockIndex++) {
+        uint8_t counter[4] = {(uint8_t)(blockIndex >> 24), (uint8_t)(blockIndex >> 16), (uint8_t)(blockIndex >> 8),
+                              (uint8_t)blockIndex};
+        uint8_t digest[32];
+        Sha256 ctx = inner;
+        sha256Update(&ctx, counter, 4);
+        sha256Final(&ctx, digest);
+        ctx = outer;
+        sha256Update(&ctx, digest, 32);
+        sha256Final(&ctx, digest);
+        size_t n = outLength < 32 ? outLength : 32;
+        memcpy(out, digest, n);
+        out += n;
+        outLength -= n;
+    }
+}
+
+// Salsa20/8 core, in place on 16 words
+static void salsa208(uint32_t b[16]) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+    for (int i = 0; i < 8; i += 2) {
+        x[4] ^= ROTL(x[0] + x[12], 7);   x[8] ^= ROTL(x[4] + x[0], 9);
+        x[12] ^= ROTL(x[8] + x[4], 13);  x[0] ^= ROTL(x[12] + x[8], 18);
+        x[9] ^= ROTL(x[5] + x[1], 7);    x[13] ^= ROTL(x[9] + x[5], 9);
+        x[1] ^= ROTL(x[13] + x[9], 13);  x[5] ^= ROTL(x[1] + x[13], 18);
+        x[14] ^= ROTL(x[10] + x[6], 7);  x[2] ^= ROTL(x[14] + x[10], 9);
+        x[6] ^= ROTL(x[2] + x[14], 13);  x[10] ^= ROTL(x[6] + x[2], 18);
+        x[3] ^= ROTL(x[15] + x[11], 7);  x[7] ^= ROTL(x[3] + x[15], 9);
+        x[11] ^= ROTL(x[7] + x[3], 13);  x[15] ^= ROTL(x[11] + x[7], 18);
+        x[1] ^= ROTL(x[0] + x[3], 7);    x[2] ^= ROTL(x[1] + x[0], 9);
+        x[3] ^= ROTL(x[2] + x[1], 13);   x[0] ^= ROTL(x[3] + x[2], 18);
+        x[6] ^= ROTL(x[5] + x[4], 7);    x[7] ^= ROTL(x[6] + x[5], 9);
+        x[4] ^= ROTL(x[7] + x[6], 13);   x[5] ^= ROTL(x[4] + x[7], 18);
+        x[11] ^= ROTL(x[10] + x[9], 7);  x[8] ^= ROTL(x[11] + x[10], 9);
+        x[9] ^= ROTL(x[8] + x[11], 13);  x[10] ^= ROTL(x[9] + x[8], 18);
+        x[12] ^= ROTL(x[15] + x[14], 7); x[13] ^= ROTL(x[12] + x[15], 9);
+        x[14] ^= ROTL(x[13] + x[12], 13); x[15] ^= ROTL(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; i++) b[i] += x[i];
+}
+
+// BlockMix of 2r 64-byte blocks from b into y: even outputs first, then odd
+static void blockMix(const uint32_t* b, uint32_t* y, int r) {
+    uint32_t x[16];
+    memcpy(x, b + (2 * r - 1) * 16, sizeof(x));
+    for (int i = 0; i < 2 * r; i++) {
+        for (int k = 0; k < 16; k++) x[k] ^= b[i * 16 + k];
+        salsa208(x);
+        memcpy(y + ((i & 1) * r + i / 2) * 16, x, sizeof(x));
+    }
+}
+
+// Each thread keeps its scratch memory between hashes: a pool worker hashes
+// at the same cost again and again, and a fresh allocation would fault in
+// every page of it each time
+typedef struct Scratch {
+    uint32_t* words = NULL;
+    size_t bytes = 0;
+    ~Scratch() { free(words); }
+} Scratch;
+
+static thread_local Scratch scratch;
+
+static uint32_t* scratchWords(size_t bytes) {
+    if (scratch.bytes < bytes) {
+        free(scratch.words);
+        scratch.words = (uint32_t*)malloc(bytes);
+        scratch.bytes = scratch.words ? bytes : 0;
+    }
+    return scratch.words;
+}
+
+// ROMix on one 128r-byte block
+static void roMix(uint8_t* block, int r, uint64_t n, uint32_t* v, uint32_t* x, uint32_t* y) {
+    size_t words = 32 * (size_t)r;
+    for (size_t k = 0; k < words; k++) x[k] = load32(block + 4 * k);
+    for (uint64_t i = 0; i < n; i += 2) {
+        memcpy(v + i * words, x, words * 4);
+        blockMix(x, y, r);
+        memcpy(v + (i + 1) * words, y, words * 4);
+        blockMix(y, x, r);
+    }
+    for (uint64_t i = 0; i < n; i += 2) {
+        uint64_t j = x[words - 16] & (n - 1);
+        for (size_t k = 0; k < words; k++) x[k] ^= v[j * words + k];
+        blockMix(x, y, r);
+        j = y[words - 16] & (n - 1);
+        for (size_t k = 0; k < words; k++) y[k] ^= v[j * words + k];
+        blockMix(y, x, r);
+    }
+    for (size_t k = 0; k < words; k++) store32(block + 4 * k, x[k]);
+}
+
+static int costInRange(int logN, int r, int p) {
+    return logN >= 1 && logN <= 30 && r >= 1 && r <= 32 && p >= 1 && p <= 16 &&
+           (128ull * r << logN) <= MAX_SCRYPT_BYTES;
+}
+
+int scrypt(const uint8_t* password, size_t passwordLength, const uint8_t* salt, size_t saltLength, int logN, int r,
+           int p, uint8_t* out, size_t outLength) {
+    if (!costInRange(logN, r, p)) return 0;
+    uint64_t n = 1ull << logN;
+    size_t blockBytes = 128 * (size_t)r;
+    uint32_t* v = scratchWords(blockBytes * (n + 2));
+    uint8_t* blocks = (uint8_t*)malloc(blockBytes * p);
+    if (!v || !blocks) {
+        free(blocks);
+        return 0;
+    }
+    pbkdf2Sha256(password, passwordLength, salt, saltLength, blocks, blockBytes * p);
+    // V, then the two BlockMix buffers
+    uint32_t* x = v + n * (blockBytes / 4);
+    for (int i = 0; i < p; i++) roMix(blocks + i * blockBytes, r, n, v, x, x + blockBytes / 4);
+    pbkdf2Sha256(password, passwordLength, blocks, blockBytes * p, out, outLength);
+    free(blocks);
+    return 1;
+}
+
+PasswordCost defaultPasswordCost(void) {
+    PasswordCost cost;
+    cost.logN = 14;
+    cost.r = 8;
+    cost.p = 1;
+    return cost;
+}
+
+static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Unpadded base64; returns the number of characters written
+static size_t encode64(const uint8_t* data, size_t length, char* out) {
+    size_t n = 0;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < length) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) v |= data[i + 2];
+        size_t chars = length - i >= 3 ? 4 : length - i + 1;
+        for (size_t k = 0; k < chars; k++) out[n++] = base64[(v >> (18 - 6 * k)) & 63];
+    }
+    out[n] = 0;
+    return n;
+}
+
+// Decodes up to the first character outside the alphabet into at most
+// capacity bytes. Returns the byte count, or -1 if it does not fit.
+static int decode64(const char* text, uint8_t* out, int capacity, const char** end) {
+    uint32_t v = 0;
+    int bits = 0, n = 0;
+    const char* p = text;
+    for (;; p++) {
+        const char* c = *p ? strchr(base64, *p) : NULL;
+        if (!c) break;
+        v = v << 6 | (uint32_t)(c - base64);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (n == capacity) return -1;
+            out[n++] = (uint8_t)(v >> bits);
+        }
+    }
+    *end = p;
+    return n;
+}
+
+typedef struct {
+    int logN, r, p;
+    uint8_t salt[SALT_BYTES];
+    int saltLength;
+    uint8_t hash[64];
+    int hashLength;
+} ParsedHash;
+
+static int parseHash(const char* stored, ParsedHash* h) {
+    int consumed = 0;
+    if (sscanf(stored, "$scrypt$%d$%d$%d$%n", &h->logN, &h->r, &h->p, &consumed) != 3 || consumed == 0) return 0;
+    if (!costInRange(h->logN, h->r, h->p)) return 0;
+    const char* p = stored + consumed;
+    h->saltLength = decode64(p, h->salt, sizeof(h->salt), &p);
+    if (h->saltLength <= 0 || *p != '$') return 0;
+    h->hashLength = decode64(p + 1, h->hash, sizeof(h->hash), &p);
+    return h->hashLength > 0 && *p == 0;
+}
+
+int hashPassword(const char* password, const PasswordCost* cost, char out[PASSWORD_HASH_MAX]) {
+    uint8_t salt[SALT_BYTES], hash[HASH_BYTES];
+    std::random_device random;
+    for (int i = 0; i < SALT_BYTES; i += 4) store32(salt + i, random());
+    if (!scrypt((const uint8_t*)password, strlen(password), salt, SALT_BYTES, cost->logN, cost->r, cost->p, hash,
+                HASH_BYTES))
+        return 0;
+    int n = snprintf(out, PASSWORD_HASH_MAX, "$scrypt$%d$%d$%d$", cost->logN, cost->r, cost->p);
+    n += (int)encode64(salt, SALT_BYTES, out + n);
+    out[n++] = '$';
+    encode64(hash, HASH_BYTES, out + n);
+    return 1;
+}
+
+int verifyPassword(const char* password, const char* stored) {
+    ParsedHash h;
+    if (!parseHash(stored, &h)) return 0;
+    uint8_t hash[64];
+    if (!scrypt((const uint8_t*)password, strlen(password), h.salt, h.saltLength, h.logN, h.r, h.p, hash,
+                h.hashLength))
+        return 0;
+    uint8_t diff = 0;
+    for (int i = 0; i < h.hashLength; i++) diff |= hash[i] ^ h.hash[i];
+    return diff == 0;
+}
+
+int isPasswordHash(const char* stored) {
+    ParsedHash h;
+    return parseHash(stored, &h);
+}
+
+int passwordNeedsRehash(const char* stored, const PasswordCost* cost) {
+    ParsedHash h;
+    return !parseHash(stored, &h) || h.logN != cost->logN || h.r != cost->r || h.p != cost->p;
+}
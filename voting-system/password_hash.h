@@ -0,0 +1,44 @@
+#ifndef PASSWORD_HASH_H
+#define PASSWORD_HASH_H
+
+// Salted password hashing with scrypt (RFC 7914): PBKDF2-HMAC-SHA256 around
+// a sequential memory-hard mix that needs 128 * r * 2^logN bytes, so each
+// guess costs an attacker that much memory as well as time. Hashes are
+// stored as
+//
+//   $scrypt$<logN>$<r>$<p>$<salt>$<hash>
+//
+// with a 16-byte random salt and a 32-byte hash in unpadded base64, so the
+// cost travels with each hash and can be raised without invalidating the
+// old ones. The string has no tabs or spaces and fits the snapshot fields.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PASSWORD_HASH_MAX 96        // with the NUL
+
+typedef struct {
+    int logN;                   // CPU/memory cost: 2^logN blocks
+    int r;                      // block size, 128 * r bytes
+    int p;                      // sequential repetitions
+} PasswordCost;
+
+// logN 14, r 8, p 1: 16 MB per hash
+PasswordCost defaultPasswordCost(void);
+
+// Returns 0 if the cost is out of range or memory ran out
+int hashPassword(const char* password, const PasswordCost* cost, char out[PASSWORD_HASH_MAX]);
+
+// 1 if password matches stored, 0 if not or stored is not a valid hash.
+// The final comparison takes the same time wherever the hashes differ.
+int verifyPassword(const char* password, const char* stored);
+
+int isPasswordHash(const char* stored);
+// Whether stored was hashed at a different cost than cost
+int passwordNeedsRehash(const char* stored, const PasswordCost* cost);
+
+// The raw KDF, for checking against the RFC vectors
+int scrypt(const uint8_t* password, size_t passwordLength, const uint8_t* salt, size_t saltLength, int logN, int r,
+           int p, uint8_t* out, size_t outLength);
+
+#endif // PASSWORD_HASH_H
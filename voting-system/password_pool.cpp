@@ -0,0 +1,142 @@
+#include "password_pool.h"
+
+#include <stdlib.h>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#define POOL_MAX_THREADS 64
+
+// Jobs submitted together; the submitter waits for remaining to reach 0
+typedef struct {
+    int remaining;
+    int succeeded;
+} PasswordBatch;
+
+typedef struct {
+    int verify;
+    const char* password;
+    const char* stored;         // verify
+    char* out;                  // hash
+    PasswordBatch* batch;
+} PasswordJob;
+
+struct PasswordPool {
+    PasswordPoolPolicy policy;
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull, finished;
+    PasswordJob** queue;        // ring of policy.queueDepth
+    int head, count;
+    bool stopping;
+    std::thread workers[POOL_MAX_THREADS];
+    int threads;
+    PasswordPoolStats stats;
+};
+
+PasswordPoolPolicy defaultPasswordPoolPolicy(void) {
+    PasswordPoolPolicy policy;
+    policy.threads = 0;
+    policy.queueDepth = 256;
+    policy.cost = defaultPasswordCost();
+    return policy;
+}
+
+static void workerLoop(PasswordPool* pool) {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    while (1) {
+        pool->notEmpty.wait(lock, [pool] { return pool->count > 0 || pool->stopping; });
+        if (pool->count == 0) return;
+        PasswordJob* job = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->policy.queueDepth;
+        pool->count--;
+        pool->notFull.notify_one();
+        lock.unlock();
+
+        int ok = job->verify ? verifyPassword(job->password, job->stored)
+                             : hashPassword(job->password, &pool->policy.cost, job->out);
+
+        lock.lock();
+        if (job->verify) pool->stats.verified++;
+        else pool->stats.hashed++;
+        job->batch->succeeded += ok;
+        if (--job->batch->remaining == 0) pool->finished.notify_all();
+    }
+}
+
+PasswordPool* createPasswordPool(const PasswordPoolPolicy* policy) {
+    PasswordPool* pool = new (std::nothrow) PasswordPool();
+    if (!pool) return NULL;
+    pool->policy = policy ? *policy : defaultPasswordPoolPolicy();
+    if (pool->policy.queueDepth < 1) pool->policy.queueDepth = 1;
+    pool->threads = pool->policy.threads > 0 ? pool->policy.threads : (int)std::thread::hardware_concurrency();
+    if (pool->threads < 1) pool->threads = 1;
+    if (pool->threads > POOL_MAX_THREADS) pool->threads = POOL_MAX_THREADS;
+    pool->queue = (PasswordJob**)malloc(sizeof(PasswordJob*) * pool->policy.queueDepth);
+    if (!pool->queue) {
+        delete pool;
+        return NULL;
+    }
+    for (int i = 0; i < pool->threads; i++) pool->workers[i] = std::thread(workerLoop, pool);
+    return pool;
+}
+
+void destroyPasswordPool(PasswordPool* pool) {
+    if (!pool) return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = true;
+    }
+    pool->notEmpty.notify_all();
+    for (int i = 0; i < pool->threads; i++) pool->workers[i].join();
+    free(pool->queue);
+    delete pool;
+}
+
+// Queues every job, blocking while the queue is full, then waits for them
+static int runJobs(PasswordPool* pool, PasswordJob* jobs, int count) {
+    PasswordBatch batch = {count, 0};
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    for (int i = 0; i < count; i++) {
+        jobs[i].batch = &batch;
+        if (pool->count == pool->policy.queueDepth) {
+            pool->stats.blockedSubmits++;
+            pool->notFull.wait(lock, [pool] { return pool->count < pool->policy.queueDepth; });
+        }
+        pool->queue[(pool->head + pool->count) % pool->policy.queueDepth] = &jobs[i];
+        pool->count++;
+        if (pool->count > pool->stats.maxQueued) pool->stats.maxQueued = pool->count;
+        pool->notEmpty.notify_one();
+    }
+    pool->finished.wait(lock, [&batch] { return batch.remaining == 0; });
+    return batch.succeeded;
+}
+
+int poolVerifyPassword(PasswordPool* pool, const char* password, const char* stored) {
+    PasswordJob job = {1, password, stored, NULL, NULL};
+    return runJobs(pool, &job, 1);
+}
+
+int poolHashPassword(PasswordPool* pool, const char* password, char out[PASSWORD_HASH_MAX]) {
+    PasswordJob job = {0, password, NULL, out, NULL};
+    return runJobs(pool, &job, 1);
+}
+
+int poolHashPasswords(PasswordPool* pool, const char* const* passwords, char (*out)[PASSWORD_HASH_MAX], int count) {
+    if (count <= 0) return 0;
+    PasswordJob* jobs = (PasswordJob*)malloc(sizeof(PasswordJob) * count);
+    if (!jobs) return 0;
+    for (int i = 0; i < count; i++) jobs[i] = {0, passwords[i], NULL, out[i], NULL};
+    int ok = runJobs(pool, jobs, count);
+    free(jobs);
+    return ok;
+}
+
+const PasswordCost* poolPasswordCost(const PasswordPool* pool) {
+    return &pool->policy.cost;
+}
+
+PasswordPoolStats passwordPoolStats(PasswordPool* pool) {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    return pool->stats;
+}
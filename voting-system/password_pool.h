@@ -0,0 +1,44 @@
+#ifndef PASSWORD_POOL_H
+#define PASSWORD_POOL_H
+
+// Bounded worker pool for password hashing and verification. A hash is
+// deliberately slow and needs a scrypt-sized block of memory, so at most
+// `threads` run at once and at most `queueDepth` more wait; past that,
+// callers block on submit. A surge of logins therefore queues up at a fixed
+// CPU and memory ceiling instead of starting one hash per request. Calls
+// block until their own job is done and may come from any thread.
+
+#include "password_hash.h"
+
+typedef struct {
+    int threads;                // 0 for one per core
+    int queueDepth;             // jobs waiting for a worker
+    PasswordCost cost;          // for new hashes
+} PasswordPoolPolicy;
+
+PasswordPoolPolicy defaultPasswordPoolPolicy(void);
+
+typedef struct PasswordPool PasswordPool;
+
+// Returns NULL if the workers could not be started
+PasswordPool* createPasswordPool(const PasswordPoolPolicy* policy);
+// Finishes the queued jobs first
+void destroyPasswordPool(PasswordPool* pool);
+
+int poolVerifyPassword(PasswordPool* pool, const char* password, const char* stored);
+int poolHashPassword(PasswordPool* pool, const char* password, char out[PASSWORD_HASH_MAX]);
+// Hashes count passwords across the workers. Returns how many succeeded.
+int poolHashPasswords(PasswordPool* pool, const char* const* passwords, char (*out)[PASSWORD_HASH_MAX], int count);
+
+const PasswordCost* poolPasswordCost(const PasswordPool* pool);
+
+typedef struct {
+    uint64_t hashed;
+    uint64_t verified;
+    uint64_t blockedSubmits;    // callers that found the queue full
+    int maxQueued;
+} PasswordPoolStats;
+
+PasswordPoolStats passwordPoolStats(PasswordPool* pool);
+
+#endif // PASSWORD_POOL_H
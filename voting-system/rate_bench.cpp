@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rate_limiter.h"
+#include "string_index.h"
+
+// Login storm against the rate limiter: `users` distinct keys spread over one
+// simulated minute, each trying `attempts` times, plus a handful of abusive
+// keys hammering throughout. Usage: rate_bench [users] [threads]
+
+#define ABUSERS 16
+#define ABUSER_REQUESTS 6000
+#define ATTEMPTS 3
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    long users = argc > 1 ? atol(argv[1]) : 500000L;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    RateLimitPolicy policy = defaultRateLimitPolicy();
+    RateLimiter* limiter = createRateLimiter(&policy);
+    if (!limiter) return 1;
+
+    // Requests are pre-hashed and time-stamped so only the decision is timed
+    typedef struct {
+        uint64_t hash;
+        int64_t at;
+    } Request;
+    long total = users * ATTEMPTS + (long)ABUSERS * ABUSER_REQUESTS;
+    std::vector<Request> requests(total);
+    const int64_t minute = 60 * 1000000LL;
+    char key[64];
+    long n = 0;
+    for (long u = 0; u < users; u++) {
+        snprintf(key, sizeof(key), "voter%ld@example.com", u);
+        uint64_t hash = hashString(key, strlen(key));
+        for (int a = 0; a < ATTEMPTS; a++) requests[n++] = {hash, u * minute / users + a * 1000};
+    }
+    std::vector<uint64_t> botHashes;
+    for (int b = 0; b < ABUSERS; b++) {
+        snprintf(key, sizeof(key), "bot%d", b);
+        botHashes.push_back(hashString(key, strlen(key)));
+        for (int r = 0; r < ABUSER_REQUESTS; r++) requests[n++] = {botHashes[b], (int64_t)r * minute / ABUSER_REQUESTS};
+    }
+    std::stable_sort(requests.begin(), requests.end(),
+                     [](const Request& a, const Request& b) { return a.at < b.at; });
+
+    std::vector<long> allowedBots(threads, 0);
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (long i = t; i < total; i += threads) {
+                int allow = rateLimitAllowHashed(limiter, requests[i].hash, requests[i].at);
+                if (std::find(botHashes.begin(), botHashes.end(), requests[i].hash) != botHashes.end())
+                    allowedBots[t] += allow;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    long bots = 0;
+    for (long b : allowedBots) bots += b;
+    RateLimitStats stats = rateLimitStats(limiter);
+    printf("%ld decisions, %d threads: %.0f ns/decision, %.1fM decisions/s\n",
+           total, threads, seconds * 1e9 / total, total / seconds / 1e6);
+    printf("allowed %llu, limited %llu, evicted %llu idle / %llu active\n",
+           (unsigned long long)stats.allowed, (unsigned long long)stats.limited,
+           (unsigned long long)stats.evictedIdle, (unsigned long long)stats.evictedActive);
+    printf("abusive keys: %.1f of %d requests allowed each (burst %d + refill %d)\n",
+           (double)bots / ABUSERS, ABUSER_REQUESTS, policy.burst, policy.burst - 1);
+
+    destroyRateLimiter(limiter);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "rate_limiter.h"
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+
+#include "string_index.h"
+
+#define RATE_SET_WAYS 7         // 16-byte header + 7 entries = two cache lines
+
+typedef struct {
+    uint64_t key;               // hashString() of the key, 0 = empty
+    int64_t tat;                // theoretical arrival time, microseconds
+} RateEntry;
+
+typedef struct alignas(128) {
+    std::atomic<uint32_t> lock;
+    uint8_t hand;               // CLOCK position
+    uint8_t referenced;         // CLOCK bit per way
+    uint8_t pad[10];
+    RateEntry entries[RATE_SET_WAYS];
+} RateSet;
+
+struct RateLimiter {
+    RateSet* sets;
+    uint64_t setMask;
+    int64_t interval;           // microseconds per token
+    int64_t tolerance;          // how far tat may run ahead of now
+    std::atomic<uint64_t> allowed, limited, evictedIdle, evictedActive;
+};
+
+RateLimitPolicy defaultRateLimitPolicy(void) {
+    RateLimitPolicy policy;
+    policy.maxKeys = 1 << 19;
+    policy.burst = 10;
+    policy.windowSeconds = 60;
+    return policy;
+}
+
+RateLimiter* createRateLimiter(const RateLimitPolicy* policy) {
+    RateLimitPolicy p = policy ? *policy : defaultRateLimitPolicy();
+    if (p.burst < 1) p.burst = 1;
+    if (p.windowSeconds < 1) p.windowSeconds = 1;
+
+    uint64_t sets = 1;
+    while (sets * RATE_SET_WAYS < (uint64_t)p.maxKeys) sets *= 2;
+    RateLimiter* limiter = new (std::nothrow) RateLimiter();
+    if (!limiter) return NULL;
+    limiter->sets = new (std::nothrow) RateSet[sets]();
+    if (!limiter->sets) {
+        delete limiter;
+        return NULL;
+    }
+    limiter->setMask = sets - 1;
+    limiter->interval = (int64_t)p.windowSeconds * 1000000 / p.burst;
+    limiter->tolerance = limiter->interval * (p.burst - 1);
+    return limiter;
+}
+
+void destroyRateLimiter(RateLimiter* limiter) {
+    if (!limiter) return;
+    delete[] limiter->sets;
+    delete limiter;
+}
+
+static void lockSet(RateSet* set) {
+    while (set->lock.exchange(1, std::memory_order_acquire)) {
+        while (set->lock.load(std::memory_order_relaxed)) std::this_thread::yield();
+    }
+}
+
+static void unlockSet(RateSet* set) {
+    set->lock.store(0, std::memory_order_release);
+}
+
+// Picks the way to reuse in a full set. A key whose bucket has refilled
+// (tat <= now) carries no state and goes first; otherwise classic CLOCK.
+static int victim(RateLimiter* limiter, RateSet* set, int64_t now) {
+    for (int way = 0; way < RATE_SET_WAYS; way++) {
+        if (set->entries[way].tat <= now) {
+            limiter->evictedIdle.fetch_add(1, std::memory_order_relaxed);
+            return way;
+        }
+    }
+    for (;;) {
+        int way = set->hand;
+        set->hand = (uint8_t)((way + 1) % RATE_SET_WAYS);
+        if (set->referenced & (1u << way)) {
+            set->referenced &= (uint8_t)~(1u << way);
+        } else {
+            limiter->evictedActive.fetch_add(1, std::memory_order_relaxed);
+            return way;
+        }
+    }
+}
+
+int rateLimitAllowHashed(RateLimiter* limiter, uint64_t hash, int64_t nowMicros) {
+    uint64_t key = hash ? hash : 1;
+    RateSet* set = &limiter->sets[(hash >> 32) & limiter->setMask];
+    int allow;
+
+    lockSet(set);
+    int way = -1, empty = -1;
+    for (int i = 0; i < RATE_SET_WAYS; i++) {
+        if (set->entries[i].key == key) {
+            way = i;
+            break;
+        }
+        if (set->entries[i].key == 0 && empty < 0) empty = i;
+    }
+    if (way < 0) {
+        // Unknown keys start with a full bucket
+        way = empty >= 0 ? empty : victim(limiter, set, nowMicros);
+        set->entries[way].key = key;
+        set->entries[way].tat = nowMicros;
+    }
+
+    RateEntry* e = &set->entries[way];
+    int64_t tat = e->tat > nowMicros ? e->tat : nowMicros;
+    allow = tat - nowMicros <= limiter->tolerance;
+    if (allow) e->tat = tat + limiter->interval;
+    set->referenced |= (uint8_t)(1u << way);
+    unlockSet(set);
+
+    (allow ? limiter->allowed : limiter->limited).fetch_add(1, std::memory_order_relaxed);
+    return allow;
+}
+
+int rateLimitAllow(RateLimiter* limiter, const char* key) {
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    return rateLimitAllowHashed(limiter, hashString(key, strlen(key)), now);
+}
+
+RateLimitStats rateLimitStats(const RateLimiter* limiter) {
+    RateLimitStats stats;
+    stats.allowed = limiter->allowed.load();
+    stats.limited = limiter->limited.load();
+    stats.evictedIdle = limiter->evictedIdle.load();
+    stats.evictedActive = limiter->evictedActive.load();
+    return stats;
+}
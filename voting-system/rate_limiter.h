@@ -0,0 +1,43 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+// Per-key rate limiter. Each key gets a token bucket of `burst` requests
+// that refills continuously at burst / windowSeconds, tracked GCRA-style as a
+// single "theoretical arrival time", so it behaves as a sliding window with
+// no per-request history. Keys live in a fixed-size set-associative table;
+// a full set evicts with CLOCK, preferring keys whose bucket has refilled
+// (those are indistinguishable from a new key anyway). Every decision is
+// O(1) and takes only the lock of the key's set, so callers may share one
+// limiter across threads.
+
+#include <stdint.h>
+
+typedef struct {
+    int maxKeys;                // keys tracked at once, rounded up to whole sets
+    int burst;                  // requests allowed back to back
+    int windowSeconds;          // time for an empty bucket to refill
+} RateLimitPolicy;
+
+RateLimitPolicy defaultRateLimitPolicy(void);
+
+typedef struct RateLimiter RateLimiter;
+
+// Returns NULL if memory could not be allocated
+RateLimiter* createRateLimiter(const RateLimitPolicy* policy);
+void destroyRateLimiter(RateLimiter* limiter);
+
+// Returns 1 and consumes a token if key may proceed, 0 if it is limited
+int rateLimitAllow(RateLimiter* limiter, const char* key);
+// Same, for a hashString() hash at an explicit steady-clock time
+int rateLimitAllowHashed(RateLimiter* limiter, uint64_t hash, int64_t nowMicros);
+
+typedef struct {
+    uint64_t allowed;
+    uint64_t limited;
+    uint64_t evictedIdle;       // evicted keys whose bucket had refilled
+    uint64_t evictedActive;     // evicted while still limited; table too small
+} RateLimitStats;
+
+RateLimitStats rateLimitStats(const RateLimiter* limiter);
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,75 @@
+#include "record_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void initRecordStore(RecordStore* store, size_t recordSize) {
+    memset(store, 0, sizeof(RecordStore));
+    store->recordSize = recordSize;
+}
+
+void freeRecordStore(RecordStore* store) {
+    for (int i = 0; i < STORE_MAX_CHUNKS && store->chunks[i]; i++) free(store->chunks[i]);
+    initRecordStore(store, store->recordSize);
+}
+
+void* storePush(RecordStore* store) {
+    int chunk = store->count >> STORE_CHUNK_SHIFT;
+    if (chunk >= STORE_MAX_CHUNKS) return NULL;
+    if (!store->chunks[chunk]) {
+        store->chunks[chunk] = (char*)malloc(store->recordSize << STORE_CHUNK_SHIFT);
+        if (!store->chunks[chunk]) return NULL;
+    }
+    void* record = storeAt(store, store->count++);
+    memset(record, 0, store->recordSize);
+    return record;
+}
+
+static const char* internedKey(int slot, void* ctx) {
+    return arenaGet((const StringArena*)ctx, (StrRef)slot);
+}
+
+int initStringArena(StringArena* arena) {
+    memset(arena, 0, sizeof(StringArena));
+    if (!initStringIndex(&arena->interned, 1024, internedKey, arena)) return 0;
+    // Ref 0: the empty string
+    return arenaAdd(arena, "") == 0 && arena->chunkCount == 1;
+}
+
+void freeStringArena(StringArena* arena) {
+    for (int i = 0; i < arena->chunkCount; i++) free(arena->chunks[i]);
+    freeStringIndex(&arena->interned);
+    arena->chunkCount = 0;
+}
+
+StrRef arenaAdd(StringArena* arena, const char* str) {
+    size_t length = strlen(str) + 1;
+    size_t chunkSize = (size_t)1 << ARENA_CHUNK_SHIFT;
+    if (length > chunkSize) return 0;
+    if (arena->chunkCount == 0 || arena->used + length > chunkSize) {
+        if (arena->chunkCount == ARENA_MAX_CHUNKS) return 0;
+        char* chunk = (char*)malloc(chunkSize);
+        if (!chunk) return 0;
+        arena->chunks[arena->chunkCount++] = chunk;
+        arena->used = 0;
+    }
+    size_t offset = ((size_t)(arena->chunkCount - 1) << ARENA_CHUNK_SHIFT) + arena->used;
+    memcpy(arena->chunks[arena->chunkCount - 1] + arena->used, str, length);
+    arena->used += (length + 3) & ~(size_t)3;
+    return (StrRef)(offset >> 2);
+}
+
+StrRef arenaIntern(StringArena* arena, const char* str) {
+    if (!*str) return 0;
+    uint64_t hash = hashString(str, strlen(str));
+    int slot = stringIndexFindHashed(&arena->interned, str, hash);
+    if (slot >= 0) return (StrRef)slot;
+    StrRef ref = arenaAdd(arena, str);
+    if (ref != 0) stringIndexInsertHashed(&arena->interned, hash, (int)ref);
+    return ref;
+}
+
+size_t arenaBytes(const StringArena* arena) {
+    if (arena->chunkCount == 0) return 0;
+    return ((size_t)(arena->chunkCount - 1) << ARENA_CHUNK_SHIFT) + arena->used;
+}
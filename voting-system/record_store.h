@@ -0,0 +1,66 @@
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+// Growable in-memory tables. Records and strings live in fixed-size chunks
+// that are never moved or freed until the store is, so pointers and
+// indexes stay valid while the store grows and a background thread (journal
+// compaction) can read existing entries while new ones are appended.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "string_index.h"
+
+// Fixed-size records in chunks of 2^STORE_CHUNK_SHIFT
+#define STORE_CHUNK_SHIFT 16
+#define STORE_MAX_CHUNKS 4096   // 268M records
+
+typedef struct {
+    size_t recordSize;
+    int count;
+    char* chunks[STORE_MAX_CHUNKS];
+} RecordStore;
+
+void initRecordStore(RecordStore* store, size_t recordSize);
+void freeRecordStore(RecordStore* store);
+
+// Appends a zeroed record and returns it, or NULL when out of memory
+void* storePush(RecordStore* store);
+
+static inline void* storeAt(const RecordStore* store, int i) {
+    return store->chunks[i >> STORE_CHUNK_SHIFT] +
+           (size_t)(i & ((1 << STORE_CHUNK_SHIFT) - 1)) * store->recordSize;
+}
+
+// Byte arena for the strings the records point at. A StrRef is the string's
+// offset in 4-byte units, so 32 bits address 8 GB. Ref 0 is the empty string,
+// which is also what a zeroed record holds.
+typedef uint32_t StrRef;
+
+#define ARENA_CHUNK_SHIFT 20    // 1 MB
+#define ARENA_MAX_CHUNKS 8192
+
+typedef struct {
+    char* chunks[ARENA_MAX_CHUNKS];
+    int chunkCount;
+    size_t used;                // bytes used in the last chunk
+    StringIndex interned;       // interned string -> StrRef
+} StringArena;
+
+int initStringArena(StringArena* arena);
+void freeStringArena(StringArena* arena);
+
+// Copies str into the arena. Returns 0 (the empty string) when out of memory.
+StrRef arenaAdd(StringArena* arena, const char* str);
+// Like arenaAdd, but equal strings share one copy. For low-cardinality
+// fields such as audit actions; unique strings are cheaper through arenaAdd.
+StrRef arenaIntern(StringArena* arena, const char* str);
+
+static inline const char* arenaGet(const StringArena* arena, StrRef ref) {
+    return arena->chunks[ref >> (ARENA_CHUNK_SHIFT - 2)] +
+           ((size_t)(ref & ((1u << (ARENA_CHUNK_SHIFT - 2)) - 1)) << 2);
+}
+
+size_t arenaBytes(const StringArena* arena);
+
+#endif // RECORD_STORE_H
@@ -0,0 +1,47 @@
+#include "secure_random.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <random>
+
+#include "vote_cipher.h"
+
+#define RANDOM_BUFFER_BLOCKS 16
+#define RANDOM_KEY_BYTES 32
+
+typedef struct {
+    uint32_t key[8];
+    uint8_t buffer[RANDOM_BUFFER_BLOCKS * 64];
+    size_t next;                // first unused byte of buffer
+    bool seeded;
+} RandomState;
+
+static thread_local RandomState randomState;
+
+static void refill(RandomState* state) {
+    if (!state->seeded) {
+        std::random_device device;
+        for (int i = 0; i < 8; i++) state->key[i] = device();
+        state->seeded = true;
+    }
+    static const uint8_t nonce[VOTE_NONCE_BYTES] = {0};
+    chacha20Blocks(state->key, 0, nonce, state->buffer, RANDOM_BUFFER_BLOCKS);
+    memcpy(state->key, state->buffer, RANDOM_KEY_BYTES);
+    memset(state->buffer, 0, RANDOM_KEY_BYTES);
+    state->next = RANDOM_KEY_BYTES;
+}
+
+void secureRandom(void* out, size_t length) {
+    RandomState* state = &randomState;
+    uint8_t* dest = (uint8_t*)out;
+    while (length > 0) {
+        if (!state->seeded || state->next == sizeof(state->buffer)) refill(state);
+        size_t n = sizeof(state->buffer) - state->next;
+        if (n > length) n = length;
+        memcpy(dest, state->buffer + state->next, n);
+        memset(state->buffer + state->next, 0, n);
+        state->next += n;
+        dest += n;
+        length -= n;
+    }
+}
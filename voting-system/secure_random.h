@@ -0,0 +1,16 @@
+#ifndef SECURE_RANDOM_H
+#define SECURE_RANDOM_H
+
+// Cryptographically secure random bytes without a system call per request.
+// Each thread runs its own ChaCha20 generator, keyed once from
+// std::random_device. A refill produces RANDOM_BUFFER_BLOCKS keystream
+// blocks: the first 32 bytes become the next key and the rest are handed
+// out, each byte zeroed as it goes ("fast key erasure"). So neither the
+// state nor the buffer reveals bytes that were already returned.
+
+#include <stddef.h>
+
+// Thread-safe: every thread has its own generator
+void secureRandom(void* out, size_t length);
+
+#endif // SECURE_RANDOM_H
@@ -0,0 +1,176 @@
+#include "session_table.h"
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+
+#include "secure_random.h"
+
+#define SESSION_SET_WAYS 4
+
+typedef struct {
+    uint8_t token[SESSION_TOKEN_BYTES];
+    int64_t lastSeen;           // steady-clock seconds
+    int32_t userSlot;           // -1 = empty
+} SessionEntry;
+
+typedef struct alignas(64) {
+    std::atomic<uint32_t> lock;
+    SessionEntry entries[SESSION_SET_WAYS];
+} SessionSet;
+
+struct SessionTable {
+    SessionSet* sets;
+    uint64_t setMask;
+    int64_t idleSeconds;
+    std::atomic<uint64_t> opened, lapsed, evicted;
+};
+
+SessionPolicy defaultSessionPolicy(void) {
+    SessionPolicy policy;
+    policy.maxSessions = 1 << 16;
+    policy.idleSeconds = 15 * 60;
+    return policy;
+}
+
+static int64_t nowSeconds(void) {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SessionTable* createSessionTable(const SessionPolicy* policy) {
+    SessionPolicy p = policy ? *policy : defaultSessionPolicy();
+    uint64_t sets = 1;
+    while (sets * SESSION_SET_WAYS < (uint64_t)p.maxSessions) sets *= 2;
+    SessionTable* table = new (std::nothrow) SessionTable();
+    if (!table) return NULL;
+    table->sets = new (std::nothrow) SessionSet[sets]();
+    if (!table->sets) {
+        delete table;
+        return NULL;
+    }
+    for (uint64_t s = 0; s < sets; s++) {
+        for (int way = 0; way < SESSION_SET_WAYS; way++) table->sets[s].entries[way].userSlot = -1;
+    }
+    table->setMask = sets - 1;
+    table->idleSeconds = p.idleSeconds > 0 ? p.idleSeconds : 1;
+    return table;
+}
+
+void destroySessionTable(SessionTable* table) {
+    if (!table) return;
+    delete[] table->sets;
+    delete table;
+}
+
+static void lockSet(SessionSet* set) {
+    while (set->lock.exchange(1, std::memory_order_acquire)) {
+        while (set->lock.load(std::memory_order_relaxed)) std::this_thread::yield();
+    }
+}
+
+static void unlockSet(SessionSet* set) {
+    set->lock.store(0, std::memory_order_release);
+}
+
+// Tokens are random, so their first bytes pick the set directly
+static SessionSet* setOf(SessionTable* table, const uint8_t token[SESSION_TOKEN_BYTES]) {
+    uint64_t bits;
+    memcpy(&bits, token, sizeof(bits));
+    return &table->sets[bits & table->setMask];
+}
+
+static int parseToken(const char* text, uint8_t token[SESSION_TOKEN_BYTES]) {
+    for (int i = 0; i < SESSION_TOKEN_BYTES; i++) {
+        int value = 0;
+        for (int k = 0; k < 2; k++) {
+            char c = text[2 * i + k];
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (digit < 0) return 0;
+            value = value << 4 | digit;
+        }
+        token[i] = (uint8_t)value;
+    }
+    return text[SESSION_TOKEN_CHARS] == 0;
+}
+
+void sessionOpen(SessionTable* table, int userSlot, char text[SESSION_TOKEN_CHARS + 1]) {
+    uint8_t token[SESSION_TOKEN_BYTES];
+    secureRandom(token, sizeof(token));
+    for (int i = 0; i < SESSION_TOKEN_BYTES; i++) {
+        static const char hex[] = "0123456789abcdef";
+        text[2 * i] = hex[token[i] >> 4];
+        text[2 * i + 1] = hex[token[i] & 15];
+    }
+    text[SESSION_TOKEN_CHARS] = 0;
+
+    int64_t now = nowSeconds();
+    SessionSet* set = setOf(table, token);
+    lockSet(set);
+    int way = 0;
+    for (int i = 0; i < SESSION_SET_WAYS; i++) {
+        const SessionEntry* e = &set->entries[i];
+        if (e->userSlot < 0 || now - e->lastSeen > table->idleSeconds) {
+            way = i;
+            break;
+        }
+        if (e->lastSeen < set->entries[way].lastSeen) way = i;
+    }
+    SessionEntry* e = &set->entries[way];
+    if (e->userSlot >= 0 && now - e->lastSeen <= table->idleSeconds) table->evicted.fetch_add(1, std::memory_order_relaxed);
+    memcpy(e->token, token, SESSION_TOKEN_BYTES);
+    e->lastSeen = now;
+    e->userSlot = userSlot;
+    unlockSet(set);
+    table->opened.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Finds token in its set and, if it is live, returns the entry with the set
+// still locked
+static SessionEntry* findLocked(SessionTable* table, const char* text, SessionSet** locked) {
+    uint8_t token[SESSION_TOKEN_BYTES];
+    if (!parseToken(text, token)) return NULL;
+    SessionSet* set = setOf(table, token);
+    lockSet(set);
+    for (int i = 0; i < SESSION_SET_WAYS; i++) {
+        SessionEntry* e = &set->entries[i];
+        if (e->userSlot < 0 || memcmp(e->token, token, SESSION_TOKEN_BYTES) != 0) continue;
+        if (nowSeconds() - e->lastSeen > table->idleSeconds) {
+            e->userSlot = -1;
+            table->lapsed.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        *locked = set;
+        return e;
+    }
+    unlockSet(set);
+    return NULL;
+}
+
+int sessionUser(SessionTable* table, const char* token) {
+    SessionSet* set;
+    SessionEntry* e = findLocked(table, token, &set);
+    if (!e) return -1;
+    e->lastSeen = nowSeconds();
+    int slot = e->userSlot;
+    unlockSet(set);
+    return slot;
+}
+
+void sessionClose(SessionTable* table, const char* token) {
+    SessionSet* set;
+    SessionEntry* e = findLocked(table, token, &set);
+    if (!e) return;
+    e->userSlot = -1;
+    unlockSet(set);
+}
+
+SessionStats sessionStats(const SessionTable* table) {
+    SessionStats stats;
+    stats.opened = table->opened.load();
+    stats.lapsed = table->lapsed.load();
+    stats.evicted = table->evicted.load();
+    return stats;
+}
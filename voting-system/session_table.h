@@ -0,0 +1,44 @@
+#ifndef SESSION_TABLE_H
+#define SESSION_TABLE_H
+
+// Logged-in sessions for server mode. A session is a random 128-bit token
+// (sent to the client as 32 hex digits) mapped to a users[] slot, and lapses
+// after idleSeconds without use. Sessions live in a fixed-size
+// set-associative table with a lock per set, as in the rate limiter; a full
+// set reuses a lapsed entry, or else the one idle longest. Every call is
+// O(1) and safe from any thread.
+
+#include <stdint.h>
+
+#define SESSION_TOKEN_BYTES 16
+#define SESSION_TOKEN_CHARS (2 * SESSION_TOKEN_BYTES)
+
+typedef struct {
+    int maxSessions;            // rounded up to whole sets
+    int idleSeconds;
+} SessionPolicy;
+
+SessionPolicy defaultSessionPolicy(void);
+
+typedef struct SessionTable SessionTable;
+
+// Returns NULL if memory could not be allocated
+SessionTable* createSessionTable(const SessionPolicy* policy);
+void destroySessionTable(SessionTable* table);
+
+// Starts a session for userSlot and writes its token (NUL-terminated)
+void sessionOpen(SessionTable* table, int userSlot, char token[SESSION_TOKEN_CHARS + 1]);
+// The session's user slot, restarting its idle time; -1 if the token is
+// unknown or has lapsed
+int sessionUser(SessionTable* table, const char* token);
+void sessionClose(SessionTable* table, const char* token);
+
+typedef struct {
+    uint64_t opened;
+    uint64_t lapsed;            // found past idleSeconds
+    uint64_t evicted;           // still live, but their set was full
+} SessionStats;
+
+SessionStats sessionStats(const SessionTable* table);
+
+#endif // SESSION_TABLE_H
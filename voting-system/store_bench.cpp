@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+
+#include "record_store.h"
+
+// Memory per voter with the arena-backed stores vs. the old fixed 100-byte
+// string records. Each voter registers, votes once and leaves two audit
+// records, as in the app. Usage: store_bench [voters]
+
+#define MAX_STRING 100
+
+using Clock = std::chrono::steady_clock;
+
+// Old layouts
+typedef struct {
+    char username[MAX_STRING];
+    char password[MAX_STRING];
+    char fullName[MAX_STRING];
+    int isEmailVerified;
+    int isAdmin;
+} OldUser;
+
+typedef struct {
+    char userId[MAX_STRING];
+    char encryptedCandidateId[MAX_STRING];
+    time_t voteDate;
+} OldVote;
+
+typedef struct {
+    char userId[MAX_STRING];
+    char action[MAX_STRING];
+    time_t timestamp;
+    char details[MAX_STRING];
+} OldAuditLog;
+
+// New layouts, as in main.cpp
+typedef struct {
+    StrRef username;
+    StrRef password;
+    StrRef fullName;
+    int isEmailVerified;
+    int isAdmin;
+} User;
+
+typedef struct {
+    StrRef userId;
+    StrRef encryptedCandidateId;
+    time_t voteDate;
+} Vote;
+
+typedef struct {
+    StrRef userId;
+    StrRef action;
+    time_t timestamp;
+    StrRef details;
+} AuditLog;
+
+static size_t storeBytes(const RecordStore* store) {
+    size_t chunks = ((size_t)store->count + (1 << STORE_CHUNK_SHIFT) - 1) >> STORE_CHUNK_SHIFT;
+    return chunks * (store->recordSize << STORE_CHUNK_SHIFT);
+}
+
+int main(int argc, char** argv) {
+    long voters = argc > 1 ? atol(argv[1]) : 5000000L;
+    RecordStore users, votes, auditLogs;
+    StringArena strings;
+    initRecordStore(&users, sizeof(User));
+    initRecordStore(&votes, sizeof(Vote));
+    initRecordStore(&auditLogs, sizeof(AuditLog));
+    if (!initStringArena(&strings)) return 1;
+
+    Clock::time_point start = Clock::now();
+    char username[64], password[32], fullName[32], encrypted[8], details[32];
+    for (long i = 0; i < voters; i++) {
+        snprintf(username, sizeof(username), "voter%ld@example.com", i);
+        snprintf(password, sizeof(password), "Pass%ld!", i);
+        snprintf(fullName, sizeof(fullName), "Voter %ld", i);
+        User* u = (User*)storePush(&users);
+        Vote* v = (Vote*)storePush(&votes);
+        AuditLog* registered = (AuditLog*)storePush(&auditLogs);
+        AuditLog* voted = (AuditLog*)storePush(&auditLogs);
+        if (!u || !v || !registered || !voted) {
+            printf("out of memory after %ld voters\n", i);
+            return 1;
+        }
+        u->username = arenaAdd(&strings, username);
+        u->password = arenaAdd(&strings, password);
+        u->fullName = arenaAdd(&strings, fullName);
+        u->isEmailVerified = 1;
+
+        int candidate = 1 + (int)(i % 12);
+        snprintf(encrypted, sizeof(encrypted), "%d", candidate);
+        for (char* p = encrypted; *p; p++) *p ^= 'S';
+        v->userId = u->username;
+        v->encryptedCandidateId = arenaIntern(&strings, encrypted);
+        v->voteDate = 1700000000L + i;
+
+        snprintf(details, sizeof(details), "Voted for candidate %d", candidate);
+        registered->userId = u->username;
+        registered->action = arenaIntern(&strings, "Register");
+        registered->timestamp = v->voteDate;
+        registered->details = arenaIntern(&strings, "User registered and verified");
+        voted->userId = u->username;
+        voted->action = arenaIntern(&strings, "Vote");
+        voted->timestamp = v->voteDate;
+        voted->details = arenaIntern(&strings, details);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t before = sizeof(OldUser) + sizeof(OldVote) + 2 * sizeof(OldAuditLog);
+    size_t after = storeBytes(&users) + storeBytes(&votes) + storeBytes(&auditLogs) + arenaBytes(&strings);
+    printf("%ld voters loaded in %.2f s\n", voters, seconds);
+    printf("old records: %zu bytes/voter (vote %zu)\n", before, sizeof(OldVote));
+    printf("new records: %.1f bytes/voter (vote %zu, arena %.1f)\n", (double)after / voters, sizeof(Vote),
+           (double)arenaBytes(&strings) / voters);
+    printf("50M voters: %.1f GB before, %.1f GB after (indexes not included)\n",
+           50e6 * before / 1e9, 50e6 * after / voters / 1e9);
+
+    freeRecordStore(&users);
+    freeRecordStore(&votes);
+    freeRecordStore(&auditLogs);
+    freeStringArena(&strings);
+    return 0;
+}
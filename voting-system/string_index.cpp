@@ -0,0 +1,110 @@
+#include "string_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LOAD_PERCENT 70
+
+uint64_t hashString(const char* key, size_t length) {
+    uint64_t h = 0x243F6A8885A308D3ull ^ (length * 0x9E3779B97F4A7C15ull);
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, key, 8);
+        h = (h ^ word) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 29;
+        key += 8;
+        length -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, key, length);
+    h = (h ^ tail) * 0x9E3779B97F4A7C15ull;
+    // fmix64 from MurmurHash3
+    h ^= h >> 33; h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t capacityFor(int expected) {
+    uint64_t capacity = 16;
+    while (capacity * MAX_LOAD_PERCENT / 100 < (uint64_t)expected) capacity *= 2;
+    return capacity;
+}
+
+static IndexEntry* allocEntries(uint64_t capacity) {
+    IndexEntry* entries = (IndexEntry*)malloc(sizeof(IndexEntry) * capacity);
+    if (entries) {
+        for (uint64_t i = 0; i < capacity; i++) entries[i].slot = -1;
+    }
+    return entries;
+}
+
+int initStringIndex(StringIndex* index, int expected, IndexKey keyOf, void* ctx) {
+    uint64_t capacity = capacityFor(expected);
+    index->entries = allocEntries(capacity);
+    index->mask = capacity - 1;
+    index->count = 0;
+    index->keyOf = keyOf;
+    index->ctx = ctx;
+    return index->entries != NULL;
+}
+
+void freeStringIndex(StringIndex* index) {
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+}
+
+void clearStringIndex(StringIndex* index) {
+    for (uint64_t i = 0; i <= index->mask; i++) index->entries[i].slot = -1;
+    index->count = 0;
+}
+
+int stringIndexFindHashed(const StringIndex* index, const char* key, uint64_t hash) {
+    uint32_t tag = (uint32_t)(hash >> 32);
+    for (uint64_t i = hash & index->mask;; i = (i + 1) & index->mask) {
+        const IndexEntry* e = &index->entries[i];
+        if (e->slot < 0) return -1;
+        if (e->tag == tag && strcmp(index->keyOf(e->slot, index->ctx), key) == 0) return e->slot;
+    }
+}
+
+int stringIndexFind(const StringIndex* index, const char* key) {
+    return stringIndexFindHashed(index, key, hashString(key, strlen(key)));
+}
+
+static void place(IndexEntry* entries, uint64_t mask, uint64_t hash, int slot) {
+    uint64_t i = hash & mask;
+    while (entries[i].slot >= 0) i = (i + 1) & mask;
+    entries[i].tag = (uint32_t)(hash >> 32);
+    entries[i].slot = slot;
+}
+
+static int grow(StringIndex* index) {
+    uint64_t capacity = (index->mask + 1) * 2;
+    IndexEntry* entries = allocEntries(capacity);
+    if (!entries) return 0;
+    for (uint64_t i = 0; i <= index->mask; i++) {
+        int slot = index->entries[i].slot;
+        if (slot < 0) continue;
+        const char* key = index->keyOf(slot, index->ctx);
+        place(entries, capacity - 1, hashString(key, strlen(key)), slot);
+    }
+    free(index->entries);
+    index->entries = entries;
+    index->mask = capacity - 1;
+    return 1;
+}
+
+int stringIndexInsertHashed(StringIndex* index, uint64_t hash, int slot) {
+    if ((uint64_t)(index->count + 1) * 100 > (index->mask + 1) * MAX_LOAD_PERCENT) {
+        if (!grow(index)) return 0;
+    }
+    place(index->entries, index->mask, hash, slot);
+    index->count++;
+    return 1;
+}
+
+int stringIndexInsert(StringIndex* index, const char* key, int slot) {
+    return stringIndexInsertHashed(index, hashString(key, strlen(key)), slot);
+}
@@ -0,0 +1,43 @@
+#ifndef STRING_INDEX_H
+#define STRING_INDEX_H
+
+// Open-addressing hash index from a string key to a record slot (an index
+// into users[], votes[], ...). Keys are not copied: each 8-byte entry holds
+// the record slot plus 32 bits of the key's hash, and the key itself is read
+// back from the record through keyOf() only when the hash bits match.
+// Records are never removed, so there are no tombstones.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef const char* (*IndexKey)(int slot, void* ctx);
+
+typedef struct {
+    uint32_t tag;               // high hash bits
+    int32_t slot;               // -1 = empty
+} IndexEntry;
+
+typedef struct {
+    IndexEntry* entries;
+    uint64_t mask;
+    int count;
+    IndexKey keyOf;
+    void* ctx;
+} StringIndex;
+
+uint64_t hashString(const char* key, size_t length);
+
+// Returns 0 if memory could not be allocated
+int initStringIndex(StringIndex* index, int expected, IndexKey keyOf, void* ctx);
+void freeStringIndex(StringIndex* index);
+void clearStringIndex(StringIndex* index);
+
+// Returns the slot for key, or -1
+int stringIndexFind(const StringIndex* index, const char* key);
+int stringIndexFindHashed(const StringIndex* index, const char* key, uint64_t hash);
+
+// key must not already be present. Returns 0 on allocation failure.
+int stringIndexInsert(StringIndex* index, const char* key, int slot);
+int stringIndexInsertHashed(StringIndex* index, uint64_t hash, int slot);
+
+#endif // STRING_INDEX_H
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "vote_cipher.h"
+#include "vote_tally.h"
+
+// Startup recount rate: ChaCha20 ballots opened in batches the way
+// main.cpp's recount does, tallied on one thread and then on every core.
+// Usage: tally_bench [votes] [candidates]
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static VoteCipher cipher;
+
+// Ballot i is bound to voter i
+static void voterRange(long first, int count, uint64_t* voters) {
+    for (int i = 0; i < count; i++) voters[i] = (uint64_t)(first + i);
+}
+
+static void decode(long first, int count, int* ids, void* ctx) {
+    uint64_t voters[TALLY_BATCH];
+    voterRange(first, count, voters);
+    openVotes(&cipher, (const VoteBallot*)ctx + first, voters, count, ids);
+}
+
+int main(int argc, char** argv) {
+    long votes = argc > 1 ? atol(argv[1]) : 100000000L;
+    int candidates = argc > 2 ? atoi(argv[2]) : 100;
+    if (candidates < 1) return 1;
+
+    uint8_t key[VOTE_KEY_BYTES];
+    for (int i = 0; i < VOTE_KEY_BYTES; i++) key[i] = (uint8_t)(i * 37 + 11);
+    initVoteCipher(&cipher, key);
+
+    VoteBallot* ballots = (VoteBallot*)malloc(sizeof(VoteBallot) * votes);
+    long* expected = (long*)calloc(candidates + 1, sizeof(long));
+    long* counts = (long*)malloc(sizeof(long) * (candidates + 1));
+    if (!ballots || !expected || !counts) return 1;
+    unsigned seed = 12345;
+    int ids[TALLY_BATCH];
+    uint64_t voters[TALLY_BATCH];
+    for (long i = 0; i < votes; i += TALLY_BATCH) {
+        int n = votes - i < TALLY_BATCH ? (int)(votes - i) : TALLY_BATCH;
+        for (int k = 0; k < n; k++) {
+            seed = seed * 1103515245u + 12345u;
+            ids[k] = 1 + (int)((seed >> 8) % (unsigned)candidates);
+            expected[ids[k]]++;
+        }
+        voterRange(i, n, voters);
+        sealVotes(&cipher, ids, voters, n, ballots + i);
+    }
+    printf("%ld votes over %d candidates, %u cores\n", votes, candidates, std::thread::hardware_concurrency());
+
+    int runs[2] = {1, 0};
+    for (int r = 0; r < 2; r++) {
+        Clock::time_point start = Clock::now();
+        long invalid = tallyVotes(votes, candidates, decode, ballots, counts, runs[r]);
+        double seconds = secondsSince(start);
+        int wrong = invalid != 0;
+        for (int id = 0; id <= candidates; id++) wrong += counts[id] != expected[id];
+        printf("%-10s %6.2f s  %6.1f M votes/s  %s\n", runs[r] ? "1 thread:" : "all cores:", seconds,
+               votes / seconds / 1e6, wrong ? "MISMATCH" : "ok");
+    }
+
+    free(ballots);
+    free(expected);
+    free(counts);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "secure_random.h"
+#include "token_service.h"
+#include "vote_cipher.h"
+
+// Cost of a verification/CSRF token: the old sprintf of rand() % 10000,
+// secureRandom() alone, and issue and redeem through a TokenTable, on one
+// thread and then on several at once (each issuing and redeeming its own
+// tokens). Also checks the redeem rules: once only, same subject only,
+// not after ttlSeconds.
+// Usage: token_bench [tokens per thread] [max threads]
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// The batched keystream secureRandom() refills from must match block by block
+static int checkKeystream() {
+    uint32_t key[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t nonce[VOTE_NONCE_BYTES] = {9}, blocks[7 * 64], one[64];
+    chacha20Blocks(key, 5, nonce, blocks, 7);
+    for (int b = 0; b < 7; b++) {
+        chacha20Block(key, 5 + b, nonce, one);
+        if (memcmp(one, blocks + 64 * b, 64) != 0) return 0;
+    }
+    return 1;
+}
+
+static int checkRules() {
+    TokenPolicy policy = defaultTokenPolicy();
+    policy.ttlSeconds = 1;
+    TokenTable* table = createTokenTable(&policy);
+    if (!table) return 0;
+    char a[TOKEN_CHARS + 1], b[TOKEN_CHARS + 1], c[TOKEN_CHARS + 1];
+    int ok = tokenIssue(table, 1, a) && tokenIssue(table, 1, b) && tokenIssue(table, 2, c);
+    ok &= strcmp(a, b) != 0 && strlen(a) == TOKEN_CHARS;
+    ok &= tokenRedeem(table, 1, a) && !tokenRedeem(table, 1, a);    // once only
+    ok &= !tokenRedeem(table, 2, b) && !tokenRedeem(table, 1, b);   // wrong subject uses it up
+    ok &= !tokenRedeem(table, 1, "TOKEN1234") && !tokenRedeem(table, 1, "");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    ok &= !tokenRedeem(table, 2, c);                                 // expired
+    TokenStats stats = tokenStats(table);
+    ok &= stats.issued == 3 && stats.redeemed == 1 && stats.rejected == 6 && stats.expired == 1;
+    destroyTokenTable(table);
+
+    // A table far smaller than the tokens outstanding evicts the oldest
+    policy = defaultTokenPolicy();
+    policy.capacity = 64;
+    table = createTokenTable(&policy);
+    char tokens[1000][TOKEN_CHARS + 1];
+    for (int i = 0; i < 1000; i++) ok &= tokenIssue(table, 7, tokens[i]);
+    int live = 0;
+    for (int i = 0; i < 1000; i++) live += tokenRedeem(table, 7, tokens[i]);
+    ok &= live == 64 && tokenStats(table).evicted == 1000 - 64;
+    destroyTokenTable(table);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000L;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 16;
+    if (n < 1 || maxThreads < 1) return 1;
+
+    int rules = checkKeystream() && checkRules();
+    printf("keystream and redeem rules: %s\n", rules ? "ok" : "FAILED");
+
+    char text[TOKEN_CHARS + 1];
+    long sink = 0;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; i++) {
+        sprintf(text, "TOKEN%d", rand() % 10000);
+        sink += text[5];
+    }
+    printf("old rand() token:      %7.1f ns\n", nsSince(start) / n);
+
+    uint8_t bytes[TOKEN_BYTES];
+    start = Clock::now();
+    for (long i = 0; i < n; i++) {
+        secureRandom(bytes, sizeof(bytes));
+        sink += bytes[0];
+    }
+    printf("secureRandom 16 bytes: %7.1f ns\n", nsSince(start) / n);
+
+    // Issue n tokens, then redeem them all, with at most capacity outstanding
+    TokenTable* table = createTokenTable(NULL);
+    if (!table) return 1;
+    std::vector<char> issued((size_t)n * (TOKEN_CHARS + 1));
+    start = Clock::now();
+    for (long i = 0; i < n; i++) tokenIssue(table, (uint64_t)i, &issued[(size_t)i * (TOKEN_CHARS + 1)]);
+    double issueNs = nsSince(start) / n;
+    long redeemed = 0;
+    start = Clock::now();
+    for (long i = 0; i < n; i++) redeemed += tokenRedeem(table, (uint64_t)i, &issued[(size_t)i * (TOKEN_CHARS + 1)]);
+    double redeemNs = nsSince(start) / n;
+    printf("issue:                 %7.1f ns\nredeem:                %7.1f ns (%ld of %ld still outstanding)\n",
+           issueNs, redeemNs, redeemed, n);
+    destroyTokenTable(table);
+
+    printf("threads  issue+redeem ns  (wall time per pair)\n");
+    int bad = !rules;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        table = createTokenTable(NULL);
+        std::atomic<long> failed{0}, contended{0};
+        std::vector<std::thread> workers;
+        start = Clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                char token[TOKEN_CHARS + 1];
+                for (long i = 0; i < n / threads; i++) {
+                    uint64_t subject = (uint64_t)t << 32 | (uint64_t)i;
+                    if (!tokenIssue(table, subject, token)) contended++;
+                    else if (!tokenRedeem(table, subject, token)) failed++;
+                }
+            });
+        }
+        for (std::thread& w : workers) w.join();
+        printf("%7d %16.1f  (%ld issues lost every claim)\n", threads, nsSince(start) / (n / threads * threads),
+               contended.load());
+        if (failed) bad = 1;
+        destroyTokenTable(table);
+    }
+    return bad || sink == 0;
+}
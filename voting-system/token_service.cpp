@@ -0,0 +1,224 @@
+#include "token_service.h"
+
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#include "secure_random.h"
+
+#define TOKEN_BUCKET_SLOTS 4
+#define TOKEN_MAX_ATTEMPTS 16
+#define TOKEN_GENERATION_BITS 22
+
+// Slot state: expiry (milliseconds since the table was created) << 24 |
+// generation << 2 | kind. Every claim bumps the generation, so a reader that
+// saw one token cannot clear the slot once it holds another, and expiry
+// rides along so a bucket can be scanned from the state words alone.
+enum { SLOT_EMPTY = 0, SLOT_WRITING = 1, SLOT_LIVE = 2 };
+
+static inline uint64_t kindOf(uint64_t state) { return state & 3; }
+static inline int64_t expiresOf(uint64_t state) { return (int64_t)(state >> (TOKEN_GENERATION_BITS + 2)); }
+
+static inline uint64_t nextState(uint64_t state, int64_t expires, uint64_t kind) {
+    uint64_t generation = ((state >> 2) + 1) & ((1u << TOKEN_GENERATION_BITS) - 1);
+    return (uint64_t)expires << (TOKEN_GENERATION_BITS + 2) | generation << 2 | kind;
+}
+
+// The token and subject are written between WRITING and LIVE and read
+// optimistically: a reader checks the state word again afterwards, as with
+// a seqlock. A bucket is two cache lines.
+typedef struct {
+    std::atomic<uint64_t> state;
+    std::atomic<uint64_t> token[2];
+    std::atomic<uint64_t> subject;
+} TokenSlot;
+
+typedef struct alignas(128) {
+    TokenSlot slots[TOKEN_BUCKET_SLOTS];
+} TokenBucket;
+
+struct TokenTable {
+    TokenBucket* buckets;
+    uint64_t mask;
+    int64_t ttlMillis;
+    int64_t epochMillis;
+    alignas(64) std::atomic<uint64_t> issued, redeemed, rejected, expired, evicted, contended;
+};
+
+TokenPolicy defaultTokenPolicy(void) {
+    TokenPolicy policy;
+    policy.capacity = 1 << 14;
+    policy.ttlSeconds = 10 * 60;
+    return policy;
+}
+
+// Expiry does not need better than the coarse clock's few milliseconds
+static int64_t clockMillis(void) {
+#ifdef CLOCK_MONOTONIC_COARSE
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#else
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static inline int64_t nowMillis(const TokenTable* table) {
+    return clockMillis() - table->epochMillis;
+}
+
+TokenTable* createTokenTable(const TokenPolicy* policy) {
+    TokenPolicy p = policy ? *policy : defaultTokenPolicy();
+    uint64_t buckets = 1;
+    while (buckets * TOKEN_BUCKET_SLOTS < (uint64_t)p.capacity) buckets *= 2;
+    TokenTable* table = new (std::nothrow) TokenTable();
+    if (!table) return NULL;
+    table->buckets = new (std::nothrow) TokenBucket[buckets]();
+    if (!table->buckets) {
+        delete table;
+        return NULL;
+    }
+    table->mask = buckets - 1;
+    table->ttlMillis = 1000 * (int64_t)(p.ttlSeconds > 0 ? p.ttlSeconds : 1);
+    // Starting at 1 leaves expiry 0 (an empty slot) always in the past
+    table->epochMillis = clockMillis() - 1;
+    return table;
+}
+
+void destroyTokenTable(TokenTable* table) {
+    if (!table) return;
+    delete[] table->buckets;
+    delete table;
+}
+
+static inline TokenSlot* bucketOf(TokenTable* table, uint64_t first) {
+    return table->buckets[first & table->mask].slots;
+}
+
+static void formatToken(const uint64_t token[2], char text[TOKEN_CHARS + 1]) {
+    static const char hex[] = "0123456789abcdef";
+    uint8_t bytes[TOKEN_BYTES];
+    memcpy(bytes, token, TOKEN_BYTES);
+    for (int i = 0; i < TOKEN_BYTES; i++) {
+        text[2 * i] = hex[bytes[i] >> 4];
+        text[2 * i + 1] = hex[bytes[i] & 15];
+    }
+    text[TOKEN_CHARS] = 0;
+}
+
+// Hex digit values, 16 for anything else (including the NUL of a short token)
+static const struct HexDigits {
+    uint8_t value[256];
+    HexDigits() {
+        memset(value, 16, sizeof(value));
+        for (int i = 0; i < 10; i++) value['0' + i] = (uint8_t)i;
+        for (int i = 0; i < 6; i++) value['a' + i] = (uint8_t)(10 + i);
+    }
+} hexDigits;
+
+static int parseToken(const char* text, uint64_t token[2]) {
+    uint8_t bytes[TOKEN_BYTES];
+    for (int i = 0; i < TOKEN_BYTES; i++) {
+        uint8_t high = hexDigits.value[(uint8_t)text[2 * i]];
+        if (high == 16) return 0;
+        uint8_t low = hexDigits.value[(uint8_t)text[2 * i + 1]];
+        if (low == 16) return 0;
+        bytes[i] = (uint8_t)(high << 4 | low);
+    }
+    memcpy(token, bytes, TOKEN_BYTES);
+    return text[TOKEN_CHARS] == 0;
+}
+
+int tokenIssue(TokenTable* table, uint64_t subject, char text[TOKEN_CHARS + 1]) {
+    uint64_t token[2];
+    secureRandom(token, sizeof(token));
+    formatToken(token, text);
+    int64_t now = nowMillis(table);
+    int64_t expires = now + table->ttlMillis;
+    TokenSlot* bucket = bucketOf(table, token[0]);
+
+    // A free or expired slot if there is one, else the live token closest
+    // to expiry. The scan starts at a random slot, so ties (tokens issued
+    // in the same millisecond) do not always evict the same slot. Only a
+    // lost race (another thread claimed the slot) retries, and losing
+    // TOKEN_MAX_ATTEMPTS of them fails the issue.
+    for (int attempt = 0; attempt < TOKEN_MAX_ATTEMPTS; attempt++) {
+        TokenSlot* victim = NULL;
+        uint64_t victimState = 0;
+        for (int i = 0; i < TOKEN_BUCKET_SLOTS; i++) {
+            TokenSlot* slot = &bucket[(token[1] + i) & (TOKEN_BUCKET_SLOTS - 1)];
+            uint64_t state = slot->state.load(std::memory_order_acquire);
+            if (kindOf(state) == SLOT_WRITING) continue;
+            if (!victim || expiresOf(state) < expiresOf(victimState)) {
+                victim = slot;
+                victimState = state;
+            }
+            if (kindOf(state) == SLOT_EMPTY || expiresOf(state) < now) break;
+        }
+        if (!victim) continue;
+        uint64_t claimed = nextState(victimState, expires, SLOT_WRITING);
+        if (!victim->state.compare_exchange_strong(victimState, claimed, std::memory_order_acq_rel)) continue;
+        std::atomic_thread_fence(std::memory_order_release);
+        if (kindOf(victimState) == SLOT_LIVE) {
+            if (expiresOf(victimState) < now) table->expired.fetch_add(1, std::memory_order_relaxed);
+            else table->evicted.fetch_add(1, std::memory_order_relaxed);
+        }
+        victim->token[0].store(token[0], std::memory_order_relaxed);
+        victim->token[1].store(token[1], std::memory_order_relaxed);
+        victim->subject.store(subject, std::memory_order_relaxed);
+        victim->state.store((claimed & ~(uint64_t)3) | SLOT_LIVE, std::memory_order_release);
+        table->issued.fetch_add(1, std::memory_order_relaxed);
+        return 1;
+    }
+    table->contended.fetch_add(1, std::memory_order_relaxed);
+    text[0] = 0;
+    return 0;
+}
+
+int tokenRedeem(TokenTable* table, uint64_t subject, const char* text) {
+    uint64_t token[2];
+    if (!text || !parseToken(text, token)) {
+        table->rejected.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    TokenSlot* bucket = bucketOf(table, token[0]);
+    for (int i = 0; i < TOKEN_BUCKET_SLOTS; i++) {
+        TokenSlot* slot = &bucket[i];
+        uint64_t state = slot->state.load(std::memory_order_acquire);
+        if (kindOf(state) != SLOT_LIVE) continue;
+        uint64_t first = slot->token[0].load(std::memory_order_relaxed);
+        uint64_t second = slot->token[1].load(std::memory_order_relaxed);
+        uint64_t owner = slot->subject.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->state.load(std::memory_order_relaxed) != state) continue;
+        if (first != token[0] || second != token[1]) continue;
+
+        // Whoever clears the slot first owns the token
+        int64_t expires = expiresOf(state);
+        int cleared = slot->state.compare_exchange_strong(state, nextState(state, 0, SLOT_EMPTY),
+                                                          std::memory_order_acq_rel);
+        int64_t now = nowMillis(table);
+        if (cleared && owner == subject && expires >= now) {
+            table->redeemed.fetch_add(1, std::memory_order_relaxed);
+            return 1;
+        }
+        if (cleared && expires < now) table->expired.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+    table->rejected.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+TokenStats tokenStats(const TokenTable* table) {
+    TokenStats stats;
+    stats.issued = table->issued.load();
+    stats.redeemed = table->redeemed.load();
+    stats.rejected = table->rejected.load();
+    stats.expired = table->expired.load();
+    stats.evicted = table->evicted.load();
+    stats.contended = table->contended.load();
+    return stats;
+}
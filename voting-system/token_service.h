@@ -0,0 +1,52 @@
+#ifndef TOKEN_SERVICE_H
+#define TOKEN_SERVICE_H
+
+// One-time tokens (email verification, CSRF). A token is 128 random bits
+// from secureRandom(), shown as 32 hex digits. It is bound to a subject,
+// the caller's hash of what it was issued for, and is good for one redeem
+// within ttlSeconds.
+//
+// Outstanding tokens live in a fixed-size hash table whose slots are
+// claimed and cleared with compare-and-swap on a per-slot state word: no
+// locks, and every call touches one small bucket. A token picks its bucket
+// by its own random bits. Issuing into a full bucket reuses an expired slot,
+// or else evicts the token closest to expiry.
+
+#include <stdint.h>
+
+#define TOKEN_BYTES 16
+#define TOKEN_CHARS (2 * TOKEN_BYTES)
+
+typedef struct {
+    int capacity;               // outstanding tokens, rounded up to a power of two
+    int ttlSeconds;
+} TokenPolicy;
+
+TokenPolicy defaultTokenPolicy(void);
+
+typedef struct TokenTable TokenTable;
+
+// Returns NULL if memory could not be allocated
+TokenTable* createTokenTable(const TokenPolicy* policy);
+void destroyTokenTable(TokenTable* table);
+
+// Issues a token for subject and writes it (NUL-terminated). Returns 0,
+// with token "", if other threads won every slot it tried to claim; the
+// caller may retry.
+int tokenIssue(TokenTable* table, uint64_t subject, char token[TOKEN_CHARS + 1]);
+// 1 if token is outstanding, unexpired and was issued for subject. It is
+// used up either way, so a token cannot be tried against other subjects.
+int tokenRedeem(TokenTable* table, uint64_t subject, const char* token);
+
+typedef struct {
+    uint64_t issued;
+    uint64_t redeemed;
+    uint64_t rejected;          // unknown, expired or another subject's
+    uint64_t expired;           // slots reclaimed after ttlSeconds
+    uint64_t evicted;           // still live, but their bucket was full
+    uint64_t contended;         // issues that lost every claim and failed
+} TokenStats;
+
+TokenStats tokenStats(const TokenTable* table);
+
+#endif // TOKEN_SERVICE_H
@@ -0,0 +1,349 @@
+#include "user_import.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "mapped_file.h"
+#include "string_index.h"
+
+#define IMPORT_SLICE_BYTES (4 << 20)
+#define IMPORT_MAX_THREADS 16
+
+#define FIELD_MALFORMED -1
+#define FIELD_TOO_LONG -2
+
+// Set entries: the top 24 bits of the username hash over the file offset of
+// the row's line plus one (0 = empty), so files up to 1 TB
+#define SET_OFFSET_BITS 40
+#define SET_OFFSET_MASK ((1ull << SET_OFFSET_BITS) - 1)
+
+typedef struct {
+    uint32_t offset;            // line start, from the slice start
+    uint32_t length;
+    uint32_t line;              // from the slice's first line
+    uint32_t reason;
+    uint64_t hash;
+} Row;
+
+typedef struct {
+    const char* start;
+    const char* end;
+    Row* rows;
+    long count;
+    long capacity;
+    long lines;                 // including blank ones
+} Slice;
+
+typedef struct {
+    const MappedFile* file;
+    const ImportHandler* handler;
+    Slice* slices;
+    int sliceCount;
+    std::atomic<int> next;
+    std::atomic<int> failed;
+    std::atomic<uint64_t>* set;
+    uint64_t mask;
+} ImportJob;
+
+typedef void (*SliceWork)(ImportJob* job, Slice* slice);
+
+static const char* reasonText[IMPORT_REASONS] = {
+    "ok",
+    "not username,password,full name (or a stray quote)",
+    "empty field",
+    "field too long",
+    "whitespace in username or password",
+    "password does not meet complexity requirements",
+    "user already exists",
+    "duplicate of an earlier row",
+};
+
+const char* importReasonText(ImportReason reason) {
+    return reason >= 0 && reason < IMPORT_REASONS ? reasonText[reason] : "?";
+}
+
+// One field from *p (which is left on the comma or at end) into out.
+// Returns its length, FIELD_TOO_LONG (out holds the start) or FIELD_MALFORMED.
+static int csvField(const char** p, const char* end, char* out) {
+    const char* s = *p;
+    int n = 0, tooLong = 0;
+    if (s < end && *s == '"') {
+        for (s++;; s++) {
+            if (s == end) return FIELD_MALFORMED;
+            if (*s == '"') {
+                if (s + 1 == end || s[1] != '"') break;
+                s++;
+            }
+            if (n < IMPORT_FIELD_MAX - 1) out[n++] = *s;
+            else tooLong = 1;
+        }
+        s++;
+        if (s < end && *s != ',') return FIELD_MALFORMED;
+    } else {
+        for (; s < end && *s != ','; s++) {
+            if (*s == '"') return FIELD_MALFORMED;
+            if (n < IMPORT_FIELD_MAX - 1) out[n++] = *s;
+            else tooLong = 1;
+        }
+    }
+    out[n] = 0;
+    *p = s;
+    return tooLong ? FIELD_TOO_LONG : n;
+}
+
+static int firstField(const char* line, size_t length, char* out) {
+    return csvField(&line, line + length, out);
+}
+
+static int plainField(const char* s) {
+    for (; *s; s++) {
+        if (isspace((unsigned char)*s) || iscntrl((unsigned char)*s)) return 0;
+    }
+    return 1;
+}
+
+// Splits and checks one line into row. Shared by validation and by the
+// final pass, which re-parses the accepted lines rather than keeping them.
+static ImportReason parseRow(const char* line, size_t length, const ImportHandler* handler, ImportRow* row,
+                             int check) {
+    char* fields[3] = {row->username, row->password, row->fullName};
+    int lengths[3];
+    const char* p = line;
+    const char* end = line + length;
+    int n = 0, tooLong = 0;
+    while (1) {
+        if (n == 3) return IMPORT_FIELD_COUNT;
+        lengths[n] = csvField(&p, end, fields[n]);
+        if (lengths[n] == FIELD_MALFORMED) return IMPORT_FIELD_COUNT;
+        if (lengths[n] == FIELD_TOO_LONG) tooLong = 1;
+        n++;
+        if (p == end) break;
+        p++;
+    }
+    if (n != 3) return IMPORT_FIELD_COUNT;
+    if (tooLong) return IMPORT_TOO_LONG;
+    row->usernameHash = hashString(row->username, lengths[0]);
+    if (!check) return IMPORT_OK;
+
+    if (!lengths[0] || !lengths[1] || !lengths[2]) return IMPORT_EMPTY_FIELD;
+    if (!plainField(row->username) || !plainField(row->password)) return IMPORT_BAD_CHARACTERS;
+    if (handler->passwordOk && !handler->passwordOk(row->password)) return IMPORT_WEAK_PASSWORD;
+    if (handler->exists && handler->exists(row->username, row->usernameHash, handler->ctx)) return IMPORT_EXISTS;
+    return IMPORT_OK;
+}
+
+static int isHeader(const char* line, size_t length) {
+    char field[IMPORT_FIELD_MAX];
+    if (firstField(line, length, field) != 8) return 0;
+    for (int i = 0; i < 8; i++) field[i] = (char)tolower((unsigned char)field[i]);
+    return memcmp(field, "username", 8) == 0;
+}
+
+static size_t lineLength(const char* line, const char* end) {
+    const char* newline = (const char*)memchr(line, '\n', end - line);
+    size_t length = (newline ? newline : end) - line;
+    if (length > 0 && line[length - 1] == '\r') length--;
+    return length;
+}
+
+static void validateSlice(ImportJob* job, Slice* slice) {
+    ImportRow row;
+    const char* p = slice->start;
+    while (p < slice->end) {
+        size_t length = lineLength(p, slice->end);
+        uint32_t line = (uint32_t)slice->lines++;
+        if (length > 0 && !(p == job->file->data && isHeader(p, length))) {
+            if (slice->count == slice->capacity) {
+                long capacity = slice->capacity ? slice->capacity * 2 : 4096;
+                Row* rows = (Row*)realloc(slice->rows, sizeof(Row) * capacity);
+                if (!rows) {
+                    job->failed = 1;
+                    return;
+                }
+                slice->rows = rows;
+                slice->capacity = capacity;
+            }
+            Row* r = &slice->rows[slice->count++];
+            r->offset = (uint32_t)(p - slice->start);
+            r->length = (uint32_t)length;
+            r->line = line;
+            r->reason = parseRow(p, length, job->handler, &row, 1);
+            r->hash = row.usernameHash;
+        }
+        p += length;
+        if (p < slice->end && *p == '\r') p++;
+        p++;
+    }
+}
+
+static int sameUsername(const MappedFile* file, uint64_t offset, const char* username) {
+    char other[IMPORT_FIELD_MAX];
+    const char* line = file->data + offset;
+    firstField(line, lineLength(line, file->data + file->length), other);
+    return strcmp(other, username) == 0;
+}
+
+// Claims username for the row at offset. A slot only ever moves to an
+// earlier row of the same username, so once every row has been claimed each
+// username's slot holds its first row.
+static void claim(ImportJob* job, uint64_t hash, uint64_t offset, const char* username) {
+    uint64_t tag = hash >> SET_OFFSET_BITS << SET_OFFSET_BITS;
+    uint64_t mine = tag | (offset + 1);
+    for (uint64_t i = hash & job->mask;; i = (i + 1) & job->mask) {
+        uint64_t seen = job->set[i].load(std::memory_order_relaxed);
+        while (1) {
+            if (seen == 0) {
+                if (job->set[i].compare_exchange_weak(seen, mine, std::memory_order_relaxed)) return;
+                continue;
+            }
+            if ((seen & ~SET_OFFSET_MASK) != tag ||
+                !sameUsername(job->file, (seen & SET_OFFSET_MASK) - 1, username)) break;
+            if ((seen & SET_OFFSET_MASK) <= offset + 1) return;
+            if (job->set[i].compare_exchange_weak(seen, mine, std::memory_order_relaxed)) return;
+        }
+    }
+}
+
+// Whether the row at offset is the first with username. Its own slot is
+// recognised by offset, without comparing names.
+static int isFirstRow(const ImportJob* job, uint64_t hash, uint64_t offset, const char* username) {
+    uint64_t tag = hash >> SET_OFFSET_BITS << SET_OFFSET_BITS;
+    for (uint64_t i = hash & job->mask;; i = (i + 1) & job->mask) {
+        uint64_t seen = job->set[i].load(std::memory_order_relaxed);
+        if (seen == (tag | (offset + 1))) return 1;
+        if (seen == 0) return 0;
+        if ((seen & ~SET_OFFSET_MASK) == tag && sameUsername(job->file, (seen & SET_OFFSET_MASK) - 1, username)) return 0;
+    }
+}
+
+static void claimSlice(ImportJob* job, Slice* slice) {
+    char username[IMPORT_FIELD_MAX];
+    uint64_t base = slice->start - job->file->data;
+    for (long i = 0; i < slice->count; i++) {
+        const Row* r = &slice->rows[i];
+        if (r->reason != IMPORT_OK) continue;
+        firstField(slice->start + r->offset, r->length, username);
+        claim(job, r->hash, base + r->offset, username);
+    }
+}
+
+static void markDuplicates(ImportJob* job, Slice* slice) {
+    char username[IMPORT_FIELD_MAX];
+    uint64_t base = slice->start - job->file->data;
+    for (long i = 0; i < slice->count; i++) {
+        Row* r = &slice->rows[i];
+        if (r->reason != IMPORT_OK) continue;
+        firstField(slice->start + r->offset, r->length, username);
+        if (!isFirstRow(job, r->hash, base + r->offset, username)) r->reason = IMPORT_DUPLICATE;
+    }
+}
+
+// Slices go to whichever thread is free next; the calling thread is one of
+// the workers
+static void runPhase(ImportJob* job, SliceWork work, int threads) {
+    job->next = 0;
+    auto loop = [job, work] {
+        for (int i; (i = job->next++) < job->sliceCount && !job->failed;) work(job, &job->slices[i]);
+    };
+    std::thread workers[IMPORT_MAX_THREADS];
+    for (int t = 1; t < threads; t++) workers[t] = std::thread(loop);
+    loop();
+    for (int t = 1; t < threads; t++) workers[t].join();
+}
+
+static Slice* cutSlices(const MappedFile* file, int* count) {
+    Slice* slices = (Slice*)calloc(file->length / IMPORT_SLICE_BYTES + 1, sizeof(Slice));
+    if (!slices) return NULL;
+    int n = 0;
+    for (size_t pos = 0; pos < file->length; n++) {
+        size_t end = pos + IMPORT_SLICE_BYTES;
+        if (end >= file->length) {
+            end = file->length;
+        } else {
+            const char* newline = (const char*)memchr(file->data + end, '\n', file->length - end);
+            end = newline ? newline - file->data + 1 : file->length;
+        }
+        slices[n].start = file->data + pos;
+        slices[n].end = file->data + end;
+        pos = end;
+    }
+    *count = n;
+    return slices;
+}
+
+// Accepted rows are re-parsed here rather than kept from validation, so a
+// row costs 24 bytes until its turn comes
+static int applyRows(ImportJob* job, ImportStats* stats) {
+    const ImportHandler* handler = job->handler;
+    ImportRow row;
+    long firstLine = 1;
+    for (int s = 0; s < job->sliceCount; s++) {
+        const Slice* slice = &job->slices[s];
+        for (long i = 0; i < slice->count; i++) {
+            const Row* r = &slice->rows[i];
+            const char* line = slice->start + r->offset;
+            long lineNumber = firstLine + r->line;
+            if (r->reason == IMPORT_OK) {
+                parseRow(line, r->length, handler, &row, 0);
+                row.line = lineNumber;
+                if (!handler->accept(&row, handler->ctx)) return 0;
+                stats->accepted++;
+            } else {
+                stats->rejected[r->reason]++;
+                if (handler->reject) handler->reject(lineNumber, (ImportReason)r->reason, line, r->length, handler->ctx);
+            }
+        }
+        firstLine += slice->lines;
+    }
+    return 1;
+}
+
+int importUsers(const char* path, const ImportHandler* handler, ImportStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    MappedFile file;
+    if (!mapFile(path, &file)) return 0;
+
+    int threads = handler->threads > 0 ? handler->threads : (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    if (threads > IMPORT_MAX_THREADS) threads = IMPORT_MAX_THREADS;
+
+    ImportJob job;
+    job.file = &file;
+    job.handler = handler;
+    job.failed = 0;
+    job.set = NULL;
+    job.slices = cutSlices(&file, &job.sliceCount);
+    int ok = job.slices != NULL;
+
+    if (ok) {
+        runPhase(&job, validateSlice, threads);
+        ok = !job.failed;
+    }
+    if (ok) {
+        long valid = 0;
+        for (int s = 0; s < job.sliceCount; s++) {
+            stats->rows += job.slices[s].count;
+            for (long i = 0; i < job.slices[s].count; i++) valid += job.slices[s].rows[i].reason == IMPORT_OK;
+        }
+        uint64_t capacity = 16;
+        while (capacity < (uint64_t)valid * 2) capacity *= 2;
+        job.mask = capacity - 1;
+        job.set = new (std::nothrow) std::atomic<uint64_t>[capacity]();
+        ok = job.set != NULL;
+    }
+    if (ok) {
+        runPhase(&job, claimSlice, threads);
+        runPhase(&job, markDuplicates, threads);
+        ok = applyRows(&job, stats);
+    }
+
+    delete[] job.set;
+    for (int s = 0; job.slices && s < job.sliceCount; s++) free(job.slices[s].rows);
+    free(job.slices);
+    unmapFile(&file);
+    return ok;
+}
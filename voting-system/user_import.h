@@ -0,0 +1,66 @@
+#ifndef USER_IMPORT_H
+#define USER_IMPORT_H
+
+// Bulk voter-roll import from a CSV file of
+//
+//   username,password,full name
+//
+// rows, with an optional header row. Fields may be double-quoted (a quoted
+// field can hold commas, and "" is a literal quote) but not span lines.
+// The file is memory-mapped and cut into slices at line boundaries; worker
+// threads parse and validate the slices, then claim every valid username in
+// a shared lock-free hash set in which the earliest row of a username wins.
+// Finally the calling thread hands each row, in file order, to accept() or
+// reject(), so accepted rows can go straight into the (single-threaded)
+// stores.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMPORT_FIELD_MAX 100    // bytes per field, including the NUL
+
+typedef enum {
+    IMPORT_OK,
+    IMPORT_FIELD_COUNT,         // not exactly three fields, or a stray quote
+    IMPORT_EMPTY_FIELD,
+    IMPORT_TOO_LONG,
+    IMPORT_BAD_CHARACTERS,      // whitespace or control bytes in username/password
+    IMPORT_WEAK_PASSWORD,
+    IMPORT_EXISTS,              // already registered
+    IMPORT_DUPLICATE,           // an earlier row has the same username
+    IMPORT_REASONS
+} ImportReason;
+
+typedef struct {
+    long line;                  // 1-based line in the file
+    uint64_t usernameHash;      // hashString() of username
+    char username[IMPORT_FIELD_MAX];
+    char password[IMPORT_FIELD_MAX];
+    char fullName[IMPORT_FIELD_MAX];
+} ImportRow;
+
+typedef struct {
+    int (*passwordOk)(const char* password);
+    // Called from the worker threads, concurrently; must only read
+    int (*exists)(const char* username, uint64_t hash, void* ctx);
+    // Called on the calling thread in file order. accept() returns 0 to stop
+    // the import (e.g. out of memory); text is the raw line, not terminated.
+    int (*accept)(ImportRow* row, void* ctx);
+    void (*reject)(long line, ImportReason reason, const char* text, size_t length, void* ctx);
+    void* ctx;
+    int threads;                // 0 for one per core
+} ImportHandler;
+
+typedef struct {
+    long rows;                  // not counting a header row or blank lines
+    long accepted;
+    long rejected[IMPORT_REASONS];
+} ImportStats;
+
+const char* importReasonText(ImportReason reason);
+
+// Returns 0 if the file could not be opened, memory ran out before any row
+// was accepted, or accept() stopped the import; stats cover what was done.
+int importUsers(const char* path, const ImportHandler* handler, ImportStats* stats);
+
+#endif // USER_IMPORT_H
@@ -0,0 +1,216 @@
+#include "vote_cipher.h"
+
+#include <string.h>
+#include <random>
+
+static_assert(sizeof(VoteBallot) == 24, "ballots are 24 bytes");
+
+// "expand 32-byte k"
+static const uint32_t sigma[4] = {0x61707865u, 0x3320646eu, 0x79622d32u, 0x6b206574u};
+
+static inline uint32_t load32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void store32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Word is uint32_t for one block or a vector of them for one block per lane
+#define ROTL(v, n) ((v) << (n) | (v) >> (32 - (n)))
+#define QUARTER(a, b, c, d)                                     \
+    a += b; d ^= a; d = ROTL(d, 16);                            \
+    c += d; b ^= c; b = ROTL(b, 12);                            \
+    a += b; d ^= a; d = ROTL(d, 8);                             \
+    c += d; b ^= c; b = ROTL(b, 7)
+
+template <typename Word>
+static inline void chachaRounds(Word* x) {
+    for (int i = 0; i < 10; i++) {
+        QUARTER(x[0], x[4], x[8], x[12]);
+        QUARTER(x[1], x[5], x[9], x[13]);
+        QUARTER(x[2], x[6], x[10], x[14]);
+        QUARTER(x[3], x[7], x[11], x[15]);
+        QUARTER(x[0], x[5], x[10], x[15]);
+        QUARTER(x[1], x[6], x[11], x[12]);
+        QUARTER(x[2], x[7], x[8], x[13]);
+        QUARTER(x[3], x[4], x[9], x[14]);
+    }
+}
+
+void chacha20Block(const uint32_t key[8], uint32_t counter, const uint8_t nonce[VOTE_NONCE_BYTES], uint8_t out[64]) {
+    uint32_t input[16], x[16];
+    memcpy(input, sigma, sizeof(sigma));
+    memcpy(input + 4, key, 8 * sizeof(uint32_t));
+    input[12] = counter;
+    for (int i = 0; i < 3; i++) input[13 + i] = load32(nonce + 4 * i);
+    memcpy(x, input, sizeof(x));
+    chachaRounds(x);
+    for (int i = 0; i < 16; i++) store32(out + 4 * i, x[i] + input[i]);
+}
+
+#if defined(__GNUC__)
+#define CIPHER_LANES 4
+typedef uint32_t Lanes __attribute__((vector_size(4 * CIPHER_LANES)));
+#else
+#define CIPHER_LANES 1
+typedef uint32_t Lanes;
+#endif
+
+static inline Lanes broadcast(uint32_t v) {
+    Lanes zero = {};
+    return zero + v;
+}
+
+// The first `words` (at most 4) output words of the block for each input,
+// where an input is the counter and nonce words (state words 12 to 15).
+// Only those words of the final addition are computed.
+static void blockWords(const uint32_t key[8], const uint32_t (*inputs)[4], int count, int words, uint32_t* out) {
+    Lanes x[16];
+    for (int i = 0; i < 4; i++) x[i] = broadcast(sigma[i]);
+    for (int i = 0; i < 8; i++) x[4 + i] = broadcast(key[i]);
+    for (int lane = 0; lane < CIPHER_LANES; lane++) {
+        // Short batches repeat the last input in the unused lanes
+        const uint32_t* input = inputs[lane < count ? lane : count - 1];
+        for (int i = 0; i < 4; i++) {
+#if CIPHER_LANES > 1
+            x[12 + i][lane] = input[i];
+#else
+            x[12 + i] = input[i];
+#endif
+        }
+    }
+    chachaRounds(x);
+    for (int w = 0; w < words; w++) x[w] += sigma[w];
+    for (int lane = 0; lane < CIPHER_LANES && lane < count; lane++) {
+        for (int w = 0; w < words; w++) {
+#if CIPHER_LANES > 1
+            out[words * lane + w] = x[w][lane];
+#else
+            out[words * lane + w] = x[w];
+#endif
+        }
+    }
+}
+
+// Keystream word 0 of block 0 for each ballot's nonce
+static void keystreamWords(const uint32_t key[8], const VoteBallot* ballots, int count, uint32_t* out) {
+    uint32_t inputs[CIPHER_LANES][4];
+    for (int k = 0; k < count; k++) {
+        inputs[k][0] = 0;
+        for (int i = 0; i < 3; i++) inputs[k][1 + i] = load32(ballots[k].nonce + 4 * i);
+    }
+    blockWords(key, inputs, count, 1, out);
+}
+
+// Two words of tag per ballot: a two-block CBC-MAC over the MAC key's
+// block function. Block one is sealed || nonce; block two XORs the voter
+// into its output, and the tag is the first two words of the result.
+static void tagWords(const uint32_t macKey[8], const VoteBallot* ballots, const uint64_t* voters, int count,
+                     uint32_t* out) {
+    uint32_t inputs[CIPHER_LANES][4], chained[4 * CIPHER_LANES];
+    for (int k = 0; k < count; k++) {
+        inputs[k][0] = load32(ballots[k].sealed);
+        for (int i = 0; i < 3; i++) inputs[k][1 + i] = load32(ballots[k].nonce + 4 * i);
+    }
+    blockWords(macKey, inputs, count, 4, chained);
+    for (int k = 0; k < count; k++) {
+        inputs[k][0] = chained[4 * k];
+        inputs[k][1] = chained[4 * k + 1];
+        inputs[k][2] = chained[4 * k + 2] ^ (uint32_t)voters[k];
+        inputs[k][3] = chained[4 * k + 3] ^ (uint32_t)(voters[k] >> 32);
+    }
+    blockWords(macKey, inputs, count, 2, out);
+}
+
+void chacha20Blocks(const uint32_t key[8], uint32_t counter, const uint8_t nonce[VOTE_NONCE_BYTES], uint8_t* out,
+                    int blocks) {
+    uint32_t input[16];
+    memcpy(input, sigma, sizeof(sigma));
+    memcpy(input + 4, key, 8 * sizeof(uint32_t));
+    for (int i = 0; i < 3; i++) input[13 + i] = load32(nonce + 4 * i);
+    for (int b = 0; b < blocks; b += CIPHER_LANES) {
+        Lanes x[16];
+        for (int i = 0; i < 16; i++) x[i] = broadcast(input[i]);
+        for (int lane = 0; lane < CIPHER_LANES; lane++) {
+#if CIPHER_LANES > 1
+            x[12][lane] = counter + b + lane;
+#else
+            x[12] = counter + b + lane;
+#endif
+        }
+        Lanes counters = x[12];
+        chachaRounds(x);
+        for (int i = 0; i < 16; i++) x[i] += i == 12 ? counters : broadcast(input[i]);
+        for (int lane = 0; lane < CIPHER_LANES && b + lane < blocks; lane++) {
+            uint8_t* block = out + 64 * (b + lane);
+            for (int i = 0; i < 16; i++) {
+#if CIPHER_LANES > 1
+                store32(block + 4 * i, x[i][lane]);
+#else
+                store32(block + 4 * i, x[i]);
+#endif
+            }
+        }
+    }
+}
+
+void initVoteCipher(VoteCipher* cipher, const uint8_t key[VOTE_KEY_BYTES]) {
+    for (int i = 0; i < 8; i++) cipher->key[i] = load32(key + 4 * i);
+    // Ballots only ever use block 0, so block 1 under a zero nonce is free
+    // to derive the MAC key from
+    static const uint8_t zero[VOTE_NONCE_BYTES] = {0};
+    uint8_t block[64];
+    chacha20Block(cipher->key, 1, zero, block);
+    for (int i = 0; i < 8; i++) cipher->macKey[i] = load32(block + 4 * i);
+    memset(block, 0, sizeof(block));
+    std::random_device random;
+    cipher->noncePrefix = random();
+    cipher->nonceSequence = (uint64_t)random() << 32 | random();
+}
+
+void sealVotes(VoteCipher* cipher, const int* ids, const uint64_t* voters, int count, VoteBallot* out) {
+    for (int i = 0; i < count; i++) {
+        uint64_t sequence = cipher->nonceSequence++;
+        store32(out[i].nonce, cipher->noncePrefix);
+        store32(out[i].nonce + 4, (uint32_t)sequence);
+        store32(out[i].nonce + 8, (uint32_t)(sequence >> 32));
+    }
+    uint32_t words[CIPHER_LANES], tags[2 * CIPHER_LANES];
+    for (int i = 0; i < count; i += CIPHER_LANES) {
+        int n = count - i < CIPHER_LANES ? count - i : CIPHER_LANES;
+        keystreamWords(cipher->key, out + i, n, words);
+        for (int k = 0; k < n; k++) store32(out[i + k].sealed, (uint32_t)ids[i + k] ^ words[k]);
+        tagWords(cipher->macKey, out + i, voters + i, n, tags);
+        for (int k = 0; k < n; k++) {
+            store32(out[i + k].tag, tags[2 * k]);
+            store32(out[i + k].tag + 4, tags[2 * k + 1]);
+        }
+    }
+}
+
+void openVotes(const VoteCipher* cipher, const VoteBallot* ballots, const uint64_t* voters, int count, int* ids) {
+    uint32_t words[CIPHER_LANES], tags[2 * CIPHER_LANES];
+    for (int i = 0; i < count; i += CIPHER_LANES) {
+        int n = count - i < CIPHER_LANES ? count - i : CIPHER_LANES;
+        keystreamWords(cipher->key, ballots + i, n, words);
+        tagWords(cipher->macKey, ballots + i, voters + i, n, tags);
+        for (int k = 0; k < n; k++) {
+            const VoteBallot* ballot = &ballots[i + k];
+            uint32_t diff = (load32(ballot->tag) ^ tags[2 * k]) | (load32(ballot->tag + 4) ^ tags[2 * k + 1]);
+            ids[i + k] = diff ? VOTE_TAMPERED : (int)(load32(ballot->sealed) ^ words[k]);
+        }
+    }
+}
+
+int openUntaggedBallot(const VoteCipher* cipher, const uint8_t* ballot) {
+    VoteBallot padded;
+    memset(&padded, 0, sizeof(padded));
+    memcpy(&padded, ballot, VOTE_UNTAGGED_BYTES);
+    uint32_t word;
+    keystreamWords(cipher->key, &padded, 1, &word);
+    return (int)(load32(padded.sealed) ^ word);
+}
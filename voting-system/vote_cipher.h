@@ -0,0 +1,60 @@
+#ifndef VOTE_CIPHER_H
+#define VOTE_CIPHER_H
+
+// Vote encryption with ChaCha20 (RFC 8439). A ballot is a 96-bit nonce, the
+// candidate id XORed with the first four keystream bytes of block 0 for that
+// nonce, and a 64-bit tag. Every ballot gets a fresh nonce, so two votes for
+// the same candidate look unrelated on disk.
+//
+// The XOR alone would let anyone flip a vote between candidates without the
+// key, and a ballot copied from another voter's row would still open, so the
+// tag authenticates sealed || nonce and the voter (a 64-bit hash of their
+// username). It is a two-block CBC-MAC whose block function is ChaCha20
+// under a MAC key derived from the ballot key: the block function is a PRF
+// on its 128-bit counter || nonce input, and every message has the same
+// length. A ballot whose tag does not match opens to VOTE_TAMPERED.
+//
+// Ballots are sealed and opened in batches; the ChaCha rounds for several
+// ballots run side by side in SIMD lanes where the compiler supports vector
+// types, and one at a time otherwise.
+
+#include <stdint.h>
+
+#define VOTE_KEY_BYTES 32
+#define VOTE_NONCE_BYTES 12
+#define VOTE_TAG_BYTES 8
+#define VOTE_TAMPERED -1
+// Ballots stored before tags were added: nonce and sealed id only
+#define VOTE_UNTAGGED_BYTES 16
+
+typedef struct {
+    uint8_t nonce[VOTE_NONCE_BYTES];
+    uint8_t sealed[4];          // little-endian candidate id ^ keystream
+    uint8_t tag[VOTE_TAG_BYTES];
+} VoteBallot;
+
+typedef struct {
+    uint32_t key[8];
+    uint32_t macKey[8];         // keystream block 1 of key under a zero nonce
+    uint32_t noncePrefix;       // random per process
+    uint64_t nonceSequence;     // random start, +1 per ballot
+} VoteCipher;
+
+void initVoteCipher(VoteCipher* cipher, const uint8_t key[VOTE_KEY_BYTES]);
+
+// Sealing takes nonces from the cipher and is not thread-safe; opening is
+// safe from any thread. voters[i] is the voter ballot i is bound to.
+void sealVotes(VoteCipher* cipher, const int* ids, const uint64_t* voters, int count, VoteBallot* out);
+void openVotes(const VoteCipher* cipher, const VoteBallot* ballots, const uint64_t* voters, int count, int* ids);
+// Opens an untagged ballot (VOTE_UNTAGGED_BYTES: nonce then sealed id), for
+// migrating ballots written before tags. Nothing authenticates it.
+int openUntaggedBallot(const VoteCipher* cipher, const uint8_t* ballot);
+
+// One full 64-byte keystream block, for checking against the RFC vectors
+void chacha20Block(const uint32_t key[8], uint32_t counter, const uint8_t nonce[VOTE_NONCE_BYTES], uint8_t out[64]);
+// Keystream blocks counter..counter+blocks-1, several at a time in SIMD
+// lanes, into out (64 * blocks bytes)
+void chacha20Blocks(const uint32_t key[8], uint32_t counter, const uint8_t nonce[VOTE_NONCE_BYTES], uint8_t* out,
+                    int blocks);
+
+#endif // VOTE_CIPHER_H
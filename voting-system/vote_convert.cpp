@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "line_loader.h"
+#include "record_store.h"
+#include "vote_file.h"
+
+// Converts a text votes.txt (userId and XOR payload per line, tab or space
+// separated) to the columnar votes.bin, then reads it back: a payload-only
+// tally scan and a full check of every column.
+// Usage: vote_convert [votes.txt] [votes.bin]
+
+using Clock = std::chrono::steady_clock;
+
+typedef struct {
+    StrRef voter;
+    StrRef payload;
+} TextVote;
+
+static StringArena strings;
+static RecordStore rows;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void addRow(const ParsedLine* line, void* ctx) {
+    (void)ctx;
+    if (line->count < 2) return;
+    char voter[100], payload[100];
+    fieldSpan(line, 0, 0, voter, sizeof(voter));
+    fieldSpan(line, 1, line->count - 1, payload, sizeof(payload));
+    TextVote* row = (TextVote*)storePush(&rows);
+    if (!row) return;
+    row->voter = arenaAdd(&strings, voter);
+    row->payload = arenaIntern(&strings, payload);
+}
+
+static void rowAt(long i, VoteRow* row, void* ctx) {
+    (void)ctx;
+    const TextVote* v = (const TextVote*)storeAt(&rows, (int)i);
+    row->voterId = arenaGet(&strings, v->voter);
+    row->payload = arenaGet(&strings, v->payload);
+    row->payloadLength = (int)strlen((const char*)row->payload);
+    row->timestamp = 0;         // the text format never stored voteDate
+}
+
+static long fileSize(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+int main(int argc, char** argv) {
+    const char* input = argc > 1 ? argv[1] : "votes.txt";
+    const char* output = argc > 2 ? argv[2] : "votes.bin";
+    initRecordStore(&rows, sizeof(TextVote));
+    if (!initStringArena(&strings)) return 1;
+
+    Clock::time_point start = Clock::now();
+    if (loadLines(input, addRow, NULL) < 0) {
+        printf("cannot read %s\n", input);
+        return 1;
+    }
+    double parse = secondsSince(start);
+
+    start = Clock::now();
+    if (!writeVoteFile(output, rows.count, rowAt, NULL)) {
+        printf("cannot write %s\n", output);
+        return 1;
+    }
+    printf("%d votes: parsed %.2f s, written %.2f s\n", rows.count, parse, secondsSince(start));
+    printf("size: %.1f MB text -> %.1f MB binary\n", fileSize(input) / 1048576.0, fileSize(output) / 1048576.0);
+
+    VoteFile file;
+    if (!openVoteFile(output, &file)) {
+        printf("cannot reopen %s\n", output);
+        return 1;
+    }
+
+    // Tally: only the payload column is read (and checksummed)
+    start = Clock::now();
+    long tally[256] = {0};
+    long bytes = 0;
+    for (uint32_t b = 0; b < file.blockCount; b++) {
+        int count, width;
+        const uint8_t* payloads = (const uint8_t*)voteFileColumn(&file, b, VOTE_COLUMN_PAYLOAD, &count, &width);
+        if (!payloads) continue;
+        for (int i = 0; i < count; i++) tally[payloads[(size_t)i * width]]++;
+        bytes += (long)count * width;
+    }
+    int distinct = 0;
+    for (int i = 0; i < 256; i++) distinct += tally[i] > 0;
+    printf("payload scan: %.3f s, %.1f MB read, %d distinct leading bytes\n", secondsSince(start),
+           bytes / 1048576.0, distinct);
+
+    // Verify: every column, every row against the source
+    start = Clock::now();
+    long mismatches = 0, damaged = 0;
+    for (uint32_t b = 0; b < file.blockCount; b++) {
+        int count, width;
+        const uint32_t* voters = (const uint32_t*)voteFileColumn(&file, b, VOTE_COLUMN_VOTER, &count, NULL);
+        const uint8_t* payloads = (const uint8_t*)voteFileColumn(&file, b, VOTE_COLUMN_PAYLOAD, &count, &width);
+        const int64_t* times = (const int64_t*)voteFileColumn(&file, b, VOTE_COLUMN_TIMESTAMP, &count, NULL);
+        if (!voters || !payloads || !times) {
+            damaged++;
+            continue;
+        }
+        for (int i = 0; i < count; i++) {
+            VoteRow row;
+            rowAt((long)b * VOTE_BLOCK_RECORDS + i, &row, NULL);
+            if (strcmp(voteFileVoter(&file, voters[i]), row.voterId) != 0 ||
+                memcmp(payloads + (size_t)i * width, row.payload, row.payloadLength) != 0)
+                mismatches++;
+        }
+    }
+    printf("verify: %.2f s, %llu votes, %u voters, %ld damaged blocks, %ld mismatches\n", secondsSince(start),
+           (unsigned long long)file.voteCount, file.voterCount, damaged, mismatches);
+
+    closeVoteFile(&file);
+    freeRecordStore(&rows);
+    freeStringArena(&strings);
+    return mismatches || damaged ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+#include "vote_counters.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "leaderboard.h"
+
+#define COUNTERS_PER_LINE 8     // int64_t per 64-byte line
+#define COUNTERS_MAX_SLABS 1024
+
+typedef struct alignas(64) {
+    int64_t counts[COUNTERS_PER_LINE];
+} CounterLine;
+
+// The table holds one reference to the current snapshot, each reader another
+typedef struct {
+    VoteCountSnapshot pub;
+    int refs;
+} Snapshot;
+
+struct VoteCounters {
+    int slabs;                  // power of two
+    int capacity;               // items
+    int stride;                 // lines per slab
+    CounterLine* lines;         // slab s starts at lines[s * stride]
+    std::mutex publishMutex;    // one publish at a time; guards epochs, ranking
+    uint64_t epochs;
+    Leaderboard ranking;        // counts as of the last publish
+    std::mutex currentMutex;    // guards current and every refs
+    Snapshot* current;
+};
+
+static std::atomic<uint32_t> nextThreadSlab{0};
+static thread_local uint32_t threadSlab = nextThreadSlab.fetch_add(1, std::memory_order_relaxed);
+
+static inline int64_t* slabOf(const VoteCounters* counters, int slab) {
+    return counters->lines[(size_t)slab * counters->stride].counts;
+}
+
+static int linesFor(int capacity) {
+    return (capacity + COUNTERS_PER_LINE - 1) / COUNTERS_PER_LINE;
+}
+
+VoteCounters* createVoteCounters(int capacity, int slabs) {
+    if (slabs <= 0) slabs = 2 * (int)std::thread::hardware_concurrency();
+    if (slabs > COUNTERS_MAX_SLABS) slabs = COUNTERS_MAX_SLABS;
+    int rounded = 1;
+    while (rounded < slabs) rounded *= 2;
+    VoteCounters* counters = new (std::nothrow) VoteCounters();
+    if (!counters) return NULL;
+    counters->slabs = rounded;
+    initLeaderboard(&counters->ranking);
+    if (!countersReserve(counters, capacity > 0 ? capacity : 1)) {
+        delete counters;
+        return NULL;
+    }
+    return counters;
+}
+
+static void dropSnapshot(Snapshot* snapshot) {
+    if (snapshot && --snapshot->refs == 0) free(snapshot);
+}
+
+void destroyVoteCounters(VoteCounters* counters) {
+    if (!counters) return;
+    dropSnapshot(counters->current);
+    freeLeaderboard(&counters->ranking);
+    delete[] counters->lines;
+    delete counters;
+}
+
+int countersReserve(VoteCounters* counters, int capacity) {
+    if (capacity <= counters->capacity) return 1;
+    int stride = linesFor(capacity);
+    CounterLine* lines = new (std::nothrow) CounterLine[(size_t)counters->slabs * stride]();
+    if (!lines) return 0;
+    for (int s = 0; s < counters->slabs && counters->lines; s++) {
+        memcpy(lines[(size_t)s * stride].counts, slabOf(counters, s), sizeof(int64_t) * counters->capacity);
+    }
+    delete[] counters->lines;
+    counters->lines = lines;
+    counters->stride = stride;
+    counters->capacity = stride * COUNTERS_PER_LINE;
+    return 1;
+}
+
+void countersAdd(VoteCounters* counters, int item, int64_t n) {
+    if (item < 0 || item >= counters->capacity) return;
+    int64_t* slab = slabOf(counters, (int)(threadSlab & (counters->slabs - 1)));
+    std::atomic_ref<int64_t>(slab[item]).fetch_add(n, std::memory_order_relaxed);
+}
+
+int64_t countersRead(const VoteCounters* counters, int item) {
+    if (item < 0 || item >= counters->capacity) return 0;
+    int64_t sum = 0;
+    for (int s = 0; s < counters->slabs; s++) {
+        sum += std::atomic_ref<int64_t>(slabOf(counters, s)[item]).load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+int countersPublish(VoteCounters* counters, int count, uint64_t stamp) {
+    std::lock_guard<std::mutex> publishing(counters->publishMutex);
+    if (count > counters->capacity) count = counters->capacity;
+    if (count < 0) count = 0;
+    {
+        std::lock_guard<std::mutex> lock(counters->currentMutex);
+        const Snapshot* current = counters->current;
+        if (current && current->pub.count == count && current->pub.stamp == stamp) return 1;
+    }
+
+    Snapshot* snapshot = (Snapshot*)malloc(sizeof(Snapshot) + (sizeof(int64_t) + sizeof(int)) * (count + 1));
+    if (!snapshot) return 0;
+    int64_t* votes = (int64_t*)(snapshot + 1);
+    int* order = (int*)(votes + count + 1);
+    // Slab by slab, so the merge reads each slab's lines in order
+    memset(votes, 0, sizeof(int64_t) * count);
+    for (int s = 0; s < counters->slabs; s++) {
+        int64_t* slab = slabOf(counters, s);
+        for (int i = 0; i < count; i++) votes[i] += std::atomic_ref<int64_t>(slab[i]).load(std::memory_order_relaxed);
+    }
+    int64_t total = 0;
+    Leaderboard* ranking = &counters->ranking;
+    for (int i = 0; i < count; i++) {
+        total += votes[i];
+        if (i < ranking->count) {
+            if (votes[i] != leaderboardVotes(ranking, i)) leaderboardSet(ranking, i, votes[i]);
+        } else if (!leaderboardAdd(ranking, votes[i])) {
+            free(snapshot);
+            return 0;
+        }
+    }
+    // Items past count (a smaller publish than the last) are left out
+    int ranked = 0;
+    for (int rank = 0; rank < ranking->count && ranked < count; rank++) {
+        int item = leaderboardAt(ranking, rank);
+        if (item < count) order[ranked++] = item;
+    }
+
+    snapshot->pub.epoch = ++counters->epochs;
+    snapshot->pub.stamp = stamp;
+    snapshot->pub.publishedMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    snapshot->pub.count = count;
+    snapshot->pub.total = total;
+    snapshot->pub.votes = votes;
+    snapshot->pub.order = order;
+    snapshot->refs = 1;
+    std::lock_guard<std::mutex> lock(counters->currentMutex);
+    dropSnapshot(counters->current);
+    counters->current = snapshot;
+    return 1;
+}
+
+const VoteCountSnapshot* countersAcquire(VoteCounters* counters) {
+    std::lock_guard<std::mutex> lock(counters->currentMutex);
+    Snapshot* snapshot = counters->current;
+    if (!snapshot) return NULL;
+    snapshot->refs++;
+    return &snapshot->pub;
+}
+
+void countersRelease(VoteCounters* counters, const VoteCountSnapshot* snapshot) {
+    if (!snapshot) return;
+    std::lock_guard<std::mutex> lock(counters->currentMutex);
+    dropSnapshot((Snapshot*)snapshot);
+}
@@ -0,0 +1,56 @@
+#ifndef VOTE_COUNTERS_H
+#define VOTE_COUNTERS_H
+
+// Live vote counts for items numbered densely from 0 (candidate slots).
+// Every thread adds into its own slab of counters, one per item, and slabs
+// start on separate cache lines, so concurrent votes do not bounce a shared
+// line between cores and the cost of a vote does not depend on how many
+// threads are voting. Threads are given slabs round-robin; past `slabs`
+// threads two may share one, which stays correct because adds are atomic.
+//
+// Reads merge the slabs. Results are served from snapshots: countersPublish()
+// merges once, applies the counts that changed to a Leaderboard kept across
+// publishes (O(log n) per vote, so there is no full sort), and makes the
+// result the current snapshot (the next epoch). A publish with nothing new
+// returns before merging. Readers take a reference to it. Old snapshots are freed
+// when their last reader lets go, so a publish never waits for readers and
+// a reader never sees counts change under it. A snapshot is an exact cut of
+// the votes if nothing adds while it is published.
+
+#include <stdint.h>
+
+typedef struct VoteCounters VoteCounters;
+
+typedef struct {
+    uint64_t epoch;             // 1 for the first snapshot, then one more each publish
+    uint64_t stamp;             // the caller's mark, e.g. votes stored at the cut
+    int64_t publishedMillis;    // steady clock
+    int count;                  // items
+    int64_t total;
+    const int64_t* votes;       // by item
+    const int* order;           // items by votes, most first; ties in no fixed order
+} VoteCountSnapshot;
+
+// slabs 0 for two per core. Returns NULL if memory could not be allocated.
+VoteCounters* createVoteCounters(int capacity, int slabs);
+// Every acquired snapshot must have been released
+void destroyVoteCounters(VoteCounters* counters);
+
+// Room for items 0..capacity-1, keeping the counts. Must not run
+// concurrently with countersAdd(). Returns 0 if memory ran out.
+int countersReserve(VoteCounters* counters, int capacity);
+
+// Thread-safe and lock-free
+void countersAdd(VoteCounters* counters, int item, int64_t n);
+// Sum over the slabs; only exact if nothing adds meanwhile
+int64_t countersRead(const VoteCounters* counters, int item);
+
+// Makes a snapshot of items 0..count-1 current, unless the current one
+// already has this count and stamp. One publish runs at a time. Returns 0 if
+// memory ran out (the old snapshot stays current).
+int countersPublish(VoteCounters* counters, int count, uint64_t stamp);
+// The current snapshot (NULL before the first publish), held until released
+const VoteCountSnapshot* countersAcquire(VoteCounters* counters);
+void countersRelease(VoteCounters* counters, const VoteCountSnapshot* snapshot);
+
+#endif // VOTE_COUNTERS_H
@@ -0,0 +1,255 @@
+#include "vote_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checksum.h"
+#include "durable_file.h"
+#include "string_index.h"
+
+#define VOTE_FILE_MAGIC "OVSVOTES"
+#define VOTE_BLOCK_MAGIC 0x4B4C4256u    // "VBLK"
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockCount;
+    uint64_t voteCount;
+    uint32_t voterCount;
+    uint32_t reserved;
+    uint64_t indexOffset;
+    uint64_t dictOffset;
+    uint64_t dictLength;
+    uint32_t dictCrc;
+    uint32_t headerCrc;         // of everything above
+} FileHeader;
+
+typedef struct {
+    uint32_t offset;            // from the start of the block
+    uint32_t length;
+    uint32_t crc;
+    uint32_t reserved;
+} ColumnRef;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t payloadWidth;
+    uint32_t headerCrc;         // of the header with this field zeroed
+    ColumnRef columns[VOTE_COLUMNS];
+} BlockHeader;
+
+static_assert(sizeof(FileHeader) == 64 && sizeof(BlockHeader) == 64, "vote file headers are 64 bytes");
+
+// Voter dictionary built while writing: interned id -> dense number
+typedef struct {
+    const char** names;
+    uint32_t count;
+    uint32_t capacity;
+    StringIndex index;
+} VoterDictionary;
+
+static const char* dictionaryName(int slot, void* ctx) {
+    return ((VoterDictionary*)ctx)->names[slot];
+}
+
+static int64_t internVoter(VoterDictionary* dict, const char* voterId) {
+    uint64_t hash = hashString(voterId, strlen(voterId));
+    int slot = stringIndexFindHashed(&dict->index, voterId, hash);
+    if (slot >= 0) return slot;
+    if (dict->count == dict->capacity) {
+        uint32_t capacity = dict->capacity ? dict->capacity * 2 : 1024;
+        const char** names = (const char**)realloc(dict->names, sizeof(char*) * capacity);
+        if (!names) return -1;
+        dict->names = names;
+        dict->capacity = capacity;
+    }
+    dict->names[dict->count] = voterId;
+    if (!stringIndexInsertHashed(&dict->index, hash, (int)dict->count)) return -1;
+    return dict->count++;
+}
+
+static int writeBlock(FILE* file, long first, int count, VoteRowAt rowAt, void* ctx,
+                      VoterDictionary* dict, char* buffer) {
+    VoteRow row;
+    int width = 1;
+    for (int i = 0; i < count; i++) {
+        rowAt(first + i, &row, ctx);
+        if (row.payloadLength > width) width = row.payloadLength;
+    }
+    if (width > VOTE_PAYLOAD_MAX) return 0;
+
+    BlockHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = VOTE_BLOCK_MAGIC;
+    header.count = count;
+    header.payloadWidth = width;
+
+    int64_t* timestamps = (int64_t*)(buffer + sizeof(BlockHeader));
+    uint32_t* voters = (uint32_t*)(timestamps + count);
+    uint8_t* payloads = (uint8_t*)(voters + count);
+    memset(payloads, 0, (size_t)count * width + 8);     // padding included
+    for (int i = 0; i < count; i++) {
+        rowAt(first + i, &row, ctx);
+        int64_t voter = internVoter(dict, row.voterId);
+        if (voter < 0) return 0;
+        timestamps[i] = row.timestamp;
+        voters[i] = (uint32_t)voter;
+        memcpy(payloads + (size_t)i * width, row.payload, row.payloadLength);
+    }
+
+    void* columns[VOTE_COLUMNS] = {timestamps, voters, payloads};
+    uint32_t lengths[VOTE_COLUMNS] = {(uint32_t)(sizeof(int64_t) * count), (uint32_t)(sizeof(uint32_t) * count),
+                                      (uint32_t)(count * width)};
+    for (int c = 0; c < VOTE_COLUMNS; c++) {
+        header.columns[c].offset = (uint32_t)((char*)columns[c] - buffer);
+        header.columns[c].length = lengths[c];
+        header.columns[c].crc = crc32(0, columns[c], lengths[c]);
+    }
+    header.headerCrc = crc32(0, &header, sizeof(header));
+    memcpy(buffer, &header, sizeof(header));
+
+    // Keep every block 8-byte aligned for the timestamp column
+    size_t length = (header.columns[VOTE_COLUMN_PAYLOAD].offset + lengths[VOTE_COLUMN_PAYLOAD] + 7) & ~(size_t)7;
+    return fwrite(buffer, 1, length, file) == length;
+}
+
+static int writeDictionary(FILE* file, const VoterDictionary* dict, FileHeader* header) {
+    size_t length = sizeof(uint32_t) * (dict->count + 1);
+    uint32_t* offsets = (uint32_t*)malloc(length);
+    if (!offsets) return 0;
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < dict->count; i++) {
+        offsets[i] = offset;
+        offset += (uint32_t)strlen(dict->names[i]) + 1;
+    }
+    offsets[dict->count] = offset;
+    int ok = fwrite(offsets, 1, length, file) == length;
+    uint32_t crc = crc32(0, offsets, length);
+    free(offsets);
+
+    for (uint32_t i = 0; ok && i < dict->count; i++) {
+        size_t n = strlen(dict->names[i]) + 1;
+        ok = fwrite(dict->names[i], 1, n, file) == n;
+        crc = crc32(crc, dict->names[i], n);
+    }
+    header->dictLength = length + offset;
+    header->dictCrc = crc;
+    return ok;
+}
+
+int writeVoteFile(const char* path, long count, VoteRowAt rowAt, void* ctx) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VOTE_FILE_MAGIC, 8);
+    header.version = VOTE_FILE_VERSION;
+    header.voteCount = count;
+    header.blockCount = (uint32_t)((count + VOTE_BLOCK_RECORDS - 1) / VOTE_BLOCK_RECORDS);
+
+    VoterDictionary dict;
+    memset(&dict, 0, sizeof(dict));
+    size_t blockBytes = sizeof(BlockHeader) + (size_t)VOTE_BLOCK_RECORDS * (8 + 4 + VOTE_PAYLOAD_MAX) + 8;
+    char* buffer = (char*)malloc(blockBytes);
+    uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * (header.blockCount + 1));
+    int ok = buffer && offsets && initStringIndex(&dict.index, 1024, dictionaryName, &dict) &&
+             fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+
+    for (uint32_t b = 0; ok && b < header.blockCount; b++) {
+        long first = (long)b * VOTE_BLOCK_RECORDS;
+        int rows = (int)(count - first < VOTE_BLOCK_RECORDS ? count - first : VOTE_BLOCK_RECORDS);
+        offsets[b] = (uint64_t)ftell(file);
+        ok = writeBlock(file, first, rows, rowAt, ctx, &dict, buffer);
+    }
+    if (ok) {
+        header.indexOffset = (uint64_t)ftell(file);
+        size_t length = sizeof(uint64_t) * header.blockCount;
+        ok = fwrite(offsets, 1, length, file) == length;
+    }
+    if (ok) {
+        header.dictOffset = (uint64_t)ftell(file);
+        header.voterCount = dict.count;
+        ok = writeDictionary(file, &dict, &header);
+    }
+    if (ok) {
+        header.headerCrc = crc32(0, &header, offsetof(FileHeader, headerCrc));
+        ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+    }
+
+    ok = ok && syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    free(buffer);
+    free(offsets);
+    free(dict.names);
+    freeStringIndex(&dict.index);
+    return ok;
+}
+
+int openVoteFile(const char* path, VoteFile* file) {
+    memset(file, 0, sizeof(VoteFile));
+    if (!mapFile(path, &file->map)) return 0;
+    const FileHeader* header = (const FileHeader*)file->map.data;
+    size_t size = file->map.length;
+    int ok = size >= sizeof(FileHeader) && memcmp(header->magic, VOTE_FILE_MAGIC, 8) == 0 &&
+             header->version == VOTE_FILE_VERSION &&
+             header->headerCrc == crc32(0, header, offsetof(FileHeader, headerCrc)) &&
+             header->indexOffset <= size && sizeof(uint64_t) * (uint64_t)header->blockCount <= size - header->indexOffset &&
+             header->dictOffset <= size && header->dictLength <= size - header->dictOffset &&
+             header->dictLength >= sizeof(uint32_t) * ((uint64_t)header->voterCount + 1) &&
+             header->dictCrc == crc32(0, file->map.data + header->dictOffset, header->dictLength);
+    if (!ok) {
+        closeVoteFile(file);
+        return 0;
+    }
+    file->voteCount = header->voteCount;
+    file->voterCount = header->voterCount;
+    file->blockCount = header->blockCount;
+    file->blockOffsets = (const uint64_t*)(file->map.data + header->indexOffset);
+    file->voterOffsets = (const uint32_t*)(file->map.data + header->dictOffset);
+    file->voterNames = (const char*)(file->voterOffsets + header->voterCount + 1);
+
+    // Every name must start inside the name area, which must end in a NUL
+    uint64_t namesLength = header->dictLength - sizeof(uint32_t) * ((uint64_t)header->voterCount + 1);
+    ok = file->voterOffsets[header->voterCount] == namesLength &&
+         (namesLength == 0 ? header->voterCount == 0 : file->voterNames[namesLength - 1] == 0);
+    for (uint32_t i = 0; ok && i < header->voterCount; i++) ok = file->voterOffsets[i] < namesLength;
+    if (!ok) {
+        closeVoteFile(file);
+        return 0;
+    }
+    return 1;
+}
+
+void closeVoteFile(VoteFile* file) {
+    unmapFile(&file->map);
+    memset(file, 0, sizeof(VoteFile));
+}
+
+const void* voteFileColumn(const VoteFile* file, uint32_t block, VoteColumn column, int* count, int* width) {
+    // Offsets and lengths are checked against the mapping and against each
+    // other, not just the CRCs: a crafted file can carry valid checksums
+    if (block >= file->blockCount) return NULL;
+    uint64_t blockOffset = file->blockOffsets[block];
+    if (blockOffset % 8 != 0 || blockOffset > file->map.length ||
+        file->map.length - blockOffset < sizeof(BlockHeader)) return NULL;
+    const char* start = file->map.data + blockOffset;
+    BlockHeader header;
+    memcpy(&header, start, sizeof(header));
+    uint32_t crc = header.headerCrc;
+    header.headerCrc = 0;
+    if (header.magic != VOTE_BLOCK_MAGIC || crc32(0, &header, sizeof(header)) != crc) return NULL;
+    if (header.count > VOTE_BLOCK_RECORDS || header.payloadWidth < 1 || header.payloadWidth > VOTE_PAYLOAD_MAX) return NULL;
+
+    static const uint32_t elementBytes[VOTE_COLUMNS] = {sizeof(int64_t), sizeof(uint32_t), 1};
+    uint32_t element = column == VOTE_COLUMN_PAYLOAD ? header.payloadWidth : elementBytes[column];
+    const ColumnRef* ref = &header.columns[column];
+    if (ref->length != (uint64_t)header.count * element || ref->offset % elementBytes[column] != 0) return NULL;
+    if ((uint64_t)ref->offset + ref->length > file->map.length - blockOffset) return NULL;
+    if (crc32(0, start + ref->offset, ref->length) != ref->crc) return NULL;
+    *count = (int)header.count;
+    if (width) *width = (int)header.payloadWidth;
+    return start + ref->offset;
+}
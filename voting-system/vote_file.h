@@ -0,0 +1,71 @@
+#ifndef VOTE_FILE_H
+#define VOTE_FILE_H
+
+// Binary columnar vote snapshot (votes.bin). Layout, all little-endian:
+//
+//   header      magic "OVSVOTES", version, counts, offsets, header CRC
+//   blocks      up to VOTE_BLOCK_RECORDS votes each, column by column:
+//                 timestamps  int64[count]
+//                 voters      uint32[count], ids into the voter dictionary
+//                 payloads    uint8[count * width], zero-padded, width per block
+//               every column has its own CRC-32 in the block header
+//   index       uint64 offset of each block
+//   dictionary  uint32 offsets[voterCount + 1], then NUL-terminated voter ids
+//
+// Voter ids are interned, so a voter appears once however many rows refer to
+// it. A reader maps the file and checks only the columns it asks for, so a
+// tally that needs only payloads never touches timestamps or voter ids.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mapped_file.h"
+
+#define VOTE_FILE_VERSION 1
+#define VOTE_BLOCK_RECORDS 65536
+#define VOTE_PAYLOAD_MAX 64
+
+typedef struct {
+    const char* voterId;        // must stay valid until writeVoteFile returns
+    const void* payload;
+    int payloadLength;          // at most VOTE_PAYLOAD_MAX
+    int64_t timestamp;
+} VoteRow;
+
+typedef void (*VoteRowAt)(long i, VoteRow* row, void* ctx);
+
+// Writes rows 0..count-1 to path and fsyncs it. Returns 0 on I/O or
+// allocation failure.
+int writeVoteFile(const char* path, long count, VoteRowAt rowAt, void* ctx);
+
+typedef enum {
+    VOTE_COLUMN_TIMESTAMP,
+    VOTE_COLUMN_VOTER,
+    VOTE_COLUMN_PAYLOAD,
+    VOTE_COLUMNS
+} VoteColumn;
+
+typedef struct {
+    MappedFile map;
+    uint64_t voteCount;
+    uint32_t voterCount;
+    uint32_t blockCount;
+    const uint64_t* blockOffsets;
+    const uint32_t* voterOffsets;
+    const char* voterNames;
+} VoteFile;
+
+// Returns 0 if the file is missing, not a vote file, or its header or
+// dictionary fails the checksum
+int openVoteFile(const char* path, VoteFile* file);
+void closeVoteFile(VoteFile* file);
+
+static inline const char* voteFileVoter(const VoteFile* file, uint32_t id) {
+    return file->voterNames + file->voterOffsets[id];
+}
+
+// Column of one block after checking its CRC, or NULL if it is damaged.
+// *count is the number of rows; *width the bytes per payload.
+const void* voteFileColumn(const VoteFile* file, uint32_t block, VoteColumn column, int* count, int* width);
+
+#endif // VOTE_FILE_H
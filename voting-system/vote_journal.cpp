@@ -0,0 +1,243 @@
+#include "vote_journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// Journal state (one journal per process, like the rest of the voting globals)
+static std::mutex journalMutex;
+static std::condition_variable journalWake;     // flusher: work to do
+static std::condition_variable journalDurable;  // appenders: batch is on disk
+static std::thread flusherThread, compactThread;
+static JournalPolicy journalPolicy;
+static std::string journalPath;
+static int journalFd = -1;
+static std::string pending;
+static int pendingRecords = 0;
+static Clock::time_point firstPending;
+static uint64_t appendedSeq = 0, durableSeq = 0;
+static bool flushing = false, stopping = false, ioError = false, compacting = false, compactFailed = false;
+static long recordsSinceCompaction = 0;
+static JournalStats stats;
+
+JournalPolicy defaultJournalPolicy(void) {
+    JournalPolicy policy;
+    policy.maxBatchRecords = 4096;
+    policy.maxBatchMillis = 5;
+    policy.compactAfterRecords = 100000;
+    return policy;
+}
+
+static int writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        long n = write(fd, data, length);
+        if (n <= 0) return 0;
+        data += n;
+        length -= n;
+    }
+    return 1;
+}
+
+static int fileExists(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file) fclose(file);
+    return file != NULL;
+}
+
+static int appendFile(const char* from, const char* to) {
+    FILE* in = fopen(from, "rb");
+    if (!in) return 1;
+    int out = open(to, O_WRONLY | O_APPEND);
+    int ok = out >= 0;
+    char buffer[65536];
+    for (size_t n; ok && (n = fread(buffer, 1, sizeof(buffer), in)) > 0;) ok = writeAll(out, buffer, n);
+    ok = ok && fsync(out) == 0;
+    if (out >= 0) close(out);
+    fclose(in);
+    return ok;
+}
+
+static long replayFile(const char* path, JournalApply apply, void* ctx) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    long count = 0;
+    size_t capacity = 256;
+    char* line = (char*)malloc(capacity);
+    size_t length = 0;
+    for (int c; line && (c = fgetc(file)) != EOF;) {
+        if (c != '\n') {
+            if (length + 1 == capacity) {
+                char* grown = (char*)realloc(line, capacity *= 2);
+                if (!grown) break;
+                line = grown;
+            }
+            line[length++] = (char)c;
+            continue;
+        }
+        line[length] = 0;
+        apply(line, (int)length, ctx);
+        count++;
+        length = 0;
+    }
+    // A torn final record (no newline) was never acknowledged; drop it
+    free(line);
+    fclose(file);
+    return count;
+}
+
+long journalReplay(const char* path, JournalApply apply, void* ctx) {
+    std::string rotated = std::string(path) + ".1";
+    return replayFile(rotated.c_str(), apply, ctx) + replayFile(path, apply, ctx);
+}
+
+// Called with the lock held; drops it around the write + fsync
+static void flushPending(std::unique_lock<std::mutex>& lock) {
+    std::string batch;
+    batch.swap(pending);
+    int records = pendingRecords;
+    uint64_t seq = appendedSeq;
+    pendingRecords = 0;
+    flushing = true;
+
+    lock.unlock();
+    int ok = writeAll(journalFd, batch.data(), batch.size()) && fsync(journalFd) == 0;
+    lock.lock();
+
+    flushing = false;
+    if (!ok) ioError = true;
+    durableSeq = seq;
+    stats.records += records;
+    stats.batches++;
+    stats.bytes += batch.size();
+    journalDurable.notify_all();
+}
+
+static void flusherLoop() {
+    std::unique_lock<std::mutex> lock(journalMutex);
+    while (true) {
+        if (pendingRecords == 0) {
+            if (stopping) break;
+            journalWake.wait(lock);
+            continue;
+        }
+        Clock::time_point deadline = firstPending + std::chrono::milliseconds(journalPolicy.maxBatchMillis);
+        if (!stopping && pendingRecords < journalPolicy.maxBatchRecords && Clock::now() < deadline) {
+            journalWake.wait_until(lock, deadline);
+            continue;
+        }
+        flushPending(lock);
+    }
+}
+
+int journalOpen(const char* path, const JournalPolicy* policy) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    if (journalFd >= 0) return 1;
+    journalFd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (journalFd < 0) return 0;
+    journalPath = path;
+    journalPolicy = policy ? *policy : defaultJournalPolicy();
+    stopping = false;
+    ioError = false;
+    flusherThread = std::thread(flusherLoop);
+    return 1;
+}
+
+void journalClose(void) {
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if (journalFd < 0) return;
+        stopping = true;
+    }
+    journalWake.notify_all();
+    flusherThread.join();
+    if (compactThread.joinable()) compactThread.join();
+    close(journalFd);
+    journalFd = -1;
+}
+
+uint64_t journalAppend(const char* record, int length) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    if (journalFd < 0 || ioError) return 0;
+    if (pendingRecords == 0) firstPending = Clock::now();
+    pending.append(record, length);
+    pending.push_back('\n');
+    recordsSinceCompaction++;
+    if (++pendingRecords >= journalPolicy.maxBatchRecords || pendingRecords == 1) journalWake.notify_one();
+    return ++appendedSeq;
+}
+
+int journalWaitDurable(uint64_t seq) {
+    std::unique_lock<std::mutex> lock(journalMutex);
+    journalDurable.wait(lock, [seq] { return durableSeq >= seq || ioError; });
+    return !ioError;
+}
+
+int journalNeedsCompaction(void) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    return !compacting && recordsSinceCompaction >= journalPolicy.compactAfterRecords;
+}
+
+int journalCompact(SnapshotWriter writer, void* ctx) {
+    std::unique_lock<std::mutex> lock(journalMutex);
+    if (journalFd < 0 || compacting) return 0;
+    if (compactThread.joinable()) compactThread.join();
+
+    // Everything appended so far goes into the rotated file
+    journalDurable.wait(lock, [] { return !flushing; });
+    if (pendingRecords > 0) flushPending(lock);
+    journalDurable.wait(lock, [] { return !flushing; });
+
+    // A rotated file left by an interrupted compaction is not in any snapshot
+    // yet, so the active journal is appended to it instead of replacing it
+    std::string rotated = journalPath + ".1";
+    close(journalFd);
+    int rotatedOk = fileExists(rotated.c_str())
+        ? appendFile(journalPath.c_str(), rotated.c_str())
+        : rename(journalPath.c_str(), rotated.c_str()) == 0;
+    journalFd = open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | (rotatedOk ? O_TRUNC : 0), 0644);
+    if (journalFd < 0) {
+        ioError = true;
+        return 0;
+    }
+    if (!rotatedOk) return 0;
+    recordsSinceCompaction = 0;
+    compacting = true;
+    stats.compactions++;
+
+    compactThread = std::thread([writer, ctx, rotated] {
+        // On failure the rotated file stays and is replayed at next startup.
+        // Success means the snapshot is fsynced, so the journal can go.
+        bool written = writer(ctx);
+        if (written) remove(rotated.c_str());
+        std::lock_guard<std::mutex> done(journalMutex);
+        compacting = false;
+        compactFailed = !written;
+        journalDurable.notify_all();
+    });
+    return 1;
+}
+
+int journalWaitCompaction(void) {
+    std::unique_lock<std::mutex> lock(journalMutex);
+    journalDurable.wait(lock, [] { return !compacting; });
+    return !compactFailed;
+}
+
+JournalStats journalStats(void) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    return stats;
+}
@@ -0,0 +1,59 @@
+#ifndef VOTE_JOURNAL_H
+#define VOTE_JOURNAL_H
+
+// Append-only journal for registrations, votes and candidates. Records are
+// buffered and written by a group-commit thread that fsyncs once per batch
+// (every maxBatchMillis or maxBatchRecords, whichever comes first), so the
+// cost of a vote no longer depends on how many votes came before it.
+//
+// The snapshot files (users.txt etc.) are only rewritten by compaction, which
+// rotates the journal and runs the snapshot writer on a background thread.
+// Replay must be idempotent: after a crash during compaction the rotated
+// journal is replayed on top of a snapshot that may already contain it.
+
+#include <stdint.h>
+
+typedef struct {
+    int maxBatchRecords;        // flush once this many records are pending
+    int maxBatchMillis;         // ...or once the oldest pending record is this old
+    int compactAfterRecords;    // journalNeedsCompaction() threshold
+} JournalPolicy;
+
+typedef void (*JournalApply)(char* record, int length, void* ctx);
+typedef int (*SnapshotWriter)(void* ctx);     // returns 0 on failure
+
+JournalPolicy defaultJournalPolicy(void);
+
+// Replays <path>.1 (left over from an interrupted compaction) and then <path>.
+// Each record is passed without its trailing newline. Returns records replayed.
+long journalReplay(const char* path, JournalApply apply, void* ctx);
+
+int journalOpen(const char* path, const JournalPolicy* policy);
+void journalClose(void);    // flushes everything and waits for compaction
+
+// Queues one record (no newline) and returns its sequence number, 0 on error.
+uint64_t journalAppend(const char* record, int length);
+// Blocks until every record up to seq is on disk. Returns 0 on I/O error.
+int journalWaitDurable(uint64_t seq);
+
+int journalNeedsCompaction(void);
+// Rotates the journal and runs writer(ctx) on a background thread; the rotated
+// file is deleted once writer returns 1, so writer must only do that once the
+// snapshot is durable (files and directory fsynced). ctx must describe the state as
+// of this call (every record appended so far). Returns 0 if a compaction is
+// already running or the journal could not be rotated.
+int journalCompact(SnapshotWriter writer, void* ctx);
+// Blocks until a running compaction has finished. Returns 0 if the last
+// compaction's snapshot writer failed.
+int journalWaitCompaction(void);
+
+typedef struct {
+    uint64_t records;
+    uint64_t batches;           // one write() + one fsync() each
+    uint64_t bytes;
+    uint64_t compactions;
+} JournalStats;
+
+JournalStats journalStats(void);
+
+#endif // VOTE_JOURNAL_H
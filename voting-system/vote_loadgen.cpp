@@ -0,0 +1,519 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "password_hash.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Election-day load test for server mode. Builds a data directory with
+// synthesized voters and candidates, starts `ovs_in_c_c --serve` in it and
+// replays a day of arrivals compressed into --seconds, at a rate that peaks
+// at opening and closing. Each arrival is a registration, a voter (LOGIN,
+// VOTE and LOGOUT) or a look at the results, in --mix proportions, and is
+// served by one of --clients connections (the polling-station terminals).
+// The schedule is fixed up front and latency is counted from each arrival's
+// scheduled time, so a server that falls behind shows up in the percentiles
+// instead of slowing the load down. The report gives throughput, latency
+// percentiles, and the fsyncs and bytes written per vote from the server's
+// STATS counters and /proc.
+// Usage: vote_loadgen <ovs_in_c_c> [--seconds S] [--peak R] [--base R] [--clients N]
+//        [--mix register,vote,results] [--users N] [--candidates N] [--dir D] [--seed N]
+
+#define LOADGEN_PASSWORD "Voter#2024"
+#define LOADGEN_BUCKETS 10
+#define LOADGEN_LINE_MAX 4096
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+typedef enum { ARRIVE_REGISTER, ARRIVE_VOTE, ARRIVE_RESULTS, ARRIVE_KINDS } ArrivalKind;
+
+typedef enum { OP_REGISTER, OP_LOGIN, OP_VOTE, OP_LOGOUT, OP_RESULTS, OPS } Op;
+
+static const char* opNames[OPS] = {"REGISTER", "LOGIN", "VOTE", "LOGOUT", "RESULTS"};
+
+typedef struct {
+    double at;                  // seconds from the start
+    ArrivalKind kind;
+    int subject;                // voter or registration number
+    int candidate;
+} Arrival;
+
+typedef struct {
+    double seconds, peak, base;
+    int clients, users, candidates, seed;
+    int mix[ARRIVE_KINDS];
+    const char* dir;
+    const char* server;
+} LoadgenOptions;
+
+typedef struct {
+    std::vector<double> latency[OPS];       // ms, from send to reply
+    long errors[OPS];
+    std::vector<double> arrivalLatency;     // ms, from the scheduled time
+    std::vector<int> scheduledBucket, doneBucket;
+    long votesAccepted;
+} ClientLog;
+
+#ifdef __linux__
+
+// The arrival rate over the day, x in [0, 1): base plus a peak at opening
+// and another at closing, each about a tenth of the day wide
+static double arrivalRate(const LoadgenOptions* o, double x) {
+    double open = exp(-pow((x - 0.04) / 0.06, 2)), close = exp(-pow((x - 0.96) / 0.06, 2));
+    return o->base + (o->peak - o->base) * std::max(open, close);
+}
+
+// Poisson arrivals at the curve's rate
+static std::vector<Arrival> scheduleArrivals(const LoadgenOptions* o, int* voters, int* registrations) {
+    std::mt19937_64 random(o->seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    int total = o->mix[0] + o->mix[1] + o->mix[2];
+    std::vector<Arrival> arrivals;
+    *voters = *registrations = 0;
+    double t = 0;
+    while (1) {
+        t += -log(1.0 - uniform(random)) / arrivalRate(o, t / o->seconds);
+        if (t >= o->seconds) break;
+        Arrival a;
+        a.at = t;
+        int pick = (int)(uniform(random) * total);
+        a.kind = pick < o->mix[0] ? ARRIVE_REGISTER : pick < o->mix[0] + o->mix[1] ? ARRIVE_VOTE : ARRIVE_RESULTS;
+        a.subject = a.kind == ARRIVE_REGISTER ? (*registrations)++ : a.kind == ARRIVE_VOTE ? (*voters)++ : 0;
+        a.candidate = 1 + (int)(uniform(random) * o->candidates);
+        arrivals.push_back(a);
+    }
+    return arrivals;
+}
+
+static void removeOldData(const char* dir) {
+    static const char* files[] = {"users.txt", "candidates.txt", "votes.bin", "votes.txt", "journal.log",
+                                  "journal.log.1", "audit.txt", "server.log"};
+    char path[1024];
+    for (const char* file : files) {
+        snprintf(path, sizeof(path), "%s/%s", dir, file);
+        remove(path);
+    }
+    DIR* d = opendir(dir);
+    if (!d) return;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (strncmp(entry->d_name, "audit.txt.", 10) != 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        remove(path);
+    }
+    closedir(d);
+}
+
+// Every synthesized voter has the same password, so one hash (at the
+// server's cost) serves them all and no login has to rehash
+static int writeData(const LoadgenOptions* o) {
+    char path[1024], hash[PASSWORD_HASH_MAX];
+    PasswordCost cost = defaultPasswordCost();
+    if (!hashPassword(LOADGEN_PASSWORD, &cost, hash)) return 0;
+    snprintf(path, sizeof(path), "%s/users.txt", o->dir);
+    FILE* file = fopen(path, "w");
+    if (!file) return 0;
+    fprintf(file, "admin@example.com\t%s\tAdmin User\t1\t1\n", hash);
+    for (int i = 0; i < o->users; i++) fprintf(file, "voter%d@loadgen\t%s\tVoter %d\t1\t0\n", i, hash, i);
+    if (fclose(file) != 0) return 0;
+    snprintf(path, sizeof(path), "%s/candidates.txt", o->dir);
+    file = fopen(path, "w");
+    if (!file) return 0;
+    for (int i = 1; i <= o->candidates; i++) fprintf(file, "%d\tCandidate %d\tParty %d\t0\n", i, i, i);
+    return fclose(file) == 0;
+}
+
+static pid_t startServer(const LoadgenOptions* o) {
+    char* server = realpath(o->server, NULL);
+    if (!server) return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(o->dir) != 0) _exit(127);
+        int log = open("server.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int null = open("/dev/null", O_RDONLY);
+        if (log < 0 || null < 0) _exit(127);
+        dup2(null, 0);
+        dup2(log, 1);
+        dup2(log, 2);
+        execl(server, server, "--serve", "ovs.sock", (char*)NULL);
+        _exit(127);
+    }
+    free(server);
+    return pid;
+}
+
+typedef struct {
+    int fd;
+    char buffer[LOADGEN_LINE_MAX];
+    size_t length;
+} Connection;
+
+static int connectTo(const char* path, Connection* conn) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) return 0;
+    memcpy(address.sun_path, path, strlen(path));
+    conn->length = 0;
+    conn->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0) return 0;
+    if (connect(conn->fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(conn->fd);
+        conn->fd = -1;
+        return 0;
+    }
+    return 1;
+}
+
+static int readLine(Connection* conn, char* line, size_t size) {
+    while (1) {
+        char* newline = (char*)memchr(conn->buffer, '\n', conn->length);
+        if (newline) {
+            size_t n = newline - conn->buffer;
+            snprintf(line, size, "%.*s", (int)n, conn->buffer);
+            conn->length -= n + 1;
+            memmove(conn->buffer, newline + 1, conn->length);
+            return 1;
+        }
+        if (conn->length == sizeof(conn->buffer)) return 0;
+        ssize_t n = recv(conn->fd, conn->buffer + conn->length, sizeof(conn->buffer) - conn->length, 0);
+        if (n > 0) conn->length += n;
+        else if (n == 0 || errno != EINTR) return 0;
+    }
+}
+
+// Sends one request and reads the reply. For a list request (each is not
+// NULL) the reply's lines are read and passed to each. Returns 0 if the
+// connection failed.
+static int request(Connection* conn, const char* line, char* reply, size_t size,
+                   void (*each)(const char* item, void* ctx), void* ctx) {
+    char out[LOADGEN_LINE_MAX];
+    int n = snprintf(out, sizeof(out), "%s\n", line);
+    for (int sent = 0; sent < n;) {
+        ssize_t k = send(conn->fd, out + sent, n - sent, MSG_NOSIGNAL);
+        if (k <= 0) return 0;
+        sent += k;
+    }
+    if (!readLine(conn, reply, size)) return 0;
+    int items;
+    if (each && sscanf(reply, "OK %d", &items) == 1) {
+        char item[LOADGEN_LINE_MAX];
+        for (int i = 0; i < items; i++) {
+            if (!readLine(conn, item, sizeof(item))) return 0;
+            each(item, ctx);
+        }
+    }
+    return 1;
+}
+
+static void skipItem(const char* item, void* ctx) {
+    (void)item; (void)ctx;
+}
+
+static void timed(ClientLog* log, Op op, Connection* conn, const char* line, char* reply, size_t size) {
+    Clock::time_point start = Clock::now();
+    if (!request(conn, line, reply, size, op == OP_RESULTS ? skipItem : NULL, NULL)) {
+        snprintf(reply, size, "ERR connection lost");
+    }
+    log->latency[op].push_back(secondsSince(start) * 1000);
+    if (strncmp(reply, "OK", 2) != 0) log->errors[op]++;
+}
+
+static void serveArrival(const Arrival* a, Connection* conn, ClientLog* log) {
+    char line[LOADGEN_LINE_MAX], reply[LOADGEN_LINE_MAX];
+    if (a->kind == ARRIVE_REGISTER) {
+        snprintf(line, sizeof(line), "REGISTER new%d@loadgen %s New Voter %d", a->subject, LOADGEN_PASSWORD, a->subject);
+        timed(log, OP_REGISTER, conn, line, reply, sizeof(reply));
+    } else if (a->kind == ARRIVE_VOTE) {
+        snprintf(line, sizeof(line), "LOGIN voter%d@loadgen %s", a->subject, LOADGEN_PASSWORD);
+        timed(log, OP_LOGIN, conn, line, reply, sizeof(reply));
+        if (strncmp(reply, "OK ", 3) != 0) return;
+        char session[64];
+        snprintf(session, sizeof(session), "%.63s", reply + 3);
+        snprintf(line, sizeof(line), "VOTE %s %d", session, a->candidate);
+        timed(log, OP_VOTE, conn, line, reply, sizeof(reply));
+        if (strcmp(reply, "OK") == 0) log->votesAccepted++;
+        snprintf(line, sizeof(line), "LOGOUT %s", session);
+        timed(log, OP_LOGOUT, conn, line, reply, sizeof(reply));
+    } else {
+        timed(log, OP_RESULTS, conn, "RESULTS", reply, sizeof(reply));
+    }
+}
+
+typedef struct {
+    const char* name;
+    long long value;
+} Counter;
+
+static void readCounter(const char* item, void* ctx) {
+    std::vector<Counter>* counters = (std::vector<Counter>*)ctx;
+    char name[64];
+    long long value;
+    if (sscanf(item, "%63[^\t]\t%lld", name, &value) != 2) return;
+    for (Counter& c : *counters) {
+        if (strcmp(c.name, name) == 0) c.value = value;
+    }
+}
+
+static long long counter(const std::vector<Counter>& counters, const char* name) {
+    for (const Counter& c : counters) {
+        if (strcmp(c.name, name) == 0) return c.value;
+    }
+    return 0;
+}
+
+static std::vector<Counter> serverStats(const char* socketPath) {
+    std::vector<Counter> counters = {{"journal.records", 0}, {"journal.fsyncs", 0}, {"journal.bytes", 0},
+                                     {"journal.compactions", 0}, {"audit.records", 0}, {"audit.fsyncs", 0},
+                                     {"audit.bytes", 0}};
+    Connection conn;
+    char reply[LOADGEN_LINE_MAX];
+    if (connectTo(socketPath, &conn)) {
+        request(&conn, "STATS", reply, sizeof(reply), readCounter, &counters);
+        close(conn.fd);
+    }
+    return counters;
+}
+
+static void sumVotes(const char* item, void* ctx) {
+    int id;
+    char name[LOADGEN_LINE_MAX];
+    long votes;
+    if (sscanf(item, "%d\t%[^\t]\t%ld", &id, name, &votes) == 3) *(long*)ctx += votes;
+}
+
+// Bytes the server has passed to write(), and those that reached storage
+static int processWrites(pid_t pid, long long* written, long long* stored) {
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    *written = *stored = -1;
+    while (fgets(line, sizeof(line), file)) {
+        sscanf(line, "wchar: %lld", written);
+        sscanf(line, "write_bytes: %lld", stored);
+    }
+    fclose(file);
+    return *written >= 0;
+}
+
+static double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void printLatency(const char* name, std::vector<double>& v, long errors, double seconds) {
+    if (v.empty()) return;
+    printf("%-10s %8zu %8.1f %8.1f %8.1f %8.1f %8.1f %7ld\n", name, v.size(), v.size() / seconds,
+           percentile(v, 0.50), percentile(v, 0.90), percentile(v, 0.99), percentile(v, 1.0), errors);
+}
+
+static int parseOptions(int argc, char** argv, LoadgenOptions* o) {
+    o->seconds = 60;
+    o->peak = 40;
+    o->base = 4;
+    o->clients = 32;
+    o->users = 0;
+    o->candidates = 8;
+    o->seed = 1;
+    o->mix[ARRIVE_REGISTER] = 5;
+    o->mix[ARRIVE_VOTE] = 80;
+    o->mix[ARRIVE_RESULTS] = 15;
+    o->dir = "loadgen-data";
+    if (argc < 2) return 0;
+    o->server = argv[1];
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--seconds") == 0) o->seconds = atof(value);
+        else if (strcmp(name, "--peak") == 0) o->peak = atof(value);
+        else if (strcmp(name, "--base") == 0) o->base = atof(value);
+        else if (strcmp(name, "--clients") == 0) o->clients = atoi(value);
+        else if (strcmp(name, "--users") == 0) o->users = atoi(value);
+        else if (strcmp(name, "--candidates") == 0) o->candidates = atoi(value);
+        else if (strcmp(name, "--seed") == 0) o->seed = atoi(value);
+        else if (strcmp(name, "--dir") == 0) o->dir = value;
+        else if (strcmp(name, "--mix") == 0) {
+            if (sscanf(value, "%d,%d,%d", &o->mix[0], &o->mix[1], &o->mix[2]) != 3) return 0;
+        } else {
+            return 0;
+        }
+    }
+    return (argc % 2 == 0) && o->seconds > 0 && o->base > 0 && o->peak >= o->base && o->clients > 0 &&
+           o->candidates > 0 && o->mix[0] >= 0 && o->mix[1] >= 0 && o->mix[2] >= 0 &&
+           o->mix[0] + o->mix[1] + o->mix[2] > 0;
+}
+
+int main(int argc, char** argv) {
+    LoadgenOptions o;
+    if (!parseOptions(argc, argv, &o)) {
+        printf("Usage: vote_loadgen <ovs_in_c_c> [--seconds S] [--peak R] [--base R] [--clients N]\n"
+               "       [--mix register,vote,results] [--users N] [--candidates N] [--dir D] [--seed N]\n");
+        return 2;
+    }
+    int voters, registrations;
+    std::vector<Arrival> arrivals = scheduleArrivals(&o, &voters, &registrations);
+    if (o.users < voters) o.users = voters;
+
+    char socketPath[1024];
+    snprintf(socketPath, sizeof(socketPath), "%s/ovs.sock", o.dir);
+    mkdir(o.dir, 0755);
+    removeOldData(o.dir);
+    if (!writeData(&o)) {
+        printf("Could not write the data files in %s!\n", o.dir);
+        return 1;
+    }
+    pid_t pid = startServer(&o);
+    Connection probe;
+    Clock::time_point waited = Clock::now();
+    while (pid > 0 && !connectTo(socketPath, &probe)) {
+        if (waitpid(pid, NULL, WNOHANG) == pid || secondsSince(waited) > 60) {
+            printf("The server did not start; see %s/server.log\n", o.dir);
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    if (pid <= 0) {
+        printf("Could not start %s!\n", o.server);
+        return 1;
+    }
+    close(probe.fd);
+    printf("%zu arrivals over %.0f s (%d register, %d vote, %zu results), rate %.0f-%.0f/s, %d clients,\n"
+           "%d voters and %d candidates on file, server started in %.1f s\n",
+           arrivals.size(), o.seconds, registrations, voters, arrivals.size() - registrations - voters, o.base,
+           o.peak, o.clients, o.users, o.candidates, secondsSince(waited));
+
+    std::vector<Counter> before = serverStats(socketPath);
+    long long writtenBefore = 0, storedBefore = 0, writtenAfter = 0, storedAfter = 0;
+    int haveIo = processWrites(pid, &writtenBefore, &storedBefore);
+
+    std::vector<ClientLog> logs(o.clients);
+    std::atomic<size_t> next{0};
+    std::atomic<int> lost{0};
+    std::vector<std::thread> clients;
+    Clock::time_point start = Clock::now();
+    for (int c = 0; c < o.clients; c++) {
+        clients.emplace_back([&, c] {
+            ClientLog* log = &logs[c];
+            memset(log->errors, 0, sizeof(log->errors));
+            log->votesAccepted = 0;
+            Connection conn;
+            if (!connectTo(socketPath, &conn)) {
+                lost++;
+                return;
+            }
+            size_t i;
+            while ((i = next++) < arrivals.size()) {
+                const Arrival* a = &arrivals[i];
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                                              std::chrono::duration<double>(a->at)));
+                serveArrival(a, &conn, log);
+                double done = secondsSince(start);
+                log->arrivalLatency.push_back((done - a->at) * 1000);
+                log->scheduledBucket.push_back(std::min((int)(a->at / o.seconds * LOADGEN_BUCKETS), LOADGEN_BUCKETS - 1));
+                log->doneBucket.push_back(std::min((int)(done / o.seconds * LOADGEN_BUCKETS), LOADGEN_BUCKETS - 1));
+            }
+            close(conn.fd);
+        });
+    }
+    for (std::thread& t : clients) t.join();
+    double elapsed = secondsSince(start);
+
+    std::vector<Counter> after = serverStats(socketPath);
+    if (haveIo) haveIo = processWrites(pid, &writtenAfter, &storedAfter);
+    long tallied = 0;
+    Connection conn;
+    char reply[LOADGEN_LINE_MAX];
+    if (connectTo(socketPath, &conn)) {
+        // The load phase's results are cached; the tally must include every vote
+        request(&conn, "RESULTS FRESH", reply, sizeof(reply), sumVotes, &tallied);
+        close(conn.fd);
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+
+    // Merge the clients' logs
+    ClientLog all;
+    memset(all.errors, 0, sizeof(all.errors));
+    all.votesAccepted = 0;
+    std::vector<double> bucketLatency[LOADGEN_BUCKETS];
+    long offered[LOADGEN_BUCKETS] = {0}, served[LOADGEN_BUCKETS] = {0};
+    for (ClientLog& log : logs) {
+        for (int op = 0; op < OPS; op++) {
+            all.latency[op].insert(all.latency[op].end(), log.latency[op].begin(), log.latency[op].end());
+            all.errors[op] += log.errors[op];
+        }
+        for (size_t i = 0; i < log.arrivalLatency.size(); i++) {
+            all.arrivalLatency.push_back(log.arrivalLatency[i]);
+            bucketLatency[log.scheduledBucket[i]].push_back(log.arrivalLatency[i]);
+            offered[log.scheduledBucket[i]]++;
+            served[log.doneBucket[i]]++;
+        }
+        all.votesAccepted += log.votesAccepted;
+    }
+
+    printf("\nRequests      count      /s   p50 ms   p90 ms   p99 ms   max ms  errors\n");
+    for (int op = 0; op < OPS; op++) printLatency(opNames[op], all.latency[op], all.errors[op], elapsed);
+    printLatency("arrival", all.arrivalLatency, 0, elapsed);
+    printf("(arrival: from the scheduled time to the last reply, queueing included)\n");
+
+    // Arrivals finishing after the day count towards its last tenth
+    printf("\nTimeline  offered/s  served/s  p99 ms\n");
+    double bucketSeconds = o.seconds / LOADGEN_BUCKETS;
+    for (int b = 0; b < LOADGEN_BUCKETS; b++) {
+        printf("%4.0f s %10.1f %9.1f %8.1f\n", b * bucketSeconds, offered[b] / bucketSeconds,
+               served[b] / bucketSeconds, percentile(bucketLatency[b], 0.99));
+    }
+
+    long long journalFsyncs = counter(after, "journal.fsyncs") - counter(before, "journal.fsyncs");
+    long long auditFsyncs = counter(after, "audit.fsyncs") - counter(before, "audit.fsyncs");
+    long long journalBytes = counter(after, "journal.bytes") - counter(before, "journal.bytes");
+    long long auditBytes = counter(after, "audit.bytes") - counter(before, "audit.bytes");
+    long long compactions = counter(after, "journal.compactions") - counter(before, "journal.compactions");
+    double votes = all.votesAccepted > 0 ? (double)all.votesAccepted : 1.0;
+    printf("\nVotes accepted %ld in %.1f s (%.1f/s), tallied %ld%s\n", all.votesAccepted, elapsed,
+           all.votesAccepted / elapsed, tallied, tallied == all.votesAccepted ? "" : " (MISMATCH)");
+    printf("fsyncs:  %lld journal + %lld audit = %.3f per vote\n", journalFsyncs, auditFsyncs,
+           (journalFsyncs + auditFsyncs) / votes);
+    printf("bytes:   %.0f journal + %.0f audit per vote, %lld compaction(s)\n", journalBytes / votes,
+           auditBytes / votes, compactions);
+    if (haveIo) {
+        printf("server:  %.0f bytes passed to write() per vote, %.0f reached storage\n", (writtenAfter - writtenBefore) / votes,
+               storedAfter >= 0 ? (storedAfter - storedBefore) / votes : 0.0);
+    }
+    long errors = 0;
+    for (int op = 0; op < OPS; op++) errors += all.errors[op];
+    return lost > 0 || errors > 0 || tallied != all.votesAccepted;
+}
+
+#else
+
+int main() {
+    printf("vote_loadgen needs Linux.\n");
+    return 2;
+}
+
+#endif
@@ -0,0 +1,339 @@
+#include "vote_server.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define SERVER_MAX_THREADS 64
+#define SERVER_READ_CHUNK 4096
+#define SERVER_READ_TURN (64 << 10)     // input read per turn before replying
+#define SERVER_WRITE_TIMEOUT_MS 5000
+
+void replyPrintf(ServerReply* reply, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (n < 0) return;
+    if (reply->length + n + 1 > reply->capacity) {
+        size_t capacity = reply->capacity ? reply->capacity : 256;
+        while (capacity < reply->length + n + 1) capacity *= 2;
+        char* data = (char*)realloc(reply->data, capacity);
+        if (!data) return;
+        reply->data = data;
+        reply->capacity = capacity;
+    }
+    va_start(args, format);
+    vsnprintf(reply->data + reply->length, n + 1, format, args);
+    va_end(args);
+    reply->length += n;
+}
+
+ServerPolicy defaultServerPolicy(void) {
+    ServerPolicy policy;
+    policy.socketPath = "ovs.sock";
+    policy.threads = 0;
+    policy.maxConnections = 1024;
+    policy.maxLineBytes = 4096;
+    return policy;
+}
+
+static std::atomic<uint64_t> statConnections{0}, statRefused{0}, statRequests{0}, statBytesIn{0}, statBytesOut{0};
+
+ServerStats voteServerStats(void) {
+    ServerStats stats;
+    stats.connections = statConnections.load();
+    stats.refused = statRefused.load();
+    stats.requests = statRequests.load();
+    stats.bytesIn = statBytesIn.load();
+    stats.bytesOut = statBytesOut.load();
+    return stats;
+}
+
+#ifdef __linux__
+
+typedef struct {
+    int fd;
+    int slot;                   // in connections[]
+    char* in;                   // unprocessed input
+    size_t inLength;
+    size_t inCapacity;
+} Connection;
+
+// Server state (one server per process, like the journal and audit writer)
+static ServerPolicy serverPolicy;
+static ServerHandler serverHandler;
+static void* serverCtx;
+static int listenFd = -1, epollFd = -1, wakeFd = -1;
+static std::thread acceptorThread, workers[SERVER_MAX_THREADS];
+static int workerCount = 0;
+
+static std::mutex serverMutex;              // guards everything below
+static std::condition_variable queueReady;
+static Connection** ready;                  // ring of maxConnections
+static int readyHead = 0, readyCount = 0;
+static Connection** connections;            // by slot, NULL = free
+static int* freeSlots;
+static int freeCount = 0;
+static bool stopping = false;
+
+static void closeConnection(Connection* conn) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    {
+        std::lock_guard<std::mutex> lock(serverMutex);
+        connections[conn->slot] = NULL;
+        freeSlots[freeCount++] = conn->slot;
+    }
+    free(conn->in);
+    free(conn);
+}
+
+static int arm(Connection* conn, int op) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = conn;
+    return epoll_ctl(epollFd, op, conn->fd, &event) == 0;
+}
+
+static void acceptConnections(void) {
+    while (1) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;
+        }
+        Connection* conn = (Connection*)calloc(1, sizeof(Connection));
+        int slot = -1;
+        if (conn) {
+            std::lock_guard<std::mutex> lock(serverMutex);
+            if (freeCount > 0) {
+                slot = freeSlots[--freeCount];
+                connections[slot] = conn;
+            }
+        }
+        if (slot < 0) {
+            static const char busy[] = "ERR server busy\n";
+            send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL);
+            close(fd);
+            free(conn);
+            statRefused++;
+            continue;
+        }
+        conn->fd = fd;
+        conn->slot = slot;
+        statConnections++;
+        if (!arm(conn, EPOLL_CTL_ADD)) closeConnection(conn);
+    }
+}
+
+static void acceptorLoop(void) {
+    struct epoll_event events[64];
+    while (1) {
+        int n = epoll_wait(epollFd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            void* source = events[i].data.ptr;
+            if (source == &wakeFd) return;
+            if (source == &listenFd) {
+                acceptConnections();
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(serverMutex);
+            ready[(readyHead + readyCount) % serverPolicy.maxConnections] = (Connection*)source;
+            readyCount++;
+            queueReady.notify_one();
+        }
+    }
+}
+
+// Reads what has arrived, up to SERVER_READ_TURN. Returns 0 once the client
+// has closed its end or the connection failed.
+static int readInput(Connection* conn) {
+    size_t turn = 0;
+    while (turn < SERVER_READ_TURN) {
+        if (conn->inCapacity - conn->inLength < SERVER_READ_CHUNK) {
+            size_t capacity = conn->inCapacity ? conn->inCapacity * 2 : 2 * SERVER_READ_CHUNK;
+            char* in = (char*)realloc(conn->in, capacity);
+            if (!in) return 0;
+            conn->in = in;
+            conn->inCapacity = capacity;
+        }
+        ssize_t n = recv(conn->fd, conn->in + conn->inLength, conn->inCapacity - conn->inLength, 0);
+        if (n > 0) {
+            conn->inLength += n;
+            turn += n;
+            statBytesIn += n;
+        } else if (n == 0) {
+            return 0;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 1;
+        } else if (errno != EINTR) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            length -= n;
+            statBytesOut += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, SERVER_WRITE_TIMEOUT_MS) <= 0) return 0;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void serveConnection(Connection* conn) {
+    int open = readInput(conn);
+    ServerReply reply = {NULL, 0, 0};
+    char* start = conn->in;
+    char* end = conn->in + conn->inLength;
+    char* newline;
+    while (start < end && (newline = (char*)memchr(start, '\n', end - start)) != NULL) {
+        *newline = 0;
+        if (newline > start && newline[-1] == '\r') newline[-1] = 0;
+        serverHandler(start, &reply, serverCtx);
+        statRequests++;
+        start = newline + 1;
+    }
+    conn->inLength = end - start;
+    memmove(conn->in, start, conn->inLength);
+    if (conn->inLength > (size_t)serverPolicy.maxLineBytes) {
+        replyPrintf(&reply, "ERR request too long\n");
+        open = 0;
+    }
+    if (reply.length > 0 && !sendAll(conn->fd, reply.data, reply.length)) open = 0;
+    free(reply.data);
+    if (!open || !arm(conn, EPOLL_CTL_MOD)) closeConnection(conn);
+}
+
+static void workerLoop(void) {
+    std::unique_lock<std::mutex> lock(serverMutex);
+    while (1) {
+        queueReady.wait(lock, [] { return readyCount > 0 || stopping; });
+        if (readyCount == 0) return;
+        Connection* conn = ready[readyHead];
+        readyHead = (readyHead + 1) % serverPolicy.maxConnections;
+        readyCount--;
+        lock.unlock();
+        serveConnection(conn);
+        lock.lock();
+    }
+}
+
+static int watch(int fd, void* source) {
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = source;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+static void closeServerFds(void) {
+    if (listenFd >= 0) close(listenFd);
+    if (epollFd >= 0) close(epollFd);
+    if (wakeFd >= 0) close(wakeFd);
+    listenFd = epollFd = wakeFd = -1;
+    free(ready);
+    free(connections);
+    free(freeSlots);
+    ready = connections = NULL;
+    freeSlots = NULL;
+}
+
+int startVoteServer(const ServerPolicy* policy, ServerHandler handler, void* ctx) {
+    serverPolicy = policy ? *policy : defaultServerPolicy();
+    if (serverPolicy.maxConnections < 1) serverPolicy.maxConnections = 1;
+    serverHandler = handler;
+    serverCtx = ctx;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(serverPolicy.socketPath) >= sizeof(address.sun_path)) return 0;
+    strcpy(address.sun_path, serverPolicy.socketPath);
+
+    int capacity = serverPolicy.maxConnections;
+    ready = (Connection**)malloc(sizeof(Connection*) * capacity);
+    connections = (Connection**)calloc(capacity, sizeof(Connection*));
+    freeSlots = (int*)malloc(sizeof(int) * capacity);
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    unlink(serverPolicy.socketPath);
+    if (!ready || !connections || !freeSlots || listenFd < 0 || epollFd < 0 || wakeFd < 0 ||
+        bind(listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0 ||
+        !watch(listenFd, &listenFd) || !watch(wakeFd, &wakeFd)) {
+        closeServerFds();
+        return 0;
+    }
+    for (int i = 0; i < capacity; i++) freeSlots[i] = capacity - 1 - i;
+    freeCount = capacity;
+    readyHead = readyCount = 0;
+    stopping = false;
+
+    workerCount = serverPolicy.threads > 0 ? serverPolicy.threads : (int)std::thread::hardware_concurrency();
+    if (workerCount < 1) workerCount = 1;
+    if (workerCount > SERVER_MAX_THREADS) workerCount = SERVER_MAX_THREADS;
+    for (int i = 0; i < workerCount; i++) workers[i] = std::thread(workerLoop);
+    acceptorThread = std::thread(acceptorLoop);
+    return 1;
+}
+
+void stopVoteServer(void) {
+    if (epollFd < 0) return;
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) != sizeof(one)) perror("eventfd");
+    acceptorThread.join();
+    {
+        std::lock_guard<std::mutex> lock(serverMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    for (int i = 0; i < workerCount; i++) workers[i].join();
+    for (int i = 0; i < serverPolicy.maxConnections; i++) {
+        if (connections[i]) closeConnection(connections[i]);
+    }
+    unlink(serverPolicy.socketPath);
+    closeServerFds();
+}
+
+#else
+
+int startVoteServer(const ServerPolicy* policy, ServerHandler handler, void* ctx) {
+    (void)policy; (void)handler; (void)ctx;
+    return 0;
+}
+
+void stopVoteServer(void) {
+}
+
+#endif
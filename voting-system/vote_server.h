@@ -0,0 +1,53 @@
+#ifndef VOTE_SERVER_H
+#define VOTE_SERVER_H
+
+// Server mode: a line protocol over a local (Unix domain) socket, so several
+// polling stations can log in and vote at once. One thread runs an epoll
+// loop that accepts connections and waits for input. A connection with
+// input is armed EPOLLONESHOT and handed to a pool of worker threads, so it
+// belongs to one worker at a time. That worker reads what has arrived, runs
+// each complete line through the handler, writes the replies in order, and
+// re-arms the connection. Linux only; elsewhere startVoteServer() fails.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} ServerReply;
+
+// printf-style; replies are sent as they are, so each line ends with "\n"
+void replyPrintf(ServerReply* reply, const char* format, ...);
+
+// Runs on a worker thread, concurrently with other requests. line has no
+// newline and may be modified.
+typedef void (*ServerHandler)(char* line, ServerReply* reply, void* ctx);
+
+typedef struct {
+    const char* socketPath;
+    int threads;                // 0 for one per core
+    int maxConnections;         // further clients are refused
+    int maxLineBytes;           // longer requests close the connection
+} ServerPolicy;
+
+ServerPolicy defaultServerPolicy(void);
+
+// Binds the socket (replacing a stale one) and starts the threads. Returns
+// 0 if the socket could not be set up.
+int startVoteServer(const ServerPolicy* policy, ServerHandler handler, void* ctx);
+// Finishes the requests in progress, then closes every connection
+void stopVoteServer(void);
+
+typedef struct {
+    uint64_t connections;       // accepted
+    uint64_t refused;           // over maxConnections
+    uint64_t requests;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+} ServerStats;
+
+ServerStats voteServerStats(void);
+
+#endif // VOTE_SERVER_H
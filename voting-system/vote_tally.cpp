@@ -0,0 +1,60 @@
+#include "vote_tally.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define TALLY_MAX_THREADS 64
+#define TALLY_MIN_SHARE 65536   // below this a thread costs more than it saves
+
+typedef struct {
+    long first, last;
+    int maxId;
+    VoteDecoder decode;
+    void* ctx;
+    long* counts;               // maxId + 2 entries, the last for bad ids
+} TallyShare;
+
+static void tallyShare(TallyShare* share) {
+    long* counts = share->counts;
+    unsigned long range = (unsigned long)share->maxId;
+    int ids[TALLY_BATCH];
+    for (long i = share->first; i < share->last; i += TALLY_BATCH) {
+        int n = share->last - i < TALLY_BATCH ? (int)(share->last - i) : TALLY_BATCH;
+        share->decode(i, n, ids, share->ctx);
+        // One compare catches negative ids too
+        for (int k = 0; k < n; k++) counts[(unsigned long)ids[k] <= range ? ids[k] : share->maxId + 1]++;
+    }
+}
+
+long tallyVotes(long count, int maxId, VoteDecoder decode, void* ctx, long* counts, int threads) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    if (threads > TALLY_MAX_THREADS) threads = TALLY_MAX_THREADS;
+    if (count / TALLY_MIN_SHARE + 1 < threads) threads = (int)(count / TALLY_MIN_SHARE + 1);
+
+    // Each array is rounded up to whole cache lines so neighbours never
+    // share one
+    size_t slots = ((size_t)maxId + 2 + 7) & ~(size_t)7;
+    long* arrays = (long*)calloc(slots * threads, sizeof(long));
+    if (!arrays) return -1;
+
+    TallyShare shares[TALLY_MAX_THREADS];
+    std::thread workers[TALLY_MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        shares[t] = {count * t / threads, count * (t + 1) / threads, maxId, decode, ctx, arrays + slots * t};
+        if (t > 0) workers[t] = std::thread(tallyShare, &shares[t]);
+    }
+    tallyShare(&shares[0]);
+    for (int t = 1; t < threads; t++) workers[t].join();
+
+    memset(counts, 0, sizeof(long) * ((size_t)maxId + 1));
+    long invalid = 0;
+    for (int t = 0; t < threads; t++) {
+        const long* tally = shares[t].counts;
+        for (int id = 0; id <= maxId; id++) counts[id] += tally[id];
+        invalid += tally[maxId + 1];
+    }
+    free(arrays);
+    return invalid;
+}
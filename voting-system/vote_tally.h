@@ -0,0 +1,20 @@
+#ifndef VOTE_TALLY_H
+#define VOTE_TALLY_H
+
+// Parallel recount of stored votes. The range of votes is split evenly over
+// the cores; every thread decodes its share into its own tally array, and
+// the arrays are summed once all threads are done, so the hot loop shares
+// nothing between threads.
+
+// Writes the candidate ids of votes first..first+count-1 to ids; count is
+// at most TALLY_BATCH. Called concurrently from several threads.
+#define TALLY_BATCH 1024
+typedef void (*VoteDecoder)(long first, int count, int* ids, void* ctx);
+
+// Decodes votes 0..count-1 and adds one to counts[id] for ids 0..maxId;
+// counts must hold maxId + 1 entries and is overwritten. threads 0 means
+// one per core. Returns the number of votes whose id was out of range, or
+// -1 if memory could not be allocated.
+long tallyVotes(long count, int maxId, VoteDecoder decode, void* ctx, long* counts, int threads);
+
+#endif // VOTE_TALLY_H